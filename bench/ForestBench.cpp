@@ -0,0 +1,158 @@
+//ForestBench.cpp
+// Forest build scaling (no GL). For each thread count, builds the same stand twice:
+//   pool    one ThreadPool task per tree, each a plain BuildTreeVertices (its own grammar,
+//           fresh vectors), then gathered into one array: what callers did before Forest.h
+//   forest  BuildForest: biggest-first dynamic scheduling, shared grammars / templates,
+//           per-worker arenas
+// and reports wall time, trees/s, speedup and parallel efficiency against its own
+// single-thread run, heap allocations, and how evenly the workers were loaded.
+//
+// Usage: forest-bench [-n trees] [-i iterations] [-t 1,2,4,...] [-p mixed|deciduous|conifer] [-r reps]
+//   defaults: -n 48 -i 8 -t 1,2,4,...,all cores -p mixed -r 2 (best of reps)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Forest.h"
+#include "Stats.h"
+#include "ThreadPool.h"
+#include "TreeGen.h"
+
+static_assert(kAllocStats, "forest-bench needs LSYS_ALLOC_STATS=1 (set by its CMake target)");
+static_assert(kStats, "forest-bench times builds as the tools run them, timers in: build it without LSYS_STATS=0");
+
+struct Run {
+    double ms = 1e30;
+    std::size_t vertices = 0;
+    std::int64_t allocs = 0;
+    double balance = 0.0; // busiest worker's summed tree times / BuildForest wall time (forest only)
+};
+
+static Run BestOf(int reps, const std::function<Run()>& fn)
+{
+    Run best;
+    for (int r = 0; r < reps; ++r) {
+        const std::int64_t a0 = ProcessAllocCounters().count;
+        Run run = fn();
+        run.allocs = ProcessAllocCounters().count - a0;
+        if (run.ms < best.ms) best = run;
+    }
+    return best;
+}
+
+static Run PoolBuild(const std::vector<TreePlacement>& placements, int iterations, unsigned threads)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    ThreadPool pool(threads);
+    std::vector<std::future<std::vector<VertexPN>>> trees;
+    for (const TreePlacement& place : placements) {
+        trees.push_back(pool.submit([&place, iterations]() {
+            TreeParams p;
+            p.preset = place.preset;
+            ApplyTreePreset(p);
+            if (iterations > 0) p.iterations = iterations;
+            p.seed = place.seed;
+            return BuildTreeVertices(p);
+        }));
+    }
+
+    std::vector<VertexPN> all;
+    for (auto& f : trees) {
+        const std::vector<VertexPN> v = f.get();
+        all.insert(all.end(), v.begin(), v.end());
+    }
+
+    Run r;
+    r.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    r.vertices = all.size();
+    return r;
+}
+
+static Run ForestBuild(const std::vector<TreePlacement>& placements, int iterations, unsigned threads)
+{
+    ForestSettings settings;
+    settings.iterations = iterations;
+    settings.threads = threads;
+    const ForestMesh forest = BuildForest(placements, settings);
+
+    std::vector<double> busy(forest.threads, 0.0);
+    for (const ForestTree& t : forest.trees) busy[t.worker] += t.buildMs;
+
+    Run r;
+    r.ms = forest.buildMs;
+    r.vertices = forest.vertexCount();
+    r.balance = *std::max_element(busy.begin(), busy.end()) / forest.buildMs;
+    return r;
+}
+
+int main(int argc, char** argv)
+{
+    int trees = 48, iterations = 8, reps = 2;
+    std::string presets = "mixed";
+    std::vector<unsigned> threadCounts;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "-n" && hasValue) trees = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "-i" && hasValue) iterations = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "-r" && hasValue) reps = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "-p" && hasValue) presets = argv[++i];
+        else if (arg == "-t" && hasValue) {
+            std::stringstream ss(argv[++i]);
+            std::string item;
+            while (std::getline(ss, item, ',')) {
+                if (!item.empty()) threadCounts.push_back((unsigned)std::max(1, std::atoi(item.c_str())));
+            }
+        }
+        else {
+            std::printf("Usage: forest-bench [-n trees] [-i iterations] [-t 1,2,4,...] [-p mixed|deciduous|conifer] [-r reps]\n");
+            return (arg == "-h" || arg == "--help") ? 0 : 2;
+        }
+    }
+
+    const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    if (threadCounts.empty()) {
+        for (unsigned t = 1; t < hw; t *= 2) threadCounts.push_back(t);
+        threadCounts.push_back(hw);
+    }
+
+    // A fixed stand: presets alternate for "mixed" (the uneven case scheduling is for)
+    std::vector<TreePlacement> placements = ScatterForest(trees, TreePreset::Deciduous, 5.0f, 60.0f, 3.0f, 2025);
+    for (std::size_t i = 0; i < placements.size(); ++i) {
+        if (presets == "conifer" || (presets == "mixed" && i % 2 == 1)) placements[i].preset = TreePreset::Conifer;
+    }
+
+    std::printf("forest-bench: %d trees (%s), %d iterations, %u hardware threads, best of %d\n\n",
+        trees, presets.c_str(), iterations, hw, reps);
+    std::printf("%-8s %7s %10s %9s %8s %6s %12s %8s\n",
+        "mode", "threads", "ms", "trees/s", "speedup", "eff", "allocs", "balance");
+
+    double poolBase = 0.0, forestBase = 0.0;
+    for (unsigned t : threadCounts) {
+        const Run pool = BestOf(reps, [&]() { return PoolBuild(placements, iterations, t); });
+        const Run forest = BestOf(reps, [&]() { return ForestBuild(placements, iterations, t); });
+        if (poolBase == 0.0) poolBase = pool.ms;
+        if (forestBase == 0.0) forestBase = forest.ms;
+        if (pool.vertices != forest.vertices) {
+            std::fprintf(stderr, "Vertex counts differ: pool %zu, forest %zu\n", pool.vertices, forest.vertices);
+            return 1;
+        }
+
+        std::printf("%-8s %7u %10.1f %9.1f %7.2fx %5.0f%% %12lld %8s\n", "pool", t, pool.ms,
+            trees * 1000.0 / pool.ms, poolBase / pool.ms, 100.0 * poolBase / pool.ms / t, (long long)pool.allocs, "-");
+        std::printf("%-8s %7u %10.1f %9.1f %7.2fx %5.0f%% %12lld %7.0f%%\n", "forest", t, forest.ms,
+            trees * 1000.0 / forest.ms, forestBase / forest.ms, 100.0 * forestBase / forest.ms / t,
+            (long long)forest.allocs, 100.0 * forest.balance);
+    }
+    std::printf("\nspeedup / eff: against the same mode on the first thread count; balance: busiest worker's share of the wall time\n");
+    return 0;
+}
@@ -0,0 +1,214 @@
+//GenBench.cpp
+// Generation pipeline benchmark (no GL): L-system rewriting, turtle interpretation / tree mesh,
+// and the hill mesh. Reports throughput, heap allocations and peak live heap per stage, as a
+// table and as JSON so runs can be compared over time. Built with LSYS_ALLOC_STATS=1, so the
+// counting operator new is the one in Stats.cpp and the tree's phases carry their own numbers.
+//
+// Usage: gen-bench [-i iters,...] [-s seeds,...] [--hill gridN,...] [-r reps] [-o out.json]
+//   defaults: -i 8,10,12 -s 2025,7,12345 --hill 240,1024 -r 3 -o gen-bench.json
+//   Both presets run every (iterations, seed) pair; times are the best of `reps` runs.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Hill.h"
+#include "LSystem.h"
+#include "Stats.h"
+#include "TreeGen.h"
+
+static_assert(kAllocStats, "gen-bench needs LSYS_ALLOC_STATS=1 (set by its CMake target)");
+static_assert(kStats, "gen-bench reports phase times: build it without LSYS_STATS=0");
+
+struct Sample {
+    double ms = 0.0;        // best of reps
+    AllocCounters allocs;   // of the last rep (runs are deterministic); peak is above the starting level
+};
+
+static Sample Measure(int reps, const std::function<void()>& fn)
+{
+    Sample s;
+    s.ms = 1e30;
+    for (int r = 0; r < reps; ++r) {
+        ResetProcessAllocPeak();
+        const AllocCounters a0 = ProcessAllocCounters();
+        auto t0 = std::chrono::steady_clock::now();
+        fn();
+        s.ms = std::min(s.ms, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+        const AllocCounters a1 = ProcessAllocCounters();
+        s.allocs = { a1.count - a0.count, a1.bytes - a0.bytes, a1.live - a0.live, a1.peak - a0.live };
+    }
+    return s;
+}
+
+static double KB(std::int64_t bytes) { return double(bytes) / 1024.0; }
+
+// "stage": {"allocs": .., "alloc_bytes": .., "peak_bytes": ..}
+static void WriteAllocs(std::ostream& os, const char* stage, const AllocCounters& a)
+{
+    os << "\"" << stage << "\": {\"allocs\": " << a.count << ", \"alloc_bytes\": " << a.bytes
+        << ", \"peak_bytes\": " << a.peak << "}";
+}
+
+static std::vector<long> ParseList(const std::string& s)
+{
+    std::vector<long> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) out.push_back(std::atol(item.c_str()));
+    }
+    return out;
+}
+
+static double PerSec(double count, double ms) { return ms > 0.0 ? count / (ms * 1e-3) : 0.0; }
+
+int main(int argc, char** argv)
+{
+    std::vector<long> iterations = { 8, 10, 12 };
+    std::vector<long> seeds = { 2025, 7, 12345 };
+    std::vector<long> hillGrids = { 240, 1024 };
+    int reps = 3;
+    std::string outPath = "gen-bench.json";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-i" && i + 1 < argc) iterations = ParseList(argv[++i]);
+        else if (arg == "-s" && i + 1 < argc) seeds = ParseList(argv[++i]);
+        else if (arg == "--hill" && i + 1 < argc) hillGrids = ParseList(argv[++i]);
+        else if (arg == "-r" && i + 1 < argc) reps = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "-o" && i + 1 < argc) outPath = argv[++i];
+        else {
+            std::printf("Usage: gen-bench [-i iters,...] [-s seeds,...] [--hill gridN,...] [-r reps] [-o out.json]\n");
+            return (arg == "-h" || arg == "--help") ? 0 : 1;
+        }
+    }
+
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("gen-bench: %u hardware threads, best of %d\n\n", cores, reps);
+
+    std::ostringstream json;
+    json << "{\n  \"benchmark\": \"gen-bench\",\n"
+        << "  \"timestamp\": " << (long long)std::time(nullptr) << ",\n"
+        << "  \"hardware_threads\": " << cores << ",\n"
+        << "  \"reps\": " << reps << ",\n"
+#ifdef NDEBUG
+        << "  \"build\": \"release\",\n"
+#else
+        << "  \"build\": \"debug\",\n"
+#endif
+        << "  \"tree\": [";
+
+    // ---------------------------
+    // Tree: rewriting alone, then the whole build (rewrite + interpretation)
+    // ---------------------------
+    // allocs / peak are for the whole build; the per-stage split (rewrite / turtle / mesh) is in the JSON
+    std::printf("%-9s %4s %6s %10s %9s %11s %9s %11s %11s %10s %11s\n", "preset", "iter", "seed",
+        "symbols", "rewrite", "symbols/s", "build", "segments/s", "vertices/s", "allocs", "peak");
+
+    bool first = true;
+    for (TreePreset preset : { TreePreset::Deciduous, TreePreset::Conifer }) {
+        const char* presetName = (preset == TreePreset::Deciduous) ? "deciduous" : "conifer";
+        for (long it : iterations) {
+            for (long seed : seeds) {
+                TreeParams p;
+                p.preset = preset;
+                ApplyTreePreset(p);
+                p.iterations = (int)it;
+                p.seed = (std::uint32_t)seed;
+
+                // Rewriting as builds do it: the precompiled preset grammar into a reused arena
+                // (its buffers are warm after the first rep, like a pool worker's)
+                const LGrammar& grammar = PresetGrammar(p.preset);
+                TreeBuildArena arena;
+                std::size_t symbols = 0;
+                Sample rewrite = Measure(reps, [&]() {
+                    std::mt19937 rng(p.seed);
+                    grammar.generate(p.iterations, rng, arena.sentence, arena.rewrite);
+                    symbols = arena.sentence.size();
+                });
+
+                TreeBuildInfo info;
+                double interpretMs = 1e30;
+                Sample build = Measure(reps, [&]() {
+                    std::vector<VertexPN> v = BuildTreeVertices(p, &info);
+                    interpretMs = std::min(interpretMs, info.interpretMs);
+                });
+
+                std::printf("%-9s %4ld %6ld %10zu %7.2fms %11.3g %7.2fms %11.3g %11.3g %10llu %8.0f KB\n",
+                    presetName, it, seed, symbols, rewrite.ms, PerSec(double(symbols), rewrite.ms),
+                    build.ms, PerSec(double(info.segments), interpretMs), PerSec(double(info.vertices), build.ms),
+                    (unsigned long long)build.allocs.count, KB(build.allocs.peak));
+
+                json << (first ? "\n" : ",\n")
+                    << "    {\"preset\": \"" << presetName << "\", \"iterations\": " << it << ", \"seed\": " << seed
+                    << ", \"symbols\": " << symbols << ", \"segments\": " << info.segments
+                    << ", \"spheres\": " << info.spheres << ", \"vertices\": " << info.vertices
+                    << ",\n     \"rewrite_ms\": " << rewrite.ms << ", \"rewrite_allocs\": " << rewrite.allocs.count
+                    << ", \"rewrite_alloc_bytes\": " << rewrite.allocs.bytes
+                    << ", \"rewrite_peak_bytes\": " << rewrite.allocs.peak
+                    << ",\n     \"build_ms\": " << build.ms << ", \"interpret_ms\": " << interpretMs
+                    << ", \"build_allocs\": " << build.allocs.count << ", \"build_alloc_bytes\": " << build.allocs.bytes
+                    << ", \"build_peak_bytes\": " << build.allocs.peak << ",\n     ";
+                WriteAllocs(json, "rewrite_stage", info.rewriteAllocs);
+                json << ", ";
+                WriteAllocs(json, "turtle_stage", info.turtleAllocs);
+                json << ", ";
+                WriteAllocs(json, "mesh_stage", info.meshAllocs);
+                json << ",\n     \"symbols_per_s\": " << PerSec(double(symbols), rewrite.ms)
+                    << ", \"segments_per_s\": " << PerSec(double(info.segments), interpretMs)
+                    << ", \"vertices_per_s\": " << PerSec(double(info.vertices), build.ms) << "}";
+                first = false;
+            }
+        }
+    }
+    json << "\n  ],\n  \"hill\": [";
+
+    // ---------------------------
+    // Hill mesh (same parameters main.cpp uses), single-threaded and all cores
+    // ---------------------------
+    std::printf("\n%6s %8s %10s %9s %11s %10s %11s\n", "gridN", "threads", "vertices", "mesh", "vertices/s", "allocs", "peak");
+
+    first = true;
+    for (long N : hillGrids) {
+        for (unsigned threads : { 1u, 0u }) {
+            std::size_t verts = 0;
+            Sample mesh = Measure(reps, [&]() {
+                verts = BuildHillMesh(-0.20f, 100.0f, (int)std::max(4L, N), 14.0f, 14.0f, HillKernel::Simd, threads)
+                    .vertices.size();
+            });
+
+            const unsigned shown = threads ? threads : cores;
+            std::printf("%6ld %8u %10zu %7.2fms %11.3g %10llu %8.0f KB\n", N, shown, verts, mesh.ms,
+                PerSec(double(verts), mesh.ms), (unsigned long long)mesh.allocs.count, KB(mesh.allocs.peak));
+
+            json << (first ? "\n" : ",\n")
+                << "    {\"grid\": " << N << ", \"threads\": " << shown << ", \"vertices\": " << verts
+                << ", \"ms\": " << mesh.ms << ", \"allocs\": " << mesh.allocs.count
+                << ", \"alloc_bytes\": " << mesh.allocs.bytes << ", \"peak_bytes\": " << mesh.allocs.peak
+                << ", \"vertices_per_s\": " << PerSec(double(verts), mesh.ms) << "}";
+            first = false;
+        }
+    }
+    json << "\n  ]\n}\n";
+
+    if (FILE* f = std::fopen(outPath.c_str(), "wb")) {
+        const std::string s = json.str();
+        std::fwrite(s.data(), 1, s.size(), f);
+        std::fclose(f);
+        std::printf("\nWrote %s\n", outPath.c_str());
+    }
+    else {
+        std::fprintf(stderr, "Cannot write %s\n", outPath.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+//HillBench.cpp
+// Hill generation microbenchmark: scalar reference loops vs SIMD kernels, 1 thread vs all.
+//
+// Usage: hill-bench [gridN ...] [-r reps]
+//   defaults: 240 1024 2048, 5 reps (best time is reported)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Hill.h"
+
+static double BestMs(int reps, const std::function<void()>& fn)
+{
+    double best = 1e30;
+    for (int r = 0; r < reps; ++r) {
+        auto t0 = std::chrono::steady_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+    }
+    return best;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<int> grids;
+    int reps = 5;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-r" && i + 1 < argc) reps = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "-h" || arg == "--help") {
+            std::printf("Usage: hill-bench [gridN ...] [-r reps]\n");
+            return 0;
+        }
+        else grids.push_back(std::max(4, std::atoi(arg.c_str())));
+    }
+    if (grids.empty()) grids = { 240, 1024, 2048 };
+
+    // Same parameters main.cpp uses for the deciduous hill
+    const float baseY = -0.20f, halfSize = 100.0f, uvU = 14.0f, uvV = 14.0f;
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+
+    std::printf("hill-bench: %u hardware threads, best of %d\n\n", cores, reps);
+    std::printf("%6s  %-22s %10s %10s %9s\n", "gridN", "variant", "heights", "mesh", "speedup");
+
+    for (int N : grids) {
+        struct Variant { const char* name; HillKernel kernel; unsigned threads; };
+        const Variant variants[] = {
+            { "scalar, 1 thread", HillKernel::Scalar, 1 },
+            { "simd,   1 thread", HillKernel::Simd, 1 },
+            { "scalar, all threads", HillKernel::Scalar, 0 },
+            { "simd,   all threads", HillKernel::Simd, 0 },
+        };
+
+        double baseMesh = 0.0;
+        for (const Variant& v : variants) {
+            double hMs = BestMs(reps, [&]() { BuildHillHeights(baseY, halfSize, N, v.kernel, v.threads); });
+            double mMs = BestMs(reps, [&]() { BuildHillMesh(baseY, halfSize, N, uvU, uvV, v.kernel, v.threads); });
+            if (baseMesh == 0.0) baseMesh = mMs;
+
+            std::printf("%6d  %-22s %8.2fms %8.2fms %8.2fx\n", N, v.name, hMs, mMs, baseMesh / mMs);
+        }
+
+        // Accuracy of the SIMD path against the scalar reference
+        HillMesh ref = BuildHillMesh(baseY, halfSize, N, uvU, uvV, HillKernel::Scalar, 1);
+        HillMesh fast = BuildHillMesh(baseY, halfSize, N, uvU, uvV, HillKernel::Simd, 0);
+
+        float maxH = 0.0f, maxN = 0.0f, maxT = 0.0f;
+        int signMismatch = 0;
+        for (std::size_t k = 0; k < ref.vertices.size(); ++k) {
+            const VertexPN& a = ref.vertices[k];
+            const VertexPN& b = fast.vertices[k];
+            maxH = std::max(maxH, std::fabs(a.pos.y - b.pos.y));
+            for (int c = 0; c < 3; ++c) {
+                maxN = std::max(maxN, std::fabs(a.normal[c] - b.normal[c]));
+                maxT = std::max(maxT, std::fabs(a.tangent[c] - b.tangent[c]));
+            }
+            if (a.tangent.w != b.tangent.w) ++signMismatch;
+        }
+        std::printf("%6d  max |dh| %.2e  |dn| %.2e  |dt| %.2e  sign mismatches %d\n\n",
+            N, maxH, maxN, maxT, signMismatch);
+    }
+
+    return 0;
+}
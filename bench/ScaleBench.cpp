@@ -0,0 +1,368 @@
+//ScaleBench.cpp
+// Iteration scaling benchmark (no GL): runs both presets from -i 1 upward until a time or
+// memory ceiling, records per step sentence length, F count, vertices, rewrite /
+// interpretation / meshing time, per-stage heap allocations and peak live heap
+// (LSYS_ALLOC_STATS=1) and peak RSS, fits growth rates and optionally checks the run
+// against a stored baseline (a previous output file).
+//
+// Usage: scale-bench [-s seed] [--max-iter n] [--max-seconds s] [--max-rss-mb mb]
+//                    [-o out.json] [--baseline old.json] [--tolerance 0.25]
+//   defaults: seed 2025, up to -i 30, stop after a step over 10 s or 2048 MB (or one predicted
+//   to be), -o scale-bench.json, 25 % tolerance.
+//   Exit code: 0 ok, 1 regression against the baseline, 2 bad arguments / files.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "Stats.h"
+#include "TreeGen.h"
+
+static_assert(kAllocStats, "scale-bench needs LSYS_ALLOC_STATS=1 (set by its CMake target)");
+static_assert(kStats, "scale-bench reports phase times: build it without LSYS_STATS=0");
+
+// ---------------------------
+// Peak resident set size
+// Linux can reset the high-water mark (clear_refs "5"), so every step gets its own peak.
+// Elsewhere the peak only grows; since steps grow too, it is still the step's peak in practice.
+// ---------------------------
+static void ResetPeakRss()
+{
+#if defined(__linux__)
+    int fd = open("/proc/self/clear_refs", O_WRONLY);
+    if (fd >= 0) {
+        (void)!write(fd, "5", 1);
+        close(fd);
+    }
+#endif
+}
+
+static double PeakRssMB()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return double(pmc.PeakWorkingSetSize) / (1024.0 * 1024.0);
+    return 0.0;
+#elif defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) return std::atof(line.c_str() + 6) / 1024.0; // kB
+    }
+    return 0.0;
+#else
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    return double(ru.ru_maxrss) / (1024.0 * 1024.0); // bytes on macOS
+#endif
+}
+
+struct Step {
+    std::string preset;
+    int iterations = 0;
+    TreeBuildInfo info;
+    double totalMs = 0.0;
+    double peakRssMB = 0.0;
+};
+
+// Least squares fit of log(y) = a + b * i over the steps with y > 0; growth = e^b per iteration
+struct Growth {
+    double perIter = 0.0;
+    double r2 = 0.0;
+    int points = 0;
+};
+
+template <class Fn>
+static Growth FitGrowth(const std::vector<Step>& steps, Fn value, int minIter)
+{
+    std::vector<std::pair<double, double>> pts;
+    for (const Step& s : steps) {
+        const double y = value(s);
+        if (s.iterations >= minIter && y > 0.0) pts.push_back({ double(s.iterations), std::log(y) });
+    }
+
+    Growth g;
+    g.points = (int)pts.size();
+    if (pts.size() < 2) return g;
+
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (auto& p : pts) { sx += p.first; sy += p.second; sxx += p.first * p.first; sxy += p.first * p.second; }
+    const double n = double(pts.size());
+    const double den = n * sxx - sx * sx;
+    if (den == 0.0) return g;
+
+    const double b = (n * sxy - sx * sy) / den;
+    const double a = (sy - b * sx) / n;
+
+    double ssTot = 0, ssRes = 0;
+    for (auto& p : pts) {
+        const double e = p.second - (a + b * p.first);
+        ssRes += e * e;
+        ssTot += (p.second - sy / n) * (p.second - sy / n);
+    }
+    g.perIter = std::exp(b);
+    g.r2 = ssTot > 0.0 ? 1.0 - ssRes / ssTot : 1.0;
+    return g;
+}
+
+// ---------------------------
+// Output / baseline: one step object per line, so the reader below can stay a line scanner
+// ---------------------------
+static std::string StepJson(const Step& s)
+{
+    std::ostringstream os;
+    os << "{\"preset\": \"" << s.preset << "\", \"iterations\": " << s.iterations
+        << ", \"sentence_length\": " << s.info.sentenceLength << ", \"f_count\": " << s.info.forwardSymbols
+        << ", \"vertices\": " << s.info.vertices
+        << ", \"rewrite_ms\": " << s.info.rewriteMs << ", \"interpret_ms\": " << s.info.interpretMs
+        << ", \"mesh_ms\": " << s.info.meshMs << ", \"total_ms\": " << s.totalMs
+        << ", \"peak_rss_mb\": " << s.peakRssMB
+        << ", \"rewrite_allocs\": " << s.info.rewriteAllocs.count << ", \"rewrite_peak_bytes\": " << s.info.rewriteAllocs.peak
+        << ", \"turtle_allocs\": " << s.info.turtleAllocs.count << ", \"turtle_peak_bytes\": " << s.info.turtleAllocs.peak
+        << ", \"mesh_allocs\": " << s.info.meshAllocs.count << ", \"mesh_alloc_bytes\": " << s.info.meshAllocs.bytes
+        << "}";
+    return os.str();
+}
+
+static bool FindNumber(const std::string& line, const char* key, double& out)
+{
+    const std::string k = std::string("\"") + key + "\": ";
+    const std::size_t at = line.find(k);
+    if (at == std::string::npos) return false;
+    out = std::atof(line.c_str() + at + k.size());
+    return true;
+}
+
+static bool FindString(const std::string& line, const char* key, std::string& out)
+{
+    const std::string k = std::string("\"") + key + "\": \"";
+    const std::size_t at = line.find(k);
+    if (at == std::string::npos) return false;
+    const std::size_t end = line.find('"', at + k.size());
+    if (end == std::string::npos) return false;
+    out = line.substr(at + k.size(), end - at - k.size());
+    return true;
+}
+
+static bool LoadBaseline(const std::string& path, std::vector<Step>& out)
+{
+    std::ifstream in(path);
+    if (!in) return false;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        Step s;
+        double it = 0, len = 0, f = 0, verts = 0;
+        if (!FindString(line, "preset", s.preset) || !FindNumber(line, "iterations", it)) continue;
+        FindNumber(line, "sentence_length", len);
+        FindNumber(line, "f_count", f);
+        FindNumber(line, "vertices", verts);
+        FindNumber(line, "rewrite_ms", s.info.rewriteMs);
+        FindNumber(line, "interpret_ms", s.info.interpretMs);
+        FindNumber(line, "mesh_ms", s.info.meshMs);
+        FindNumber(line, "total_ms", s.totalMs);
+        FindNumber(line, "peak_rss_mb", s.peakRssMB);
+        s.iterations = (int)it;
+        s.info.sentenceLength = (std::size_t)len;
+        s.info.forwardSymbols = (std::size_t)f;
+        s.info.vertices = (std::size_t)verts;
+        out.push_back(s);
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    std::uint32_t seed = 2025;
+    int maxIter = 30;
+    double maxSeconds = 10.0;
+    double maxRssMB = 2048.0;
+    double tolerance = 0.25;
+    std::string outPath = "scale-bench.json";
+    std::string baselinePath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "-s" && hasValue) seed = (std::uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--max-iter" && hasValue) maxIter = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--max-seconds" && hasValue) maxSeconds = std::max(0.01, std::atof(argv[++i]));
+        else if (arg == "--max-rss-mb" && hasValue) maxRssMB = std::max(1.0, std::atof(argv[++i]));
+        else if (arg == "--tolerance" && hasValue) tolerance = std::max(0.0, std::atof(argv[++i]));
+        else if (arg == "-o" && hasValue) outPath = argv[++i];
+        else if (arg == "--baseline" && hasValue) baselinePath = argv[++i];
+        else {
+            std::printf("Usage: scale-bench [-s seed] [--max-iter n] [--max-seconds s] [--max-rss-mb mb]\n"
+                "                   [-o out.json] [--baseline old.json] [--tolerance 0.25]\n");
+            return (arg == "-h" || arg == "--help") ? 0 : 2;
+        }
+    }
+
+    std::vector<Step> baseline;
+    if (!baselinePath.empty() && !LoadBaseline(baselinePath, baseline)) {
+        std::fprintf(stderr, "Cannot read baseline %s\n", baselinePath.c_str());
+        return 2;
+    }
+
+    std::printf("scale-bench: seed %u, ceilings %.1f s / %.0f MB per step\n", seed, maxSeconds, maxRssMB);
+
+    std::vector<Step> steps;
+    std::vector<std::string> stopReasons;
+
+    for (TreePreset preset : { TreePreset::Deciduous, TreePreset::Conifer }) {
+        const char* presetName = (preset == TreePreset::Deciduous) ? "deciduous" : "conifer";
+        std::printf("\n%-9s %4s %12s %11s %11s %9s %10s %9s %9s %9s %9s %10s\n", presetName, "iter", "sentence", "F",
+            "vertices", "rewrite", "interpret", "mesh", "total", "peak RSS", "peak heap", "allocs");
+
+        std::string reason = "reached --max-iter";
+        const std::size_t first = steps.size();
+        for (int it = 1; it <= maxIter; ++it) {
+            TreeParams p;
+            p.preset = preset;
+            ApplyTreePreset(p);
+            p.iterations = it;
+            p.seed = seed;
+
+            Step s;
+            s.preset = presetName;
+            s.iterations = it;
+
+            ResetPeakRss();
+            auto t0 = std::chrono::steady_clock::now();
+            try {
+                std::vector<VertexPN> v = BuildTreeVertices(p, &s.info);
+            }
+            catch (const std::bad_alloc&) {
+                // the innermost phase the throw unwound is the stage that ran out
+                reason = "out of memory at -i " + std::to_string(it);
+                if (s.info.stats.failedPhase)
+                    reason += std::string(" (in ") + s.info.stats.failedPhase + ")";
+                break;
+            }
+            s.totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            s.peakRssMB = PeakRssMB();
+            steps.push_back(s);
+
+            const std::int64_t peakHeap = std::max(s.info.rewriteAllocs.peak, s.info.turtleAllocs.peak);
+            const std::uint64_t allocs = s.info.rewriteAllocs.count + s.info.turtleAllocs.count + s.info.meshAllocs.count;
+            std::printf("%-9s %4d %12zu %11zu %11zu %7.1fms %8.1fms %7.1fms %7.1fms %7.1fMB %7.1fMB %10llu\n", "", it,
+                s.info.sentenceLength, s.info.forwardSymbols, s.info.vertices, s.info.rewriteMs,
+                s.info.interpretMs, s.info.meshMs, s.totalMs, s.peakRssMB,
+                double(peakHeap) / (1024.0 * 1024.0), (unsigned long long)allocs);
+
+            if (s.totalMs > maxSeconds * 1000.0) { reason = "time ceiling at -i " + std::to_string(it); break; }
+            if (s.peakRssMB > maxRssMB) { reason = "memory ceiling at -i " + std::to_string(it); break; }
+
+            // Don't start a step that the last ratio says will blow a ceiling (it could take minutes or OOM)
+            if (steps.size() - first >= 2) {
+                const Step& prev = steps[steps.size() - 2];
+                const double timeRatio = prev.totalMs > 1.0 ? s.totalMs / prev.totalMs : 1.0;
+                const double vertRatio = prev.info.vertices ? double(s.info.vertices) / double(prev.info.vertices) : 1.0;
+                if (s.totalMs * timeRatio > maxSeconds * 1000.0) {
+                    reason = "-i " + std::to_string(it + 1) + " predicted over the time ceiling";
+                    break;
+                }
+                if (s.peakRssMB * std::max(1.0, vertRatio) > maxRssMB) {
+                    reason = "-i " + std::to_string(it + 1) + " predicted over the memory ceiling";
+                    break;
+                }
+            }
+        }
+        stopReasons.push_back(std::string(presetName) + ": " + reason);
+        std::printf("  stopped: %s\n", reason.c_str());
+    }
+
+    // ---------------------------
+    // Growth per iteration (fitted from -i 4 on, the first steps are dominated by constants)
+    // ---------------------------
+    std::ostringstream growthJson;
+    std::printf("\nGrowth per iteration (fit from -i 4, R^2 in brackets)\n");
+    for (const char* presetName : { "deciduous", "conifer" }) {
+        std::vector<Step> ps;
+        for (const Step& s : steps) if (s.preset == presetName) ps.push_back(s);
+
+        const Growth sentence = FitGrowth(ps, [](const Step& s) { return double(s.info.sentenceLength); }, 4);
+        const Growth verts = FitGrowth(ps, [](const Step& s) { return double(s.info.vertices); }, 4);
+        const Growth time = FitGrowth(ps, [](const Step& s) { return s.totalMs; }, 4);
+        const Growth rss = FitGrowth(ps, [](const Step& s) { return s.peakRssMB; }, 4);
+
+        std::printf("  %-9s sentence x%.3f (%.3f)  vertices x%.3f (%.3f)  time x%.3f (%.3f)  peak RSS x%.3f (%.3f)\n",
+            presetName, sentence.perIter, sentence.r2, verts.perIter, verts.r2, time.perIter, time.r2,
+            rss.perIter, rss.r2);
+
+        growthJson << (growthJson.tellp() > 0 ? ",\n" : "\n")
+            << "    {\"preset\": \"" << presetName << "\", \"sentence_per_iter\": " << sentence.perIter
+            << ", \"vertices_per_iter\": " << verts.perIter << ", \"time_per_iter\": " << time.perIter
+            << ", \"rss_per_iter\": " << rss.perIter << "}";
+    }
+
+    // ---------------------------
+    // Baseline comparison: outputs must match exactly (same seed -> same tree), time and
+    // memory may grow by `tolerance`. Steps under 5 ms / 16 MB are too noisy to judge.
+    // ---------------------------
+    int regressions = 0;
+    if (!baseline.empty()) {
+        std::printf("\nAgainst baseline %s (tolerance %.0f%%)\n", baselinePath.c_str(), tolerance * 100.0);
+        for (const Step& s : steps) {
+            auto it = std::find_if(baseline.begin(), baseline.end(), [&](const Step& b) {
+                return b.preset == s.preset && b.iterations == s.iterations;
+            });
+            if (it == baseline.end()) continue;
+
+            const Step& b = *it;
+            if (b.info.sentenceLength != s.info.sentenceLength || b.info.vertices != s.info.vertices) {
+                std::printf("  %-9s -i %-2d output changed: sentence %zu -> %zu, vertices %zu -> %zu\n",
+                    s.preset.c_str(), s.iterations, b.info.sentenceLength, s.info.sentenceLength,
+                    b.info.vertices, s.info.vertices);
+                ++regressions;
+            }
+            if (b.totalMs >= 5.0 && s.totalMs > b.totalMs * (1.0 + tolerance)) {
+                std::printf("  %-9s -i %-2d slower: %.1f ms -> %.1f ms (+%.0f%%)\n", s.preset.c_str(), s.iterations,
+                    b.totalMs, s.totalMs, (s.totalMs / b.totalMs - 1.0) * 100.0);
+                ++regressions;
+            }
+            if (b.peakRssMB >= 16.0 && s.peakRssMB > b.peakRssMB * (1.0 + tolerance)) {
+                std::printf("  %-9s -i %-2d more memory: %.1f MB -> %.1f MB (+%.0f%%)\n", s.preset.c_str(),
+                    s.iterations, b.peakRssMB, s.peakRssMB, (s.peakRssMB / b.peakRssMB - 1.0) * 100.0);
+                ++regressions;
+            }
+        }
+        std::printf(regressions ? "  %d regression(s)\n" : "  no regressions\n", regressions);
+    }
+
+    std::ofstream out(outPath);
+    if (!out) {
+        std::fprintf(stderr, "Cannot write %s\n", outPath.c_str());
+        return 2;
+    }
+    out << "{\n  \"benchmark\": \"scale-bench\",\n  \"timestamp\": " << (long long)std::time(nullptr)
+        << ",\n  \"seed\": " << seed << ",\n  \"stopped\": [";
+    for (std::size_t k = 0; k < stopReasons.size(); ++k) out << (k ? ", " : "") << "\"" << stopReasons[k] << "\"";
+    out << "],\n  \"growth\": [" << growthJson.str() << "\n  ],\n  \"steps\": [\n";
+    for (std::size_t k = 0; k < steps.size(); ++k)
+        out << "    " << StepJson(steps[k]) << (k + 1 < steps.size() ? ",\n" : "\n");
+    out << "  ]\n}\n";
+    std::printf("\nWrote %s\n", outPath.c_str());
+
+    return regressions ? 1 : 0;
+}
@@ -0,0 +1,512 @@
+//EnvMap.cpp
+#include "EnvMap.h"
+#include "TextureCache.h"
+#include "Textures.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <system_error>
+
+#include <stb_image.h>
+
+namespace fs = std::filesystem;
+
+static const char kEnvCubeMagic[8] = { 'L', 'E', 'N', 'V', 'C', 'U', 'B', 'E' };
+static const char kEnvSHMagic[8] = { 'L', 'E', 'N', 'V', 'S', 'H', '9', '\0' };
+
+// ---------------------------
+// Equirect source
+// ---------------------------
+static fs::path PickEquirectSource(const fs::path& src)
+{
+    fs::path hdrPath = src;
+    hdrPath.replace_extension(".hdr");
+
+    std::error_code ec;
+    if (hdrPath != src && fs::exists(hdrPath, ec)) return hdrPath;
+    return src;
+}
+
+EquirectImage LoadEquirect(const fs::path& src, fs::path* usedPath)
+{
+    const fs::path path = PickEquirectSource(src);
+    if (usedPath) *usedPath = path;
+
+    EquirectImage img;
+
+    if (path.extension() == ".hdr") {
+        int comp = 0;
+        float* px = stbi_loadf(path.string().c_str(), &img.w, &img.h, &comp, 3);
+        if (!px) {
+            std::cerr << "Failed to load HDR: " << path << "\n";
+            img.w = img.h = 0;
+            return img;
+        }
+        img.rgb.assign(px, px + (std::size_t)img.w * img.h * 3);
+        stbi_image_free(px);
+        img.hdr = true;
+        return img;
+    }
+
+    // 8-bit fallback: decode as usual and linearize (same result the sRGB texture used to give)
+    DecodedImage ldr = DecodeImageRGBA8(path);
+    if (!ldr.pixels) return img;
+
+    img.w = ldr.w;
+    img.h = ldr.h;
+    img.rgb.resize((std::size_t)img.w * img.h * 3);
+
+    const float* toLinear = SrgbToLinearLUT();
+    const unsigned char* s = ldr.pixels.get();
+    for (std::size_t i = 0, n = (std::size_t)img.w * img.h; i < n; ++i) {
+        img.rgb[i * 3 + 0] = toLinear[s[i * 4 + 0]];
+        img.rgb[i * 3 + 1] = toLinear[s[i * 4 + 1]];
+        img.rgb[i * 3 + 2] = toLinear[s[i * 4 + 2]];
+    }
+    return img;
+}
+
+// ---------------------------
+// Equirect -> cube
+// ---------------------------
+
+// Round to nearest even; values past the half range clamp to 65504 (bright sun texels
+// stay bright instead of turning into inf), tiny values flush to zero.
+static std::uint16_t FloatToHalf(float f)
+{
+    std::uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+
+    const std::uint16_t sign = (std::uint16_t)((x >> 16) & 0x8000u);
+    x &= 0x7fffffffu;
+
+    if (x > 0x7f800000u) return sign | 0x7e00u;   // NaN
+    if (x >= 0x477ff000u) return sign | 0x7bffu;  // >= 65520 rounds past max: clamp
+    if (x < 0x38800000u) return sign;             // below the smallest normal half
+
+    x += 0x00000fffu + ((x >> 13) & 1u);
+    return sign | (std::uint16_t)((x - 0x38000000u) >> 13);
+}
+
+static float HalfToFloat(std::uint16_t h)
+{
+    const std::uint32_t sign = (std::uint32_t)(h & 0x8000u) << 16;
+    const std::uint32_t exp = (h >> 10) & 0x1fu;
+    const std::uint32_t mant = h & 0x3ffu;
+
+    std::uint32_t x;
+    if (exp == 0) x = sign;                                      // FloatToHalf never makes subnormals
+    else if (exp == 31) x = sign | 0x7f800000u | (mant << 13);   // inf / NaN
+    else x = sign | ((exp + 112u) << 23) | (mant << 13);
+
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+// Same mapping as the old sky shader's DirToEquirectUV
+static void DirToEquirectUV(float dx, float dy, float dz, float& u, float& v)
+{
+    const float kPi = 3.14159265358979f;
+    const float len = std::sqrt(dx * dx + dy * dy + dz * dz);
+    dx /= len; dy /= len; dz /= len;
+
+    u = std::atan2(dz, dx) / (2.0f * kPi) + 0.5f;
+    v = std::asin(std::clamp(dy, -1.0f, 1.0f)) / kPi + 0.5f;
+}
+
+// Bilinear, wrapping horizontally and clamping at the poles
+static void SampleEquirect(const EquirectImage& img, float u, float v, float out[3])
+{
+    float x = u * img.w - 0.5f;
+    float y = v * img.h - 0.5f;
+
+    const float fx0 = std::floor(x);
+    const float fy0 = std::floor(y);
+    const float tx = x - fx0;
+    const float ty = y - fy0;
+
+    int x0 = (int)fx0 % img.w;
+    if (x0 < 0) x0 += img.w;
+    const int x1 = (x0 + 1) % img.w;
+    const int y0 = std::clamp((int)fy0, 0, img.h - 1);
+    const int y1 = std::clamp((int)fy0 + 1, 0, img.h - 1);
+
+    const float* p00 = &img.rgb[((std::size_t)y0 * img.w + x0) * 3];
+    const float* p10 = &img.rgb[((std::size_t)y0 * img.w + x1) * 3];
+    const float* p01 = &img.rgb[((std::size_t)y1 * img.w + x0) * 3];
+    const float* p11 = &img.rgb[((std::size_t)y1 * img.w + x1) * 3];
+
+    for (int c = 0; c < 3; ++c) {
+        const float top = p00[c] + (p10[c] - p00[c]) * tx;
+        const float bot = p01[c] + (p11[c] - p01[c]) * tx;
+        out[c] = top + (bot - top) * ty;
+    }
+}
+
+// GL cube face orientation: texel (s, t) in [-1, 1] -> direction
+static void CubeFaceDir(int face, float a, float b, float& x, float& y, float& z)
+{
+    switch (face) {
+    case 0:  x = 1.0f;  y = -b;    z = -a;    break; // +X
+    case 1:  x = -1.0f; y = -b;    z = a;     break; // -X
+    case 2:  x = a;     y = 1.0f;  z = b;     break; // +Y
+    case 3:  x = a;     y = -1.0f; z = -b;    break; // -Y
+    case 4:  x = a;     y = -b;    z = 1.0f;  break; // +Z
+    default: x = -a;    y = -b;    z = -1.0f; break; // -Z
+    }
+}
+
+static int DefaultFaceSize(int equirectWidth)
+{
+    // A quarter of the width keeps roughly the source texel density at the horizon
+    int target = std::max(1, equirectWidth / 4);
+    int n = 32;
+    while (n * 2 <= target && n < 2048) n *= 2;
+    return n;
+}
+
+static void PointFacesAt(EnvCube& out, const std::uint16_t* base)
+{
+    const std::size_t faceElems = (std::size_t)out.faceSize * out.faceSize * 3;
+    for (int f = 0; f < 6; ++f) out.faces[f] = base + faceElems * f;
+}
+
+void EquirectToCube(const EquirectImage& img, int faceSize, EnvCube& out)
+{
+    const int n = faceSize > 0 ? faceSize : DefaultFaceSize(img.w);
+
+    out.faceSize = n;
+    out.hdr = img.hdr;
+    out.storage.resize((std::size_t)n * n * 3 * 6);
+    PointFacesAt(out, out.storage.data());
+
+    std::uint16_t* dst = out.storage.data();
+
+    // One work item per face row (6n rows total)
+    ParallelFor(6 * n, [&](int begin, int end) {
+        for (int row = begin; row < end; ++row) {
+            const int face = row / n;
+            const int j = row % n;
+            const float b = 2.0f * ((float)j + 0.5f) / (float)n - 1.0f;
+
+            std::uint16_t* o = dst + ((std::size_t)face * n * n + (std::size_t)j * n) * 3;
+            for (int i = 0; i < n; ++i) {
+                const float a = 2.0f * ((float)i + 0.5f) / (float)n - 1.0f;
+
+                float x, y, z, u, v, rgb[3];
+                CubeFaceDir(face, a, b, x, y, z);
+                DirToEquirectUV(x, y, z, u, v);
+                SampleEquirect(img, u, v, rgb);
+
+                o[i * 3 + 0] = FloatToHalf(rgb[0]);
+                o[i * 3 + 1] = FloatToHalf(rgb[1]);
+                o[i * 3 + 2] = FloatToHalf(rgb[2]);
+            }
+        }
+    });
+}
+
+// ---------------------------
+// SH9 projection
+// ---------------------------
+static void SHBasis9(float x, float y, float z, float out[9])
+{
+    out[0] = 0.282095f;
+    out[1] = 0.488603f * y;
+    out[2] = 0.488603f * z;
+    out[3] = 0.488603f * x;
+    out[4] = 1.092548f * x * y;
+    out[5] = 1.092548f * y * z;
+    out[6] = 0.315392f * (3.0f * z * z - 1.0f);
+    out[7] = 1.092548f * x * z;
+    out[8] = 0.546274f * (x * x - y * y);
+}
+
+// Cosine-lobe convolution (Ramamoorthi & Hanrahan: A0 = PI, A1 = 2PI/3, A2 = PI/4),
+// divided by PI and multiplied by each basis function's constant, so the shader
+// evaluates E(n) / PI with plain polynomials of n
+static void FoldIrradiance(IrradianceSH& sh)
+{
+    const float k[9] = {
+        1.0f * 0.282095f,
+        (2.0f / 3.0f) * 0.488603f, (2.0f / 3.0f) * 0.488603f, (2.0f / 3.0f) * 0.488603f,
+        0.25f * 1.092548f, 0.25f * 1.092548f, 0.25f * 0.315392f, 0.25f * 1.092548f, 0.25f * 0.546274f,
+    };
+    for (int i = 0; i < 9; ++i)
+        for (int c = 0; c < 3; ++c)
+            sh.E[i][c] = sh.L[i][c] * k[i];
+}
+
+IrradianceSH ProjectCubeToSH9(const EnvCube& cube)
+{
+    IrradianceSH sh;
+    const int n = cube.faceSize;
+    if (n <= 0) return sh;
+
+    double total[9][3] = {};
+    double totalWeight = 0.0;
+    std::mutex totalMutex;
+
+    // One work item per face row; each range sums locally and merges once
+    ParallelFor(6 * n, [&](int begin, int end) {
+        double acc[9][3] = {};
+        double accWeight = 0.0;
+
+        for (int row = begin; row < end; ++row) {
+            const int face = row / n;
+            const int j = row % n;
+            const float b = 2.0f * ((float)j + 0.5f) / (float)n - 1.0f;
+            const std::uint16_t* px = cube.faces[face] + (std::size_t)j * n * 3;
+
+            for (int i = 0; i < n; ++i) {
+                const float a = 2.0f * ((float)i + 0.5f) / (float)n - 1.0f;
+
+                float x, y, z;
+                CubeFaceDir(face, a, b, x, y, z);
+
+                // Texel solid angle on the unit cube: dA / r^3
+                const float r2 = 1.0f + a * a + b * b;
+                const float invLen = 1.0f / std::sqrt(r2);
+                const float w = invLen / r2;
+
+                float basis[9];
+                SHBasis9(x * invLen, y * invLen, z * invLen, basis);
+
+                const float rgb[3] = { HalfToFloat(px[i * 3 + 0]), HalfToFloat(px[i * 3 + 1]), HalfToFloat(px[i * 3 + 2]) };
+                for (int k = 0; k < 9; ++k) {
+                    const float wb = w * basis[k];
+                    acc[k][0] += wb * rgb[0];
+                    acc[k][1] += wb * rgb[1];
+                    acc[k][2] += wb * rgb[2];
+                }
+                accWeight += w;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(totalMutex);
+        for (int k = 0; k < 9; ++k)
+            for (int c = 0; c < 3; ++c)
+                total[k][c] += acc[k][c];
+        totalWeight += accWeight;
+    });
+
+    // Normalize the discrete weights so they integrate to exactly 4 PI
+    const double norm = 4.0 * 3.14159265358979 / totalWeight;
+    for (int k = 0; k < 9; ++k)
+        for (int c = 0; c < 3; ++c)
+            sh.L[k][c] = (float)(total[k][c] * norm);
+
+    FoldIrradiance(sh);
+    sh.valid = true;
+    return sh;
+}
+
+// ---------------------------
+// Cache I/O
+// ---------------------------
+static fs::path CubeCachePath(const fs::path& src)
+{
+    fs::path p = src;
+    p += ".cubecache";
+    return p;
+}
+
+static bool TryLoadCubeCache(const fs::path& src, EnvCube& out)
+{
+    auto map = std::make_unique<MappedFile>();
+    if (!map->open(CubeCachePath(src))) return false;
+    if (map->size() < sizeof(EnvCubeHeader)) return false;
+
+    EnvCubeHeader hdr;
+    std::memcpy(&hdr, map->data(), sizeof(hdr));
+
+    if (std::memcmp(hdr.magic, kEnvCubeMagic, sizeof(kEnvCubeMagic)) != 0) return false;
+    if (hdr.version != kEnvCubeVersion || hdr.format != 0) return false;
+    if (hdr.faceSize == 0 || hdr.faceSize > 8192) return false;
+
+    std::error_code ec;
+    const std::uint64_t srcSize = (std::uint64_t)fs::file_size(src, ec);
+    if (ec || srcSize != hdr.srcSize) return false;
+    if (FileMtime(src) != hdr.srcMtime && HashFileFNV1a(src) != hdr.srcHash) return false;
+
+    const std::uint64_t bytes = (std::uint64_t)hdr.faceSize * hdr.faceSize * 3 * 6 * sizeof(std::uint16_t);
+    if (hdr.dataBytes != bytes || map->size() != sizeof(EnvCubeHeader) + bytes) return false;
+
+    out.faceSize = (int)hdr.faceSize;
+    out.hdr = src.extension() == ".hdr";
+    PointFacesAt(out, reinterpret_cast<const std::uint16_t*>(map->data() + sizeof(EnvCubeHeader)));
+    out.mapping = std::move(map);
+    out.fromCache = true;
+    return true;
+}
+
+static void WriteCubeCache(const fs::path& src, const EnvCube& cube)
+{
+    EnvCubeHeader hdr{};
+    std::memcpy(hdr.magic, kEnvCubeMagic, sizeof(kEnvCubeMagic));
+    hdr.version = kEnvCubeVersion;
+    hdr.faceSize = (std::uint32_t)cube.faceSize;
+    hdr.format = 0;
+
+    std::error_code ec;
+    hdr.srcSize = (std::uint64_t)fs::file_size(src, ec);
+    hdr.srcMtime = FileMtime(src);
+    hdr.srcHash = HashFileFNV1a(src);
+    hdr.dataBytes = (std::uint64_t)cube.storage.size() * sizeof(std::uint16_t);
+
+    const fs::path finalPath = CubeCachePath(src);
+    fs::path tmpPath = finalPath;
+    tmpPath += ".tmp";
+
+    {
+        std::ofstream f(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!f) {
+            std::cerr << "Warning: can't write environment cache " << finalPath << "\n";
+            return;
+        }
+        f.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+        f.write(reinterpret_cast<const char*>(cube.storage.data()), (std::streamsize)hdr.dataBytes);
+        if (!f) {
+            std::cerr << "Warning: failed writing environment cache " << finalPath << "\n";
+            f.close();
+            fs::remove(tmpPath, ec);
+            return;
+        }
+    }
+
+    fs::remove(finalPath, ec);
+    fs::rename(tmpPath, finalPath, ec);
+    if (ec) {
+        std::cerr << "Warning: failed to move environment cache into place: " << finalPath << "\n";
+        fs::remove(tmpPath, ec);
+    }
+}
+
+// Header layout mirrors EnvCubeHeader (stamps only), followed by L[9][3]
+struct EnvSHHeader {
+    char          magic[8];   // "LENVSH9"
+    std::uint32_t version;
+    std::uint32_t count;      // 27
+    std::uint64_t srcSize;
+    std::int64_t  srcMtime;
+    std::uint64_t srcHash;
+};
+
+static fs::path SHCachePath(const fs::path& src)
+{
+    fs::path p = src;
+    p += ".sh9";
+    return p;
+}
+
+static bool TryLoadSHCache(const fs::path& src, IrradianceSH& out)
+{
+    std::ifstream f(SHCachePath(src), std::ios::binary);
+    if (!f) return false;
+
+    EnvSHHeader hdr;
+    if (!f.read(reinterpret_cast<char*>(&hdr), sizeof(hdr))) return false;
+    if (std::memcmp(hdr.magic, kEnvSHMagic, sizeof(kEnvSHMagic)) != 0) return false;
+    if (hdr.version != kEnvSHVersion || hdr.count != 27) return false;
+
+    std::error_code ec;
+    const std::uint64_t srcSize = (std::uint64_t)fs::file_size(src, ec);
+    if (ec || srcSize != hdr.srcSize) return false;
+    if (FileMtime(src) != hdr.srcMtime && HashFileFNV1a(src) != hdr.srcHash) return false;
+
+    if (!f.read(reinterpret_cast<char*>(out.L), sizeof(out.L))) return false;
+
+    FoldIrradiance(out);
+    out.valid = true;
+    out.fromCache = true;
+    return true;
+}
+
+static void WriteSHCache(const fs::path& src, const IrradianceSH& sh)
+{
+    EnvSHHeader hdr{};
+    std::memcpy(hdr.magic, kEnvSHMagic, sizeof(kEnvSHMagic));
+    hdr.version = kEnvSHVersion;
+    hdr.count = 27;
+
+    std::error_code ec;
+    hdr.srcSize = (std::uint64_t)fs::file_size(src, ec);
+    hdr.srcMtime = FileMtime(src);
+    hdr.srcHash = HashFileFNV1a(src);
+
+    // Small enough to write in place; a torn file just fails validation next time
+    std::ofstream f(SHCachePath(src), std::ios::binary | std::ios::trunc);
+    if (!f) {
+        std::cerr << "Warning: can't write SH cache " << SHCachePath(src) << "\n";
+        return;
+    }
+    f.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    f.write(reinterpret_cast<const char*>(sh.L), sizeof(sh.L));
+}
+
+EnvCube LoadEnvironmentCube(const fs::path& src, bool useCache)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    auto msSince = [&]() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    };
+
+    const fs::path used = PickEquirectSource(src);
+
+    EnvCube cube;
+    if (!(useCache && TryLoadCubeCache(used, cube))) {
+        cube = EnvCube{};
+
+        EquirectImage img = LoadEquirect(used);
+        if (img.rgb.empty()) return cube;
+
+        EquirectToCube(img, 0, cube);
+        if (useCache) WriteCubeCache(used, cube);
+    }
+    cube.loadMs = msSince();
+
+    // Irradiance: the cube is already in memory either way, so a miss is just one pass over it
+    const auto s0 = std::chrono::steady_clock::now();
+    if (!(useCache && TryLoadSHCache(used, cube.sh))) {
+        cube.sh = ProjectCubeToSH9(cube);
+        if (useCache && cube.sh.valid) WriteSHCache(used, cube.sh);
+    }
+    cube.sh.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - s0).count();
+
+    return cube;
+}
+
+GLuint UploadEnvironmentCube(const EnvCube& cube)
+{
+    if (cube.faceSize <= 0) return 0;
+
+    GLuint tex = 0;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, tex);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    for (int f = 0; f < 6; ++f) {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + f, 0, GL_RGB16F,
+            cube.faceSize, cube.faceSize, 0, GL_RGB, GL_HALF_FLOAT, cube.faces[f]);
+    }
+
+    // Sky is magnified on screen: no mips needed
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    return tex;
+}
@@ -0,0 +1,95 @@
+//EnvMap.h
+#pragma once
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "MappedFile.h"
+
+// ---------------------------
+// Environment cubemap
+// The equirect HDRI is resampled into 6 cube faces once on the CPU and cached as
+// `<image>.cubecache` (RGB half floats), so the sky pass is a single cube lookup
+// instead of per-pixel atan/asin.
+//
+// Source: `<stem>.hdr` next to the given image if it exists (stbi_loadf, real dynamic
+// range), else the image itself (8-bit, sRGB decoded to linear).
+//
+// Layout (native endian):
+//   EnvCubeHeader (64 bytes)
+//   faces +X, -X, +Y, -Y, +Z, -Z   faceSize * faceSize * RGB16F each, rows bottom-up (GL order)
+// Validity is checked the same way as .texcache (size + mtime, hash fallback).
+// ---------------------------
+constexpr std::uint32_t kEnvCubeVersion = 1;
+
+struct EnvCubeHeader {
+    char          magic[8];   // "LENVCUBE"
+    std::uint32_t version;
+    std::uint32_t faceSize;
+    std::uint32_t format;     // 0 = RGB16F
+    std::uint32_t reserved0;
+    std::uint64_t srcSize;
+    std::int64_t  srcMtime;
+    std::uint64_t srcHash;
+    std::uint64_t dataBytes;
+    std::uint64_t reserved1;
+};
+static_assert(sizeof(EnvCubeHeader) == 64, "cubecache header must stay 64 bytes");
+
+// Linear RGB float equirect image, rows bottom-up (stb flip is on)
+struct EquirectImage {
+    int w = 0;
+    int h = 0;
+    std::vector<float> rgb;
+    bool hdr = false; // came from a .hdr file
+};
+
+// .hdr next to `src` if present, else `src`. Empty image on failure.
+EquirectImage LoadEquirect(const std::filesystem::path& src, std::filesystem::path* usedPath = nullptr);
+
+// ---------------------------
+// Irradiance SH
+// Order-2 (9 coefficient) projection of the environment radiance, used as the diffuse
+// ambient term. Cached as `<image>.sh9` (header + 27 floats, same validity rules).
+// Basis order: 1, y, z, x, xy, yz, 3z^2-1, xz, x^2-y^2 (GL axes, y up).
+// ---------------------------
+constexpr std::uint32_t kEnvSHVersion = 1;
+
+struct IrradianceSH {
+    float L[9][3] = {};   // radiance coefficients
+    float E[9][3] = {};   // L with the cosine lobe and basis constants folded in: the shader
+                          // just sums E[i] * basis_i(n) to get irradiance / PI
+    bool   valid = false;
+    bool   fromCache = false;
+    double ms = 0.0;
+};
+
+struct EnvCube {
+    int faceSize = 0;
+    const std::uint16_t* faces[6] = {}; // half floats, faceSize * faceSize * 3 each
+
+    bool   fromCache = false;
+    bool   hdr = false;
+    double loadMs = 0.0;
+
+    IrradianceSH sh; // filled by LoadEnvironmentCube
+
+    std::unique_ptr<MappedFile> mapping;
+    std::vector<std::uint16_t> storage;
+};
+
+// Resample into a cube, rows in parallel. faceSize == 0 -> width / 4 rounded to a power of two.
+void EquirectToCube(const EquirectImage& img, int faceSize, EnvCube& out);
+
+// Projects the cube faces (texel solid angles, rows in parallel) and folds E
+IrradianceSH ProjectCubeToSH9(const EnvCube& cube);
+
+// CPU only (pool-safe): cube + its SH, each from its cache when valid. faceSize == 0 on failure.
+EnvCube LoadEnvironmentCube(const std::filesystem::path& src, bool useCache);
+
+// GL thread. RGB16F cube, linear filtering, clamped; 0 if `cube` is empty.
+GLuint UploadEnvironmentCube(const EnvCube& cube);
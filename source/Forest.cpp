@@ -0,0 +1,226 @@
+//Forest.cpp
+#include "Forest.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <random>
+#include <thread>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+// ---------------------------
+// Forest
+// ---------------------------
+std::size_t ForestMesh::vertexCount() const
+{
+    std::size_t n = 0;
+    for (const ForestTree& t : trees) n += t.vertexCount;
+    return n;
+}
+
+ForestMesh BuildForest(const std::vector<TreePlacement>& placements, const ForestSettings& settings)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+
+    ForestMesh forest;
+    forest.trees.resize(placements.size());
+    if (placements.empty()) return forest;
+
+    unsigned threads = settings.threads ? settings.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min<unsigned>(threads, (unsigned)placements.size());
+    forest.threads = threads;
+
+    // Biggest first: a deciduous tree started last would be the whole tail
+    std::vector<int> order(placements.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return placements[a].preset == TreePreset::Deciduous && placements[b].preset != TreePreset::Deciduous;
+    });
+
+    // Per worker: build scratch, and the blocks its placed trees go into
+    struct Worker {
+        TreeBuildArena arena;
+        std::vector<std::vector<VertexPN>> blocks;
+    };
+    std::vector<Worker> workers(threads);
+
+    ParallelForEach((int)order.size(), [&](int n, unsigned worker) {
+        const auto tt = std::chrono::steady_clock::now();
+        const int index = order[n];
+        const TreePlacement& place = placements[index];
+
+        TreeParams p;
+        p.preset = place.preset;
+        ApplyTreePreset(p);
+        if (settings.iterations > 0) p.iterations = settings.iterations;
+        p.seed = place.seed;
+        p.baseTranslation = glm::vec3(0.0f); // placed below
+
+        Worker& w = workers[worker];
+        const std::size_t count = BuildTreeVerticesInto(p, w.arena);
+
+        // Reserved, never grown: a full block is left as it is and a new one started
+        if (w.blocks.empty() || w.blocks.back().capacity() - w.blocks.back().size() < count) {
+            w.blocks.emplace_back();
+            w.blocks.back().reserve(std::max(kForestBlockVerts, count));
+        }
+        std::vector<VertexPN>& out = w.blocks.back();
+
+        ForestTree& tree = forest.trees[index];
+        tree.block = (unsigned)w.blocks.size() - 1; // per worker for now, made global below
+        tree.firstVertex = out.size();
+        tree.vertexCount = count;
+        tree.worker = worker;
+
+        // Uniform scale + yaw: normals and tangents only need the rotation
+        const glm::mat3 rot = glm::mat3(glm::rotate(glm::mat4(1.0f), glm::radians(place.yawDeg), glm::vec3(0, 1, 0)));
+
+        glm::vec3 lo(std::numeric_limits<float>::max()), hi(-std::numeric_limits<float>::max());
+        for (std::size_t i = 0; i < count; ++i) {
+            const VertexPN& v = w.arena.vertices[i];
+            VertexPN d;
+            d.pos = place.position + rot * (v.pos * place.scale);
+            d.normal = rot * v.normal;
+            d.uv = v.uv;
+            d.tangent = glm::vec4(rot * glm::vec3(v.tangent), v.tangent.w);
+            lo = glm::min(lo, d.pos);
+            hi = glm::max(hi, d.pos);
+            out.push_back(d); // within capacity: no reallocation, no zero-fill first
+        }
+
+        tree.boundsMin = count ? lo : place.position;
+        tree.boundsMax = count ? hi : place.position;
+        tree.buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - tt).count();
+    }, threads);
+
+    // Hand the blocks over (moves, no copies) and make the tree block indices global
+    std::vector<unsigned> firstBlock(threads);
+    for (unsigned w = 0; w < threads; ++w) {
+        firstBlock[w] = (unsigned)forest.blocks.size();
+        for (std::vector<VertexPN>& block : workers[w].blocks) forest.blocks.push_back(std::move(block));
+    }
+    for (ForestTree& tree : forest.trees) tree.block += firstBlock[tree.worker];
+
+    forest.buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return forest;
+}
+
+// ---------------------------
+// Instanced
+// ---------------------------
+
+// Slight shade / warmth change per placement so repeated variants don't read as copies.
+// Uses the seed's high bits; the variant slot comes from the low ones.
+static glm::vec4 PlacementTint(std::uint32_t seed)
+{
+    const float shade = 0.85f + 0.25f * float((seed >> 16) & 255u) / 255.0f;
+    const float warm = float((seed >> 24) & 255u) / 255.0f - 0.5f;
+    return glm::vec4(shade * (1.0f + 0.08f * warm), shade, shade * (1.0f - 0.08f * warm), 1.0f);
+}
+
+InstancedForest BuildInstancedForest(const std::vector<TreePlacement>& placements, int variantsPerPreset,
+    const ForestSettings& settings)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    const std::uint32_t poolSize = (std::uint32_t)std::max(1, variantsPerPreset);
+
+    // A variant is the tree of the first placement that lands in its (preset, slot)
+    std::vector<int> variantOf(placements.size());
+    std::vector<TreePlacement> meshes; // at the origin
+    std::map<std::pair<int, std::uint32_t>, int> slots;
+    for (std::size_t i = 0; i < placements.size(); ++i) {
+        const TreePlacement& t = placements[i];
+        const std::pair<int, std::uint32_t> key((int)t.preset, t.seed % poolSize);
+        auto it = slots.find(key);
+        if (it == slots.end()) {
+            it = slots.emplace(key, (int)meshes.size()).first;
+            TreePlacement m;
+            m.preset = t.preset;
+            m.seed = t.seed;
+            meshes.push_back(m);
+        }
+        variantOf[i] = it->second;
+    }
+
+    ForestMesh built = BuildForest(meshes, settings);
+
+    InstancedForest forest;
+    forest.blocks = std::move(built.blocks);
+    forest.threads = built.threads;
+    forest.variants.resize(meshes.size());
+    for (std::size_t v = 0; v < meshes.size(); ++v) {
+        ForestVariant& variant = forest.variants[v];
+        variant.preset = meshes[v].preset;
+        variant.seed = meshes[v].seed;
+        variant.block = built.trees[v].block;
+        variant.firstVertex = built.trees[v].firstVertex;
+        variant.vertexCount = built.trees[v].vertexCount;
+    }
+
+    // Instances grouped by variant: one contiguous range per instanced draw
+    for (int v : variantOf) ++forest.variants[v].instanceCount;
+    std::vector<std::size_t> cursor(forest.variants.size());
+    std::size_t first = 0;
+    for (std::size_t v = 0; v < forest.variants.size(); ++v) {
+        forest.variants[v].firstInstance = cursor[v] = first;
+        first += forest.variants[v].instanceCount;
+    }
+
+    forest.instances.resize(placements.size());
+    for (std::size_t i = 0; i < placements.size(); ++i) {
+        const TreePlacement& t = placements[i];
+        ForestInstance& inst = forest.instances[cursor[variantOf[i]]++];
+        inst.model = glm::translate(glm::mat4(1.0f), t.position)
+            * glm::rotate(glm::mat4(1.0f), glm::radians(t.yawDeg), glm::vec3(0, 1, 0))
+            * glm::scale(glm::mat4(1.0f), glm::vec3(t.scale));
+        inst.tint = PlacementTint(t.seed);
+    }
+
+    forest.buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return forest;
+}
+
+// ---------------------------
+// Placement
+// ---------------------------
+std::vector<TreePlacement> ScatterForest(int count, TreePreset preset, float innerRadius, float outerRadius,
+    float minSpacing, std::uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<TreePlacement> out;
+    out.reserve((std::size_t)std::max(count, 0));
+    for (int n = 0; n < count; ++n) {
+        TreePlacement t;
+        t.preset = preset;
+
+        // A few tries for a free spot, then take the last one anyway
+        for (int attempt = 0; attempt < 32; ++attempt) {
+            // sqrt: uniform over the ring's area, not bunched at the inside
+            const float r2 = glm::mix(innerRadius * innerRadius, outerRadius * outerRadius, unit(rng));
+            const float a = unit(rng) * 6.28318530718f;
+            t.position = glm::vec3(std::sqrt(r2) * std::cos(a), 0.0f, std::sqrt(r2) * std::sin(a));
+
+            bool free = true;
+            for (const TreePlacement& o : out) {
+                if (glm::length(glm::vec2(o.position.x - t.position.x, o.position.z - t.position.z)) < minSpacing) {
+                    free = false;
+                    break;
+                }
+            }
+            if (free) break;
+        }
+
+        t.seed = rng();
+        t.yawDeg = unit(rng) * 360.0f;
+        t.scale = glm::mix(0.8f, 1.2f, unit(rng));
+        out.push_back(t);
+    }
+    return out;
+}
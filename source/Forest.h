@@ -0,0 +1,102 @@
+//Forest.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "TreeGen.h"
+
+// ---------------------------
+// Forest: a stand of trees built in parallel
+// Every placement is built at the origin from its preset and seed, then scaled, turned
+// about +Y and moved so its trunk base sits at `position`. Workers write each placed tree
+// once, straight into large vertex blocks they reserved up front (kForestBlockVerts): no
+// per-tree allocation and no gather copy. A tree is one contiguous range of one block, so
+// a stand is one upload and one draw per block.
+//
+// Trees are handed out biggest first (deciduous trees have ~5x the vertices of conifers)
+// and each worker takes the next one as soon as it is done (ParallelForEach), so a long
+// tree never leaves the others idle at the end. Workers share the preset grammars and the
+// ring / sphere templates read-only and build into their own TreeBuildArena, so after
+// their first tree they rewrite and mesh without growing any buffer.
+// ---------------------------
+struct TreePlacement {
+    glm::vec3 position = glm::vec3(0.0f); // trunk base
+    TreePreset preset = TreePreset::Deciduous;
+    std::uint32_t seed = 0;
+    float scale = 1.0f;
+    float yawDeg = 0.0f;
+};
+
+struct ForestSettings {
+    int iterations = 0;   // 0 = each preset's own
+    unsigned threads = 0; // 0 = one per hardware thread
+};
+
+// Vertices per block (48 MB); a tree bigger than that gets a block of its own size
+constexpr std::size_t kForestBlockVerts = std::size_t(1) << 20;
+
+struct ForestTree {
+    unsigned block = 0;           // in ForestMesh::blocks
+    std::size_t firstVertex = 0;  // within that block
+    std::size_t vertexCount = 0;
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    double buildMs = 0.0; // build + placement transform
+    unsigned worker = 0;
+};
+
+struct ForestMesh {
+    std::vector<std::vector<VertexPN>> blocks;
+    std::vector<ForestTree> trees; // one per placement, same order
+    double buildMs = 0.0;          // wall clock
+    unsigned threads = 0;
+
+    std::size_t vertexCount() const;
+};
+
+// Throws what a build throws (std::bad_alloc for a forest that doesn't fit).
+ForestMesh BuildForest(const std::vector<TreePlacement>& placements, const ForestSettings& settings = ForestSettings());
+
+// ---------------------------
+// Instanced forest: a few unique trees, many placements
+// Each preset gets a pool of at most variantsPerPreset seed variants; every placement is
+// drawn as one of them (placement seed % pool size), through a model matrix and a tint in
+// an instance buffer. Only the variants are meshed (with BuildForest, at the origin), so a
+// stand of thousands costs a few dozen trees of memory and build time.
+// ---------------------------
+
+// One instance-buffer element, uploaded as-is (four vec4 columns + tint). The model has
+// the placement's scale, yaw and position; the tint multiplies the bark albedo.
+struct ForestInstance {
+    glm::mat4 model = glm::mat4(1.0f);
+    glm::vec4 tint = glm::vec4(1.0f);
+};
+static_assert(sizeof(ForestInstance) == 80, "ForestInstance is uploaded as-is");
+
+struct ForestVariant {
+    TreePreset preset = TreePreset::Deciduous;
+    std::uint32_t seed = 0;
+    unsigned block = 0;                               // in InstancedForest::blocks
+    std::size_t firstVertex = 0, vertexCount = 0;     // within that block
+    std::size_t firstInstance = 0, instanceCount = 0; // in InstancedForest::instances
+};
+
+struct InstancedForest {
+    std::vector<std::vector<VertexPN>> blocks; // every variant, at the origin, unscaled
+    std::vector<ForestVariant> variants;    // only the ones some placement uses
+    std::vector<ForestInstance> instances;  // grouped by variant
+    double buildMs = 0.0;                   // variant meshes + instance list
+    unsigned threads = 0;
+};
+
+InstancedForest BuildInstancedForest(const std::vector<TreePlacement>& placements, int variantsPerPreset,
+    const ForestSettings& settings = ForestSettings());
+
+// `count` placements of `preset` in the ring innerRadius..outerRadius around the origin, at
+// least minSpacing apart where the ring has room, with random seed / yaw / scale (0.8..1.2).
+// y is 0: the caller puts them on its ground. Same `seed` -> same stand.
+std::vector<TreePlacement> ScatterForest(int count, TreePreset preset, float innerRadius, float outerRadius,
+    float minSpacing, std::uint32_t seed);
@@ -0,0 +1,170 @@
+//FrameTimer.cpp
+#include "FrameTimer.h"
+
+#include <iomanip>
+#include <utility>
+
+static double MsBetween(std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b)
+{
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+FrameTimer::FrameTimer(std::vector<Section> sections, double windowSeconds)
+    : m_sections(std::move(sections)), m_window(windowSeconds)
+{
+    m_stats.resize(m_sections.size());
+
+    // Timer queries are core in 3.3, but a driver may still report a 0-bit counter
+    GLint bits = 0;
+    glGetQueryiv(GL_TIME_ELAPSED, GL_QUERY_COUNTER_BITS, &bits);
+    m_gpuTimers = bits > 0;
+
+    if (m_gpuTimers) {
+        m_queries.resize((std::size_t)kRingFrames * m_sections.size(), 0);
+        glGenQueries((GLsizei)m_queries.size(), m_queries.data());
+    }
+    m_issued.assign((std::size_t)kRingFrames * m_sections.size(), 0);
+
+    m_created = m_windowStart = m_frameStart = Clock::now();
+}
+
+FrameTimer::~FrameTimer()
+{
+    if (!m_queries.empty()) glDeleteQueries((GLsizei)m_queries.size(), m_queries.data());
+}
+
+// Reads back the queries issued kRingFrames frames ago, without waiting for them
+void FrameTimer::collect(int slot)
+{
+    const std::size_t n = m_sections.size();
+    for (std::size_t s = 0; s < n; ++s) {
+        char& issued = m_issued[(std::size_t)slot * n + s];
+        if (!issued) continue;
+        issued = 0;
+
+        const GLuint q = m_queries[(std::size_t)slot * n + s];
+        GLint available = 0;
+        glGetQueryObjectiv(q, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            ++m_dropped;
+            continue;
+        }
+
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(q, GL_QUERY_RESULT, &ns);
+        m_stats[s].gpuSum += double(ns) * 1e-6;
+        ++m_stats[s].gpuSamples;
+    }
+}
+
+void FrameTimer::beginFrame()
+{
+    m_slot = (m_slot + 1) % kRingFrames;
+    if (m_gpuTimers) collect(m_slot);
+    m_frameStart = Clock::now();
+}
+
+bool FrameTimer::endFrame()
+{
+    const Clock::time_point now = Clock::now();
+    m_frameSum += MsBetween(m_frameStart, now);
+    ++m_frames;
+
+    const double elapsed = MsBetween(m_windowStart, now) * 1e-3;
+    if (elapsed < m_window) return false;
+
+    const double frames = double(m_frames);
+    for (Stat& st : m_stats) {
+        st.cpuAvg = st.cpuSamples ? st.cpuSum / double(st.cpuSamples) : 0.0;
+        st.gpuAvg = st.gpuSamples ? st.gpuSum / double(st.gpuSamples) : -1.0;
+        st.cpuSum = st.gpuSum = 0.0;
+        st.cpuSamples = st.gpuSamples = 0;
+    }
+    m_lastTime = MsBetween(m_created, now) * 1e-3;
+    m_lastFps = frames / elapsed;
+    m_lastFrameMs = m_frameSum / frames;
+    m_lastDropped = m_dropped;
+
+    m_frameSum = 0.0;
+    m_frames = 0;
+    m_dropped = 0;
+    m_windowStart = now;
+    return true;
+}
+
+void FrameTimer::begin(int section)
+{
+    m_stats[section].cpuStart = Clock::now();
+
+    if (m_gpuTimers && m_sections[section].gpu && m_activeGpu < 0) {
+        glBeginQuery(GL_TIME_ELAPSED, m_queries[(std::size_t)m_slot * m_sections.size() + section]);
+        m_activeGpu = section;
+    }
+}
+
+void FrameTimer::end(int section)
+{
+    m_stats[section].cpuSum += MsBetween(m_stats[section].cpuStart, Clock::now());
+    ++m_stats[section].cpuSamples;
+
+    if (m_activeGpu == section) {
+        glEndQuery(GL_TIME_ELAPSED);
+        m_issued[(std::size_t)m_slot * m_sections.size() + section] = 1;
+        m_activeGpu = -1;
+    }
+}
+
+// ---------------------------
+// Reports
+// ---------------------------
+void FrameTimer::print(std::ostream& os) const
+{
+    const auto flags = os.flags();
+    const auto prec = os.precision();
+
+    os << std::fixed << std::setprecision(2)
+        << "Frame: " << m_lastFrameMs << " ms cpu, " << std::setprecision(1) << m_lastFps << " fps |"
+        << std::setprecision(3);
+    for (std::size_t s = 0; s < m_sections.size(); ++s) {
+        const Stat& st = m_stats[s];
+        os << " " << m_sections[s].name << " " << st.cpuAvg;
+        if (st.gpuAvg >= 0.0) os << "/" << st.gpuAvg;
+    }
+    os << " (ms cpu/gpu)";
+    if (m_lastDropped) os << ", " << m_lastDropped << " late queries";
+    os << "\n";
+
+    os.flags(flags);
+    os.precision(prec);
+}
+
+void FrameTimer::writeCsvHeader(std::ostream& os) const
+{
+    os << "time_s,fps,frame_cpu_ms";
+    for (const Section& s : m_sections) {
+        os << "," << s.name << "_cpu_ms";
+        if (s.gpu) os << "," << s.name << "_gpu_ms";
+    }
+    os << ",late_queries\n";
+}
+
+void FrameTimer::writeCsvRow(std::ostream& os) const
+{
+    const auto flags = os.flags();
+    const auto prec = os.precision();
+
+    os << std::fixed << std::setprecision(4) << m_lastTime << "," << m_lastFps << "," << m_lastFrameMs;
+    for (std::size_t s = 0; s < m_sections.size(); ++s) {
+        const Stat& st = m_stats[s];
+        os << "," << st.cpuAvg;
+        if (m_sections[s].gpu) {
+            os << ",";
+            if (st.gpuAvg >= 0.0) os << st.gpuAvg; // empty: no timer / nothing drawn
+        }
+    }
+    os << "," << m_lastDropped << "\n";
+    os.flush();
+
+    os.flags(flags);
+    os.precision(prec);
+}
@@ -0,0 +1,92 @@
+//FrameTimer.h
+#pragma once
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// ---------------------------
+// Per-pass frame timing
+// Every section gets CPU wall time (steady_clock between begin() and end()); sections marked
+// gpu also get a GL_TIME_ELAPSED query (CPU time of a GL pass is only its submit cost).
+// Queries live in a ring of kRingFrames sets and are read back when their set comes round
+// again, kRingFrames frames later, and only if GL_QUERY_RESULT_AVAILABLE says so, so the
+// CPU never waits on the GPU (a result that still isn't there is dropped and counted).
+//
+// Only one GL_TIME_ELAPSED query may be active at a time: gpu sections must not nest.
+// CPU-only sections can wrap anything.
+// If the driver reports 0 counter bits (no timer), GPU columns stay empty and the rest works.
+//
+// Sums are kept over a window; endFrame() returns true when the window is over, then
+// print() / writeCsvRow() report the averages and the next window starts. Section averages
+// are per run of the section (a pass that is skipped in a frame doesn't pull them down).
+// ---------------------------
+class FrameTimer {
+public:
+    struct Section {
+        std::string name;
+        bool gpu = false;
+    };
+
+    static constexpr int kRingFrames = 4;
+
+    // GL thread, needs a current context
+    FrameTimer(std::vector<Section> sections, double windowSeconds = 1.0);
+    ~FrameTimer();
+
+    FrameTimer(const FrameTimer&) = delete;
+    FrameTimer& operator=(const FrameTimer&) = delete;
+
+    bool gpuTimers() const { return m_gpuTimers; }
+
+    void beginFrame();
+    bool endFrame(); // true: a window just finished, report it now
+
+    void begin(int section);
+    void end(int section);
+
+    // Averages of the last finished window
+    void print(std::ostream& os) const;
+    void writeCsvHeader(std::ostream& os) const;
+    void writeCsvRow(std::ostream& os) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stat {
+        Clock::time_point cpuStart;
+        double cpuSum = 0.0;           // ms, current window
+        std::uint32_t cpuSamples = 0;
+        double gpuSum = 0.0;           // ms, current window
+        std::uint32_t gpuSamples = 0;
+        double cpuAvg = 0.0, gpuAvg = -1.0; // last window; gpuAvg < 0 = no data
+    };
+
+    void collect(int slot);
+
+    std::vector<Section> m_sections;
+    std::vector<Stat> m_stats;
+    bool m_gpuTimers = false;
+
+    std::vector<GLuint> m_queries;  // kRingFrames x sections
+    std::vector<char> m_issued;     // same layout
+    int m_slot = 0;
+    int m_activeGpu = -1;           // section with the open query
+
+    double m_window = 1.0;
+    Clock::time_point m_windowStart;
+    Clock::time_point m_frameStart;
+    double m_frameSum = 0.0;        // ms, begin-to-end of every frame in the window
+    std::uint32_t m_frames = 0;
+    std::uint32_t m_dropped = 0;
+
+    // Last finished window
+    double m_lastTime = 0.0;        // seconds since construction at its end
+    double m_lastFps = 0.0;
+    double m_lastFrameMs = 0.0;
+    std::uint32_t m_lastDropped = 0;
+    Clock::time_point m_created;
+};
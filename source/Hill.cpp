@@ -0,0 +1,508 @@
+//Hill.cpp
+#include "Hill.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+// SSE2 is baseline on x64 (MSVC and GCC/Clang); anything else takes the scalar fallback
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HILL_SSE2 1
+#include <emmintrin.h>
+#else
+#define HILL_SSE2 0
+#endif
+
+float HillHeightFn(float x, float z, float baseY)
+{
+    // Broad mound (Gaussian-ish)
+    float r2 = x * x + z * z;
+    float moundHeight = 0.55f;
+    float sigma = 10.0f; // bigger = wider hill
+    float mound = moundHeight * std::exp(-r2 / (2.0f * sigma * sigma));
+
+    // Subtle noise
+    float noiseAmp = 0.25f;
+    float n =
+        0.60f * std::sin(0.35f * x + 0.15f * z) +
+        0.40f * std::cos(0.25f * z - 0.10f * x) +
+        0.25f * std::sin(0.18f * (x + z));
+
+    return baseY + mound + noiseAmp * n;
+}
+
+// ---------------------------
+// SSE2 math (Cephes single-precision polynomials, as in sse_mathfun)
+// ---------------------------
+#if HILL_SSE2
+static inline __m128 ExpPs(__m128 x)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    x = _mm_min_ps(x, _mm_set1_ps(88.3762626647949f));
+    x = _mm_max_ps(x, _mm_set1_ps(-88.3762626647949f));
+
+    // n = floor(x / ln2 + 0.5)
+    __m128 fx = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(1.44269504088896341f)), _mm_set1_ps(0.5f));
+    __m128 tmp = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+    fx = _mm_sub_ps(tmp, _mm_and_ps(_mm_cmpgt_ps(tmp, fx), one));
+
+    // x - n * ln2 in two parts
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(0.693359375f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(-2.12194440e-4f)));
+
+    const __m128 z = _mm_mul_ps(x, x);
+    __m128 y = _mm_set1_ps(1.9875691500e-4f);
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.3981999507e-3f));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(8.3334519073e-3f));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(4.1665795894e-2f));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.6666665459e-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(5.0000001201e-1f));
+    y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, z), x), one);
+
+    // * 2^n
+    __m128i e = _mm_add_epi32(_mm_cvttps_epi32(fx), _mm_set1_epi32(127));
+    return _mm_mul_ps(y, _mm_castsi128_ps(_mm_slli_epi32(e, 23)));
+}
+
+// Accurate to ~1e-7 for |x| up to a few thousand (plenty for terrain in world units)
+static inline __m128 SinPs(__m128 x)
+{
+    const __m128 signBit = _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000u));
+
+    __m128 sign = _mm_and_ps(x, signBit);
+    x = _mm_andnot_ps(signBit, x);
+
+    // Octant j (rounded to even), folded into [-pi/4, pi/4]
+    __m128i j = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f)));
+    j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+    const __m128 y = _mm_cvtepi32_ps(j);
+
+    sign = _mm_xor_ps(sign, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29)));
+    const __m128 useSinPoly = _mm_castsi128_ps(
+        _mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), _mm_setzero_si128()));
+
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(0.78515625f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(2.4187564849853515625e-4f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(3.77489497744594108e-8f)));
+
+    const __m128 z = _mm_mul_ps(x, x);
+
+    __m128 c = _mm_set1_ps(2.443315711809948e-5f);
+    c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(-1.388731625493765e-3f));
+    c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(4.166664568298827e-2f));
+    c = _mm_mul_ps(_mm_mul_ps(c, z), z);
+    c = _mm_sub_ps(c, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    c = _mm_add_ps(c, _mm_set1_ps(1.0f));
+
+    __m128 s = _mm_set1_ps(-1.9515295891e-4f);
+    s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(8.3321608736e-3f));
+    s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(-1.6666654611e-1f));
+    s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), x), x);
+
+    const __m128 r = _mm_or_ps(_mm_and_ps(useSinPoly, s), _mm_andnot_ps(useSinPoly, c));
+    return _mm_xor_ps(r, sign);
+}
+
+static inline __m128 CosPs(__m128 x)
+{
+    return SinPs(_mm_add_ps(x, _mm_set1_ps(1.57079632679489662f)));
+}
+#endif
+
+// ---------------------------
+// Heights
+// ---------------------------
+
+// out[i] = HillHeightFn(x0 + i * dx, z, baseY)
+static void HeightRowSimd(float x0, float dx, float z, float baseY, int count, float* out)
+{
+    int i = 0;
+#if HILL_SSE2
+    const __m128 lane = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    const __m128 vx0 = _mm_set1_ps(x0);
+    const __m128 vdx = _mm_set1_ps(dx);
+    const __m128 vz = _mm_set1_ps(z);
+    const __m128 vz2 = _mm_mul_ps(vz, vz);
+
+    // Same constants as HillHeightFn
+    const __m128 expScale = _mm_set1_ps(-1.0f / (2.0f * 10.0f * 10.0f));
+    const __m128 moundHeight = _mm_set1_ps(0.55f);
+    const __m128 noiseAmp = _mm_set1_ps(0.25f);
+    const __m128 a1 = _mm_set1_ps(0.15f * z);
+    const __m128 a2 = _mm_set1_ps(0.25f * z);
+
+    for (; i + 4 <= count; i += 4) {
+        const __m128 x = _mm_add_ps(vx0, _mm_mul_ps(_mm_add_ps(_mm_set1_ps((float)i), lane), vdx));
+
+        const __m128 r2 = _mm_add_ps(_mm_mul_ps(x, x), vz2);
+        const __m128 mound = _mm_mul_ps(moundHeight, ExpPs(_mm_mul_ps(r2, expScale)));
+
+        const __m128 s1 = SinPs(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(0.35f), x), a1));
+        const __m128 c2 = CosPs(_mm_sub_ps(a2, _mm_mul_ps(_mm_set1_ps(0.10f), x)));
+        const __m128 s3 = SinPs(_mm_mul_ps(_mm_set1_ps(0.18f), _mm_add_ps(x, vz)));
+
+        __m128 n = _mm_mul_ps(_mm_set1_ps(0.60f), s1);
+        n = _mm_add_ps(n, _mm_mul_ps(_mm_set1_ps(0.40f), c2));
+        n = _mm_add_ps(n, _mm_mul_ps(_mm_set1_ps(0.25f), s3));
+
+        const __m128 h = _mm_add_ps(_mm_add_ps(_mm_set1_ps(baseY), mound), _mm_mul_ps(noiseAmp, n));
+        _mm_storeu_ps(out + i, h);
+    }
+#endif
+    for (; i < count; ++i) out[i] = HillHeightFn(x0 + i * dx, z, baseY);
+}
+
+// N x N heights starting at (x0, z0), spacing dx in both directions
+static std::vector<float> BuildHeights(float baseY, float x0, float z0, float dx, int N,
+    HillKernel kernel, unsigned threads)
+{
+    const float dz = dx;
+
+    std::vector<float> H((std::size_t)N * N, 0.0f);
+
+    ParallelFor(N, [&](int j0, int j1) {
+        for (int j = j0; j < j1; ++j) {
+            float z = z0 + j * dz;
+            float* row = &H[(std::size_t)j * N];
+
+            if (kernel == HillKernel::Simd) {
+                HeightRowSimd(x0, dx, z, baseY, N, row);
+            }
+            else {
+                for (int i = 0; i < N; ++i) {
+                    float x = x0 + i * dx;
+                    row[i] = HillHeightFn(x, z, baseY);
+                }
+            }
+        }
+    }, threads);
+
+    return H;
+}
+
+std::vector<float> BuildHillHeights(float baseY, float halfSize, int gridN, HillKernel kernel, unsigned threads)
+{
+    gridN = std::max(4, gridN);
+    return BuildHeights(baseY, -halfSize, -halfSize, 2.0f * halfSize / float(gridN - 1), gridN, kernel, threads);
+}
+
+// ---------------------------
+// Normals / tangents
+// ---------------------------
+namespace {
+struct HillGrid {
+    int N;
+    float x0, z0, dx, dz;
+    float uvWorldU, uvWorldV;
+    float baseY;
+    bool seamless;
+    const float* H;
+};
+}
+
+// The original per-point derivation (central differences, one-sided at the border;
+// seamless grids evaluate the height function just outside instead)
+static VertexPN MakeHillVertex(const HillGrid& g, int i, int j)
+{
+    const int N = g.N;
+    auto idx = [&](int ii, int jj) { return (std::size_t)jj * N + ii; };
+    auto height = [&](int ii, int jj) {
+        if (ii >= 0 && ii < N && jj >= 0 && jj < N) return g.H[idx(ii, jj)];
+        return HillHeightFn(g.x0 + ii * g.dx, g.z0 + jj * g.dz, g.baseY);
+    };
+
+    float x = g.x0 + i * g.dx;
+    float z = g.z0 + j * g.dz;
+
+    float hC = g.H[idx(i, j)];
+    int iL = i - 1, iR = i + 1, jD = j - 1, jU = j + 1;
+    if (!g.seamless) {
+        iL = std::max(0, iL); iR = std::min(N - 1, iR);
+        jD = std::max(0, jD); jU = std::min(N - 1, jU);
+    }
+
+    float hL = height(iL, j);
+    float hR = height(iR, j);
+    float hD = height(i, jD);
+    float hU = height(i, jU);
+
+    float dhdx = (hR - hL) / (float(iR - iL) * g.dx);
+    float dhdz = (hU - hD) / (float(jU - jD) * g.dz);
+
+    glm::vec3 pos(x, hC, z);
+
+    // Normal from heightfield gradients
+    glm::vec3 n = glm::normalize(glm::vec3(-dhdx, 1.0f, -dhdz));
+
+    // Tangent along +X direction (dP/dx)
+    glm::vec3 t = glm::normalize(glm::vec3(1.0f, dhdx, 0.0f));
+
+    // Bitangent along +Z direction (dP/dz)
+    glm::vec3 b = glm::normalize(glm::vec3(0.0f, dhdz, 1.0f));
+
+    // Orthonormalize tangent to normal and compute sign
+    t = glm::normalize(t - n * glm::dot(n, t));
+    float sign = (glm::dot(glm::cross(n, t), b) < 0.0f) ? -1.0f : 1.0f;
+
+    // UV in world meters
+    glm::vec2 uv(x / g.uvWorldU, z / g.uvWorldV);
+
+    return { pos, n, uv, glm::vec4(t, sign) };
+}
+
+// Row j, written to out[remap[grid index]]
+static void VertexRowScalar(const HillGrid& g, int j, const std::uint32_t* remap, VertexPN* out)
+{
+    const std::size_t row = (std::size_t)j * g.N;
+    for (int i = 0; i < g.N; ++i)
+        out[remap[row + i]] = MakeHillVertex(g, i, j);
+}
+
+static void VertexRowSimd(const HillGrid& g, int j, const std::uint32_t* remap, VertexPN* out)
+{
+    const int N = g.N;
+    const std::size_t row = (std::size_t)j * N;
+
+    // Border columns keep their one-sided differences (seamless: their outside samples),
+    // and so do the first / last rows of a seamless grid
+    if (g.seamless && (j == 0 || j == N - 1)) {
+        VertexRowScalar(g, j, remap, out);
+        return;
+    }
+    out[remap[row]] = MakeHillVertex(g, 0, j);
+    out[remap[row + N - 1]] = MakeHillVertex(g, N - 1, j);
+
+    int i = 1;
+#if HILL_SSE2
+    const int jD = std::max(0, j - 1), jU = std::min(N - 1, j + 1);
+    const float* hRow = g.H + row;
+    const float* hDown = g.H + (std::size_t)jD * N;
+    const float* hUp = g.H + (std::size_t)jU * N;
+
+    const __m128 invX = _mm_set1_ps(1.0f / (2.0f * g.dx));
+    const __m128 invZ = _mm_set1_ps(1.0f / (float(jU - jD) * g.dz));
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    alignas(16) float nx[4], ny[4], nz[4], tx[4], ty[4], tz[4], sg[4];
+
+    for (; i + 4 <= N - 1; i += 4) {
+        const __m128 gx = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(hRow + i + 1), _mm_loadu_ps(hRow + i - 1)), invX);
+        const __m128 gz = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(hUp + i), _mm_loadu_ps(hDown + i)), invZ);
+
+        // n = normalize(-gx, 1, -gz)
+        const __m128 invL = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(gx, gx), one), _mm_mul_ps(gz, gz))));
+        const __m128 vnx = _mm_sub_ps(zero, _mm_mul_ps(gx, invL));
+        const __m128 vny = invL;
+        const __m128 vnz = _mm_sub_ps(zero, _mm_mul_ps(gz, invL));
+
+        // t = normalize(t0 - n * dot(n, t0)), t0 = (1, gx, 0) (its length cancels out)
+        const __m128 d = _mm_add_ps(vnx, _mm_mul_ps(vny, gx));
+        __m128 vtx = _mm_sub_ps(one, _mm_mul_ps(vnx, d));
+        __m128 vty = _mm_sub_ps(gx, _mm_mul_ps(vny, d));
+        __m128 vtz = _mm_sub_ps(zero, _mm_mul_ps(vnz, d));
+        const __m128 invT = _mm_div_ps(one, _mm_sqrt_ps(
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(vtx, vtx), _mm_mul_ps(vty, vty)), _mm_mul_ps(vtz, vtz))));
+        vtx = _mm_mul_ps(vtx, invT);
+        vty = _mm_mul_ps(vty, invT);
+        vtz = _mm_mul_ps(vtz, invT);
+
+        // sign = dot(cross(n, t), b) < 0 ? -1 : 1, b = (0, gz, 1) (length doesn't matter)
+        const __m128 cy = _mm_sub_ps(_mm_mul_ps(vnz, vtx), _mm_mul_ps(vnx, vtz));
+        const __m128 cz = _mm_sub_ps(_mm_mul_ps(vnx, vty), _mm_mul_ps(vny, vtx));
+        const __m128 neg = _mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(cy, gz), cz), zero);
+        const __m128 sign = _mm_or_ps(_mm_and_ps(neg, _mm_set1_ps(-1.0f)), _mm_andnot_ps(neg, one));
+
+        _mm_store_ps(nx, vnx); _mm_store_ps(ny, vny); _mm_store_ps(nz, vnz);
+        _mm_store_ps(tx, vtx); _mm_store_ps(ty, vty); _mm_store_ps(tz, vtz);
+        _mm_store_ps(sg, sign);
+
+        const float z = g.z0 + j * g.dz;
+        for (int k = 0; k < 4; ++k) {
+            const float x = g.x0 + (i + k) * g.dx;
+            VertexPN& v = out[remap[row + i + k]];
+            v.pos = glm::vec3(x, hRow[i + k], z);
+            v.normal = glm::vec3(nx[k], ny[k], nz[k]);
+            v.uv = glm::vec2(x / g.uvWorldU, z / g.uvWorldV);
+            v.tangent = glm::vec4(tx[k], ty[k], tz[k], sg[k]);
+        }
+    }
+#endif
+    for (; i < N - 1; ++i)
+        out[remap[row + i]] = MakeHillVertex(g, i, j);
+}
+
+// ---------------------------
+// Mesh
+// ---------------------------
+
+// Quads per band: two rows of (kBandQuads + 1) vertices must fit in the post-transform
+// cache. 14 gives ACMR ~0.54 with a 32-entry FIFO (0.97 at 16, where the rows just overflow).
+static const int kBandQuads = 14;
+
+HillMesh BuildHillMesh(
+    float baseY,
+    float halfSize,
+    int   gridN,
+    float uvWorldU,
+    float uvWorldV,
+    HillKernel kernel,
+    unsigned threads)
+{
+    return BuildHillPatch(baseY, -halfSize, -halfSize, 2.0f * halfSize, gridN, uvWorldU, uvWorldV,
+        false, kernel, threads);
+}
+
+HillMesh BuildHillPatch(
+    float baseY,
+    float x0,
+    float z0,
+    float size,
+    int   gridN,
+    float uvWorldU,
+    float uvWorldV,
+    bool  seamless,
+    HillKernel kernel,
+    unsigned threads,
+    std::vector<std::uint32_t>* gridToVertex)
+{
+    gridN = std::max(4, gridN);
+    uvWorldU = std::max(1e-6f, uvWorldU);
+    uvWorldV = std::max(1e-6f, uvWorldV);
+
+    const int N = gridN;
+    const float dx = size / float(N - 1);
+    const float dz = size / float(N - 1);
+
+    auto idx = [&](int i, int j) { return (std::uint32_t)(j * N + i); };
+
+    std::vector<float> H = BuildHeights(baseY, x0, z0, dx, N, kernel, threads);
+
+    HillMesh mesh;
+
+    // Vertex slots in first-use order of the band-by-band triangle walk: the vertex pass
+    // writes straight into them, so there is no reorder copy afterwards. Bands only share
+    // their first column with the previous band, so every band can number its own columns
+    // (starting after the (i0 + 1) * N vertices to its left) independently.
+    const int bands = (N - 2) / kBandQuads + 1;
+    const std::uint32_t kUnset = 0xffffffffu;
+    std::vector<std::uint32_t> remap((std::size_t)N * N, kUnset);
+
+    ParallelFor(bands, [&](int b0, int b1) {
+        for (int band = b0; band < b1; ++band) {
+            const int i0 = band * kBandQuads;
+            const int i1 = std::min(N - 1, i0 + kBandQuads);
+            const int firstNewCol = (band == 0) ? 0 : i0 + 1;
+            std::uint32_t next = (band == 0) ? 0u : (std::uint32_t)(i0 + 1) * (std::uint32_t)N;
+
+            auto claim = [&](int i, int j) {
+                if (i < firstNewCol) return;
+                std::uint32_t& r = remap[idx(i, j)];
+                if (r == kUnset) r = next++;
+            };
+
+            for (int j = 0; j < N - 1; ++j) {
+                for (int i = i0; i < i1; ++i) {
+                    claim(i, j); claim(i + 1, j); claim(i + 1, j + 1); claim(i, j + 1);
+                }
+            }
+        }
+    }, threads);
+
+    // Same triangles as the old unindexed list, visited band by band
+    mesh.indices.resize((std::size_t)(N - 1) * (N - 1) * 6);
+
+    ParallelFor(bands, [&](int b0, int b1) {
+        for (int band = b0; band < b1; ++band) {
+            const int i0 = band * kBandQuads;
+            const int i1 = std::min(N - 1, i0 + kBandQuads);
+            std::uint32_t* ix = mesh.indices.data() + (std::size_t)i0 * (N - 1) * 6;
+
+            for (int j = 0; j < N - 1; ++j) {
+                for (int i = i0; i < i1; ++i) {
+                    // Quad corners: (i,j)=00, (i+1,j)=10, (i+1,j+1)=11, (i,j+1)=01
+                    const std::uint32_t v00 = remap[idx(i, j)];
+                    const std::uint32_t v10 = remap[idx(i + 1, j)];
+                    const std::uint32_t v11 = remap[idx(i + 1, j + 1)];
+                    const std::uint32_t v01 = remap[idx(i, j + 1)];
+
+                    ix[0] = v00; ix[1] = v10; ix[2] = v11;
+                    ix[3] = v00; ix[4] = v11; ix[5] = v01;
+                    ix += 6;
+                }
+            }
+        }
+    }, threads);
+
+    mesh.vertices.resize((std::size_t)N * N);
+
+    const HillGrid g{ N, x0, z0, dx, dz, uvWorldU, uvWorldV, baseY, seamless, H.data() };
+    VertexPN* out = mesh.vertices.data();
+
+    ParallelFor(N, [&](int j0, int j1) {
+        for (int j = j0; j < j1; ++j) {
+            if (kernel == HillKernel::Simd) VertexRowSimd(g, j, remap.data(), out);
+            else                            VertexRowScalar(g, j, remap.data(), out);
+        }
+    }, threads);
+
+    if (gridToVertex) *gridToVertex = std::move(remap);
+    return mesh;
+}
+
+// ---------------------------
+// GPU-displaced ground
+// ---------------------------
+GroundGrid BuildGroundGrid(int cellsLog2, int lodCount)
+{
+    cellsLog2 = std::clamp(cellsLog2, 2, 11);
+    lodCount = std::clamp(lodCount, 1, cellsLog2 - 1);
+
+    const int cells = 1 << cellsLog2;
+    const int N = cells + 1;
+
+    GroundGrid grid;
+    grid.gridN = N;
+
+    // Plain row-major: every LOD reads a different subset, so no single first-use order helps
+    grid.vertices.resize((std::size_t)N * N);
+    for (int j = 0; j < N; ++j) {
+        for (int i = 0; i < N; ++i) {
+            const float u = float(i) / float(cells);
+            const float v = float(j) / float(cells);
+            grid.vertices[(std::size_t)j * N + i] = {
+                glm::vec3(u, 0.0f, v), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(u, v), glm::vec4(1.0f, 0.0f, 0.0f, -1.0f) };
+        }
+    }
+
+    // Same band walk as BuildHillMesh, in LOD cells
+    for (int k = 0; k < lodCount; ++k) {
+        const int step = 1 << k;
+        const int n = cells / step;
+
+        GroundGridLod lod;
+        lod.firstIndex = (std::uint32_t)grid.indices.size();
+        lod.cells = n;
+
+        auto idx = [&](int i, int j) { return (std::uint32_t)(j * step * N + i * step); };
+
+        for (int i0 = 0; i0 < n; i0 += kBandQuads) {
+            const int i1 = std::min(n, i0 + kBandQuads);
+            for (int j = 0; j < n; ++j) {
+                for (int i = i0; i < i1; ++i) {
+                    const std::uint32_t v00 = idx(i, j), v10 = idx(i + 1, j);
+                    const std::uint32_t v11 = idx(i + 1, j + 1), v01 = idx(i, j + 1);
+                    grid.indices.insert(grid.indices.end(), { v00, v10, v11, v00, v11, v01 });
+                }
+            }
+        }
+
+        lod.indexCount = (std::uint32_t)grid.indices.size() - lod.firstIndex;
+        grid.lods.push_back(lod);
+    }
+
+    return grid;
+}
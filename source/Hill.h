@@ -0,0 +1,84 @@
+//Hill.h
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "TreeGen.h" // VertexPN
+
+// ---------------------------
+// Hill mesh generation (Part 2)
+// Uses VertexPN = { pos, normal, uv, tangent } like tree.
+// Generates a gentle mound + subtle noise, centered at (0, baseY, 0).
+// ---------------------------
+
+// Indexed grid: one vertex per grid point, triangles in `indices`
+struct HillMesh {
+    std::vector<VertexPN> vertices;
+    std::vector<std::uint32_t> indices;
+};
+
+// Scalar: the original per-point loops (reference for the benchmark).
+// Simd:   4 points at a time (SSE2 where available, scalar otherwise) with polynomial
+//         exp/sin; heights agree with Scalar within float rounding (hill-bench
+//         measures max |dh| ~1.2e-7).
+enum class HillKernel { Scalar, Simd };
+
+float HillHeightFn(float x, float z, float baseY);
+
+// Heights of the whole grid, row-major (row j = z). threads == 0 -> all cores.
+std::vector<float> BuildHillHeights(float baseY, float halfSize, int gridN,
+    HillKernel kernel = HillKernel::Simd, unsigned threads = 0);
+
+// gridN x gridN points over [-halfSize, halfSize]^2. Triangles are emitted in column bands
+// (row by row inside each band) so the previous row is still in the post-transform cache,
+// and vertices are stored in first-use order so fetches walk memory forwards.
+// Heights and normals/tangents are computed rows-in-parallel.
+HillMesh BuildHillMesh(
+    float baseY,
+    float halfSize,
+    int   gridN,
+    float uvWorldU,
+    float uvWorldV,
+    HillKernel kernel = HillKernel::Simd,
+    unsigned threads = 0);
+
+// Same mesh over [x0, x0 + size] x [z0, z0 + size] (BuildHillMesh is the centered case).
+// seamless: border normals use heights just outside the patch instead of one-sided
+// differences, so neighbouring patches shade continuously across their shared edge.
+// gridToVertex (optional): vertex index of every grid point, row-major (j * gridN + i).
+HillMesh BuildHillPatch(
+    float baseY,
+    float x0,
+    float z0,
+    float size,
+    int   gridN,
+    float uvWorldU,
+    float uvWorldV,
+    bool  seamless,
+    HillKernel kernel = HillKernel::Simd,
+    unsigned threads = 0,
+    std::vector<std::uint32_t>* gridToVertex = nullptr);
+
+// ---------------------------
+// GPU-displaced ground
+// One flat grid over the unit square (pos = (u, 0, v)), uploaded once. The material
+// vertex shader places it over [-halfSize, halfSize]^2, adds the hill function and the
+// displacement map, and derives normals/tangents from neighbouring height samples.
+// lods[k] triangulates every 2^k-th row/column of the same vertices, so the ground
+// resolution can change at draw time by picking an index range.
+// ---------------------------
+struct GroundGridLod {
+    std::uint32_t firstIndex = 0;
+    std::uint32_t indexCount = 0;
+    int           cells = 0;       // quads per side at this LOD
+};
+
+struct GroundGrid {
+    int gridN = 0;                 // points per side (2^cellsLog2 + 1)
+    std::vector<VertexPN> vertices;
+    std::vector<std::uint32_t> indices;
+    std::vector<GroundGridLod> lods; // lods[0] = full resolution
+};
+
+// cellsLog2 in [2, 11], lodCount clamped so the coarsest LOD keeps at least 4 quads per side
+GroundGrid BuildGroundGrid(int cellsLog2, int lodCount);
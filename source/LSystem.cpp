@@ -1,7 +1,6 @@
 //LSystem.cpp
 #include "LSystem.h"
 
-#include <numeric>  // std::accumulate
 
 LSystem::LSystem() : m_axiom("") {
     // Seed RNG with non-deterministic seed
@@ -28,66 +27,78 @@ void LSystem::addRule(char predecessor, const std::string& successor, float prob
 
 void LSystem::clearRules() { m_rules.clear(); }
 
-std::string LSystem::generate(int iterations) const {
-    std::string current = m_axiom;
-    if (iterations <= 0) {
-        return current;
+static bool IsCancelled(const std::atomic<bool>* cancel) {
+    return cancel && cancel->load(std::memory_order_relaxed);
+}
+
+std::string LSystem::generate(int iterations, const std::atomic<bool>* cancel) const {
+    // Same rewrite as the shared form; compiling ~10 rules costs nothing next to the passes
+    std::string out, scratch;
+    LGrammar(*this).generate(iterations, m_rng, out, scratch, cancel);
+    return out;
+}
+
+// ---------------------------
+// LGrammar
+// ---------------------------
+LGrammar::LGrammar(const LSystem& lsys) : m_axiom(lsys.axiom()), m_slots(256) {
+    for (const auto& entry : lsys.rules()) {
+        Slot& slot = m_slots[(unsigned char)entry.first];
+        // Summed in rule order, the same float additions LSystem did per symbol
+        for (const LRule& r : entry.second) {
+            slot.total += r.probability;
+            slot.choices.push_back({ r.successor, slot.total });
+        }
     }
+}
 
+void LGrammar::generate(int iterations, std::mt19937& rng, std::string& out, std::string& scratch,
+    const std::atomic<bool>* cancel) const {
+    out = m_axiom;
     for (int i = 0; i < iterations; ++i) {
-        current = applyOnce(current);
+        if (IsCancelled(cancel)) break;
+        applyOnce(out, rng, scratch, cancel);
+        out.swap(scratch);
     }
-    return current;
 }
 
-std::string LSystem::applyOnce(const std::string& input) const {
-    std::string output;
+void LGrammar::applyOnce(const std::string& input, std::mt19937& rng, std::string& output,
+    const std::atomic<bool>* cancel) const {
+    output.clear();
     // Reserve a bit more than input size as a heuristic to avoid repeated reallocations
     output.reserve(input.size() * 2);
 
+    std::size_t n = 0;
     for (char c : input) {
-        auto it = m_rules.find(c);
-        if (it == m_rules.end() || it->second.empty()) {
+        // Late iterations can be 100M+ symbols, so poll the cancel flag inside the pass too
+        if ((++n & 0xFFFF) == 0 && IsCancelled(cancel)) break;
+
+        const Slot& slot = m_slots[(unsigned char)c];
+        if (slot.choices.empty()) {
             // No rule for this symbol: copy it unchanged
             output.push_back(c);
         }
+        else if (slot.choices.size() == 1) {
+            // Deterministic: only one possible replacement
+            output.append(slot.choices[0].successor);
+        }
+        else if (slot.total <= 0.0f) {
+            // Fallback: if probabilities are all zero, shouldn't happen, keep symbol
+            output.push_back(c);
+        }
         else {
-            const auto& rulesForSymbol = it->second;
-
-            if (rulesForSymbol.size() == 1) {
-                // Deterministic: only one possible replacement
-                output.append(rulesForSymbol[0].successor);
-            }
-            else {
-                // Non-deterministic: pick one rule based on probabilities
-                float totalProb = 0.0f;
-                for (const auto& r : rulesForSymbol) {
-                    totalProb += r.probability;
+            // Non-deterministic: pick one rule based on probabilities
+            std::uniform_real_distribution<float> dist(0.0f, slot.total);
+            const float rValue = dist(rng);
+
+            const Choice* chosen = &slot.choices.back();  // default fallback
+            for (const Choice& choice : slot.choices) {
+                if (rValue <= choice.cumulative) {
+                    chosen = &choice;
+                    break;
                 }
-
-                if (totalProb <= 0.0f) {
-                    // Fallback: if probabilities are all zero, shouldn't happen, keep symbol
-                    output.push_back(c);
-                    continue;
-                }
-
-                std::uniform_real_distribution<float> dist(0.0f, totalProb);
-                float rValue = dist(m_rng);
-
-                float accum = 0.0f;
-                const LRule* chosenRule = &rulesForSymbol.back();  // default fallback
-                for (const auto& r : rulesForSymbol) {
-                    accum += r.probability;
-                    if (rValue <= accum) {
-                        chosenRule = &r;
-                        break;
-                    }
-                }
-
-                output.append(chosenRule->successor);
             }
+            output.append(chosen->successor);
         }
     }
-
-    return output;
 }
@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 #include <cstdint> 
+#include <atomic>
 
 // A single production rule: X -> successor with a given probability
 struct LRule {
@@ -30,12 +31,15 @@ public:
 	// Seed control for reproducible stochastic rewriting
 	void setSeed(std::uint32_t seed);
 
-	// Generate the final string after `iterations` parallel rewrites
-	std::string generate(int iterations) const;
+	// Generate the final string after `iterations` parallel rewrites.
+	// If `cancel` is given and becomes true, stops early and returns a partial string
+	// (the caller is expected to check the flag and throw the result away).
+	std::string generate(int iterations, const std::atomic<bool>* cancel = nullptr) const;
 
-private:
-	std::string applyOnce(const std::string& input) const;
+	const std::string& axiom() const { return m_axiom; }
+	const std::map<char, std::vector<LRule>>& rules() const { return m_rules; }
 
+private:
 	std::string m_axiom;
 	// For each symbol, we store a list of possible rules (for non-determinism)
 	std::map<char, std::vector<LRule>> m_rules;
@@ -43,3 +47,34 @@ private:
 	// RNG is mutable because generation conceptually doesn't change the L-system definition
 	mutable std::mt19937 m_rng;
 };
+
+// Read-only form of an LSystem's axiom + rules: one table slot per symbol, rule weights
+// summed in advance, and no RNG inside. One instance can be shared by any number of
+// threads; each generate() call brings its own RNG and buffers.
+// Rewrites exactly like LSystem::generate with an RNG seeded the same way.
+class LGrammar {
+public:
+	explicit LGrammar(const LSystem& lsys);
+
+	// `out` gets the sentence, `scratch` is the other half of the ping-pong. Both keep
+	// their capacity, so a caller that reuses them stops allocating after its longest sentence.
+	// Cancel behaves like LSystem::generate (partial sentence, caller checks the flag).
+	void generate(int iterations, std::mt19937& rng, std::string& out, std::string& scratch,
+		const std::atomic<bool>* cancel = nullptr) const;
+
+private:
+	struct Choice {
+		std::string successor;
+		float cumulative; // running sum of the weights up to this rule
+	};
+	struct Slot {
+		std::vector<Choice> choices; // empty: the symbol copies itself
+		float total = 0.0f;
+	};
+
+	void applyOnce(const std::string& input, std::mt19937& rng, std::string& output,
+		const std::atomic<bool>* cancel) const;
+
+	std::string m_axiom;
+	std::vector<Slot> m_slots; // 256, indexed by (unsigned char) symbol
+};
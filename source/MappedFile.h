@@ -0,0 +1,34 @@
+//MappedFile.h
+#pragma once
+#include <cstddef>
+#include <filesystem>
+
+// Read-only memory-mapped file (mmap on POSIX, file mapping on Windows).
+// Pages come straight from the OS file cache, so nothing is parsed or copied up front.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns false (and stays closed) if the file is missing, empty or can't be mapped
+    bool open(const std::filesystem::path& path);
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+    const unsigned char* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+
+private:
+    const unsigned char* m_data = nullptr;
+    std::size_t m_size = 0;
+
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
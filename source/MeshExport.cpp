@@ -0,0 +1,432 @@
+//MeshExport.cpp
+#include "MeshExport.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+
+// Big stdio buffer: a 1M-vertex tree is ~150 MB of text
+static constexpr std::size_t kObjBufferBytes = 1 << 20;
+
+ObjStreamWriter::~ObjStreamWriter()
+{
+    if (m_file) std::fclose(m_file);
+}
+
+bool ObjStreamWriter::open(const std::string& path, const std::string& header)
+{
+    if (m_file) std::fclose(m_file);
+    m_count = 0;
+
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file) return false;
+    std::setvbuf(m_file, nullptr, _IOFBF, kObjBufferBytes);
+
+    if (!header.empty()) std::fprintf(m_file, "# %s\n", header.c_str());
+    std::fprintf(m_file, "o tree\n");
+    return true;
+}
+
+void ObjStreamWriter::append(const VertexPN* verts, std::size_t count)
+{
+    if (!m_file) return;
+
+    // v / vt / vn share one index per vertex (the mesh is unindexed)
+    for (std::size_t i = 0; i < count; ++i) {
+        const VertexPN& v = verts[i];
+        std::fprintf(m_file, "v %.6g %.6g %.6g\nvt %.6g %.6g\nvn %.4g %.4g %.4g\n",
+            v.pos.x, v.pos.y, v.pos.z, v.uv.x, v.uv.y, v.normal.x, v.normal.y, v.normal.z);
+    }
+    m_count += count;
+}
+
+bool ObjStreamWriter::close()
+{
+    if (!m_file) return false;
+
+    for (std::size_t i = 1; i + 2 <= m_count; i += 3)
+        std::fprintf(m_file, "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", i, i, i, i + 1, i + 1, i + 1, i + 2, i + 2, i + 2);
+
+    const bool ok = !std::ferror(m_file);
+    const bool closed = std::fclose(m_file) == 0;
+    m_file = nullptr;
+    return ok && closed;
+}
+
+// ---------------------------
+// GLB
+// ---------------------------
+namespace {
+
+// JSON chunk space reserved at open(): one mesh with its material is under 2 KB
+constexpr std::uint32_t kGlbJsonReserve = 16 * 1024;
+constexpr std::uint64_t kGlbHeaderBytes = 12 + 8 + kGlbJsonReserve + 8; // header, JSON chunk, BIN chunk header
+constexpr std::uint32_t kGlbMagic = 0x46546C67;     // "glTF"
+constexpr std::uint32_t kGlbChunkJson = 0x4E4F534A; // "JSON"
+constexpr std::uint32_t kGlbChunkBin = 0x004E4942;  // "BIN\0"
+
+struct GlbVertex {
+    float pos[3];
+    std::int8_t normal[4];   // xyz, pad
+    std::int8_t tangent[4];  // xyz, w = handedness
+    float uv[2];
+};
+static_assert(sizeof(GlbVertex) == 28, "GLB vertex layout is 28 bytes");
+
+std::int8_t Snorm8(float v)
+{
+    return (std::int8_t)std::lround(std::clamp(v, -1.0f, 1.0f) * 127.0f);
+}
+
+GlbVertex Quantize(const VertexPN& v)
+{
+    GlbVertex q{};
+    q.pos[0] = v.pos.x;
+    q.pos[1] = v.pos.y;
+    q.pos[2] = v.pos.z;
+    q.normal[0] = Snorm8(v.normal.x);
+    q.normal[1] = Snorm8(v.normal.y);
+    q.normal[2] = Snorm8(v.normal.z);
+    q.tangent[0] = Snorm8(v.tangent.x);
+    q.tangent[1] = Snorm8(v.tangent.y);
+    q.tangent[2] = Snorm8(v.tangent.z);
+    q.tangent[3] = v.tangent.w < 0.0f ? -127 : 127;
+    q.uv[0] = v.uv.x;
+    q.uv[1] = 1.0f - v.uv.y; // glTF puts v = 0 at the top of the image, GL at the bottom
+    return q;
+}
+
+std::uint64_t HashGlbVertex(const GlbVertex& v)
+{
+    std::uint32_t w[7];
+    std::memcpy(w, &v, sizeof(w));
+    std::uint64_t h = 0x9E3779B97F4A7C15ull;
+    for (std::uint32_t x : w) h = (h ^ x) * 0xFF51AFD7ED558CCDull;
+    return h ^ (h >> 32);
+}
+
+void PutU32(unsigned char* dst, std::uint32_t v)
+{
+    std::memcpy(dst, &v, 4); // GLB is little endian, like every target this builds for
+}
+
+std::string JsonEscape(const std::string& s)
+{
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        if ((unsigned char)c < 0x20) continue;
+        out += c;
+    }
+    return out;
+}
+
+} // namespace
+
+std::string GlbTextureUri(const std::string& glbPath, const std::string& file)
+{
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    const fs::path dir = fs::absolute(glbPath, ec).parent_path();
+    fs::path rel = fs::relative(fs::absolute(file, ec), dir, ec);
+    if (ec || rel.empty()) rel = fs::path(file);
+
+    static const char* kHex = "0123456789ABCDEF";
+    std::string uri;
+    for (unsigned char c : rel.generic_string()) {
+        if (std::isalnum(c) || c == '-' || c == '.' || c == '_' || c == '~' || c == '/') uri += (char)c;
+        else {
+            uri += '%';
+            uri += kHex[c >> 4];
+            uri += kHex[c & 15];
+        }
+    }
+    return uri;
+}
+
+GlbStreamWriter::~GlbStreamWriter()
+{
+    if (m_indices) std::fclose(m_indices);
+    if (m_file) {
+        // Never finished: don't leave a GLB with an empty JSON chunk behind
+        std::fclose(m_file);
+        std::remove(m_path.c_str());
+    }
+}
+
+bool GlbStreamWriter::open(const std::string& path)
+{
+    m_path = path;
+    m_meshes.clear();
+    m_inMesh = false;
+    m_vertexBytes = m_indexBytes = 0;
+
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file) return false;
+    m_indices = std::tmpfile();
+    if (!m_indices) {
+        std::fclose(m_file);
+        m_file = nullptr;
+        std::remove(path.c_str());
+        return false;
+    }
+    std::setvbuf(m_file, nullptr, _IOFBF, kObjBufferBytes);
+
+    // Header + JSON chunk + BIN chunk header are filled in by close()
+    static const unsigned char kZeros[1024] = {};
+    for (std::uint64_t left = kGlbHeaderBytes; left > 0;) {
+        const std::size_t n = (std::size_t)std::min<std::uint64_t>(left, sizeof(kZeros));
+        std::fwrite(kZeros, 1, n, m_file);
+        left -= n;
+    }
+    return true;
+}
+
+void GlbStreamWriter::beginMesh(const std::string& name, const GlbMaterial& material)
+{
+    if (m_inMesh) endMesh();
+
+    Mesh m;
+    m.name = name;
+    m.material = material;
+    m.vertexOffset = m_vertexBytes;
+    m.indexOffset = m_indexBytes;
+    m_meshes.push_back(m);
+    m_inMesh = true;
+}
+
+// Writes the first `count` quantized vertices in m_unique to the current mesh
+void GlbStreamWriter::writeVertices(std::size_t count)
+{
+    Mesh& m = m_meshes.back();
+    const GlbVertex* q = reinterpret_cast<const GlbVertex*>(m_unique.data());
+    for (std::size_t i = 0; i < count; ++i) {
+        const glm::vec3 p(q[i].pos[0], q[i].pos[1], q[i].pos[2]);
+        m.lo = (m.vertexCount == 0 && i == 0) ? p : glm::min(m.lo, p);
+        m.hi = (m.vertexCount == 0 && i == 0) ? p : glm::max(m.hi, p);
+    }
+    std::fwrite(q, sizeof(GlbVertex), count, m_file);
+    m.vertexCount += count;
+    m_vertexBytes += (std::uint64_t)count * sizeof(GlbVertex);
+}
+
+void GlbStreamWriter::appendTriangles(const VertexPN* verts, std::size_t count)
+{
+    if (!m_file || !m_inMesh || count == 0) return;
+    Mesh& m = m_meshes.back();
+
+    // Weld inside this chunk only (open addressing over local ids, at most half full)
+    constexpr std::uint32_t kEmpty = 0xFFFFFFFFu;
+    std::size_t slots = 16;
+    while (slots < count * 2) slots *= 2;
+    m_table.assign(slots, kEmpty);
+    m_unique.clear();
+    m_chunkIndices.resize(count);
+
+    const std::uint32_t base = (std::uint32_t)m.vertexCount;
+    std::uint32_t unique = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const GlbVertex q = Quantize(verts[i]);
+        std::size_t s = (std::size_t)HashGlbVertex(q) & (slots - 1);
+        for (;;) {
+            const std::uint32_t id = m_table[s];
+            if (id == kEmpty) {
+                m_table[s] = unique;
+                m_unique.insert(m_unique.end(), reinterpret_cast<const unsigned char*>(&q),
+                    reinterpret_cast<const unsigned char*>(&q) + sizeof(q));
+                m_chunkIndices[i] = base + unique++;
+                break;
+            }
+            if (std::memcmp(m_unique.data() + (std::size_t)id * sizeof(GlbVertex), &q, sizeof(q)) == 0) {
+                m_chunkIndices[i] = base + id;
+                break;
+            }
+            s = (s + 1) & (slots - 1);
+        }
+    }
+
+    writeVertices(unique);
+    std::fwrite(m_chunkIndices.data(), sizeof(std::uint32_t), count, m_indices);
+    m.indexCount += count;
+    m_indexBytes += (std::uint64_t)count * sizeof(std::uint32_t);
+}
+
+void GlbStreamWriter::appendIndexed(const VertexPN* verts, std::size_t count,
+    const std::uint32_t* indices, std::size_t indexCount)
+{
+    if (!m_file || !m_inMesh || count == 0) return;
+    Mesh& m = m_meshes.back();
+
+    const std::uint32_t base = (std::uint32_t)m.vertexCount;
+    m_unique.resize(count * sizeof(GlbVertex));
+    GlbVertex* q = reinterpret_cast<GlbVertex*>(m_unique.data());
+    for (std::size_t i = 0; i < count; ++i) q[i] = Quantize(verts[i]);
+    writeVertices(count);
+
+    m_chunkIndices.resize(indexCount);
+    for (std::size_t i = 0; i < indexCount; ++i) m_chunkIndices[i] = base + indices[i];
+    std::fwrite(m_chunkIndices.data(), sizeof(std::uint32_t), indexCount, m_indices);
+    m.indexCount += indexCount;
+    m_indexBytes += (std::uint64_t)indexCount * sizeof(std::uint32_t);
+}
+
+void GlbStreamWriter::endMesh()
+{
+    if (!m_inMesh) return;
+    m_inMesh = false;
+    if (m_meshes.back().indexCount == 0) m_meshes.pop_back(); // accessors can't be empty
+}
+
+std::size_t GlbStreamWriter::vertexCount() const
+{
+    std::size_t n = 0;
+    for (const Mesh& m : m_meshes) n += (std::size_t)m.vertexCount;
+    return n;
+}
+
+std::size_t GlbStreamWriter::indexCount() const
+{
+    std::size_t n = 0;
+    for (const Mesh& m : m_meshes) n += (std::size_t)m.indexCount;
+    return n;
+}
+
+std::string GlbStreamWriter::buildJson(std::uint64_t binBytes) const
+{
+    std::ostringstream js;
+    js.precision(9); // round-trips a float
+
+    // Images are shared between materials that name the same file
+    std::vector<std::string> images;
+    auto texture = [&](const std::string& uri) {
+        auto it = std::find(images.begin(), images.end(), uri);
+        if (it != images.end()) return (int)(it - images.begin());
+        images.push_back(uri);
+        return (int)images.size() - 1;
+    };
+
+    std::ostringstream meshes, materials, accessors, views, nodes;
+    accessors.precision(9);
+    materials.precision(9);
+    for (std::size_t i = 0; i < m_meshes.size(); ++i) {
+        const Mesh& m = m_meshes[i];
+        const std::size_t a = i * 5, v = i * 2;
+        const char* sep = i ? ",\n    " : "\n    ";
+
+        views << sep << "{\"buffer\": 0, \"byteOffset\": " << m.vertexOffset << ", \"byteLength\": "
+            << m.vertexCount * sizeof(GlbVertex) << ", \"byteStride\": " << sizeof(GlbVertex) << ", \"target\": 34962},\n"
+            << "    {\"buffer\": 0, \"byteOffset\": " << m_vertexBytes + m.indexOffset << ", \"byteLength\": "
+            << m.indexCount * sizeof(std::uint32_t) << ", \"target\": 34963}";
+
+        accessors << sep
+            << "{\"bufferView\": " << v << ", \"byteOffset\": 0, \"componentType\": 5126, \"count\": " << m.vertexCount
+            << ", \"type\": \"VEC3\", \"min\": [" << m.lo.x << ", " << m.lo.y << ", " << m.lo.z << "], \"max\": ["
+            << m.hi.x << ", " << m.hi.y << ", " << m.hi.z << "]},\n"
+            << "    {\"bufferView\": " << v << ", \"byteOffset\": 12, \"componentType\": 5120, \"normalized\": true, \"count\": "
+            << m.vertexCount << ", \"type\": \"VEC3\"},\n"
+            << "    {\"bufferView\": " << v << ", \"byteOffset\": 16, \"componentType\": 5120, \"normalized\": true, \"count\": "
+            << m.vertexCount << ", \"type\": \"VEC4\"},\n"
+            << "    {\"bufferView\": " << v << ", \"byteOffset\": 20, \"componentType\": 5126, \"count\": " << m.vertexCount
+            << ", \"type\": \"VEC2\"},\n"
+            << "    {\"bufferView\": " << v + 1 << ", \"componentType\": 5125, \"count\": " << m.indexCount
+            << ", \"type\": \"SCALAR\"}";
+
+        meshes << sep << "{\"name\": \"" << JsonEscape(m.name) << "\", \"primitives\": [{\"attributes\": {\"POSITION\": "
+            << a << ", \"NORMAL\": " << a + 1 << ", \"TANGENT\": " << a + 2 << ", \"TEXCOORD_0\": " << a + 3
+            << "}, \"indices\": " << a + 4 << ", \"material\": " << i << ", \"mode\": 4}]}";
+
+        nodes << sep << "{\"name\": \"" << JsonEscape(m.name) << "\", \"mesh\": " << i << "}";
+
+        const GlbMaterial& mat = m.material;
+        materials << sep << "{\"name\": \"" << JsonEscape(mat.name) << "\", \"pbrMetallicRoughness\": {\"baseColorFactor\": ["
+            << mat.baseColor.x << ", " << mat.baseColor.y << ", " << mat.baseColor.z << ", 1], \"metallicFactor\": 0, \"roughnessFactor\": "
+            << mat.roughness;
+        if (!mat.baseColorUri.empty()) materials << ", \"baseColorTexture\": {\"index\": " << texture(mat.baseColorUri) << "}";
+        if (!mat.roughnessUri.empty()) materials << ", \"metallicRoughnessTexture\": {\"index\": " << texture(mat.roughnessUri) << "}";
+        materials << "}";
+        if (!mat.normalUri.empty()) materials << ", \"normalTexture\": {\"index\": " << texture(mat.normalUri) << "}";
+        materials << "}";
+    }
+
+    js << "{\n  \"asset\": {\"version\": \"2.0\", \"generator\": \"LSystemTree\"},\n"
+        << "  \"extensionsUsed\": [\"KHR_mesh_quantization\"],\n"
+        << "  \"extensionsRequired\": [\"KHR_mesh_quantization\"],\n"
+        << "  \"scene\": 0,\n  \"scenes\": [{\"nodes\": [";
+    for (std::size_t i = 0; i < m_meshes.size(); ++i) js << (i ? ", " : "") << i;
+    js << "]}],\n"
+        << "  \"nodes\": [" << nodes.str() << "\n  ],\n"
+        << "  \"meshes\": [" << meshes.str() << "\n  ],\n"
+        << "  \"materials\": [" << materials.str() << "\n  ],\n";
+    if (!images.empty()) {
+        js << "  \"samplers\": [{\"magFilter\": 9729, \"minFilter\": 9987, \"wrapS\": 10497, \"wrapT\": 10497}],\n"
+            << "  \"images\": [";
+        for (std::size_t i = 0; i < images.size(); ++i)
+            js << (i ? ", " : "") << "{\"uri\": \"" << JsonEscape(images[i]) << "\"}";
+        js << "],\n  \"textures\": [";
+        for (std::size_t i = 0; i < images.size(); ++i)
+            js << (i ? ", " : "") << "{\"sampler\": 0, \"source\": " << i << "}";
+        js << "],\n";
+    }
+    js << "  \"accessors\": [" << accessors.str() << "\n  ],\n"
+        << "  \"bufferViews\": [" << views.str() << "\n  ],\n"
+        << "  \"buffers\": [{\"byteLength\": " << binBytes << "}]\n}\n";
+    return js.str();
+}
+
+bool GlbStreamWriter::close()
+{
+    if (!m_file) return false;
+    if (m_inMesh) endMesh();
+
+    bool ok = !m_meshes.empty();
+
+    // Indices go after all vertex data
+    std::rewind(m_indices);
+    std::vector<unsigned char> block(kObjBufferBytes);
+    for (std::size_t n; ok && (n = std::fread(block.data(), 1, block.size(), m_indices)) > 0;)
+        std::fwrite(block.data(), 1, n, m_file);
+    ok = ok && !std::ferror(m_indices);
+    std::fclose(m_indices);
+    m_indices = nullptr;
+
+    const std::uint64_t binBytes = m_vertexBytes + m_indexBytes; // both multiples of 4
+    const std::uint64_t total = kGlbHeaderBytes + binBytes;
+    if (total > 0xFFFFFFFFull) {
+        std::fprintf(stderr, "%s: %llu bytes is past the 4 GB a GLB can hold\n", m_path.c_str(), (unsigned long long)total);
+        ok = false;
+    }
+
+    std::string json = ok ? buildJson(binBytes) : std::string();
+    if (json.size() > kGlbJsonReserve) {
+        std::fprintf(stderr, "%s: glTF JSON (%zu bytes) doesn't fit the reserved %u\n", m_path.c_str(), json.size(), kGlbJsonReserve);
+        ok = false;
+    }
+
+    if (ok) {
+        json.resize(kGlbJsonReserve, ' '); // trailing spaces are the GLB padding anyway
+
+        unsigned char head[20];
+        PutU32(head + 0, kGlbMagic);
+        PutU32(head + 4, 2);
+        PutU32(head + 8, (std::uint32_t)total);
+        PutU32(head + 12, kGlbJsonReserve);
+        PutU32(head + 16, kGlbChunkJson);
+        unsigned char binHead[8];
+        PutU32(binHead + 0, (std::uint32_t)binBytes);
+        PutU32(binHead + 4, kGlbChunkBin);
+
+        ok = std::fseek(m_file, 0, SEEK_SET) == 0;
+        std::fwrite(head, 1, sizeof(head), m_file);
+        std::fwrite(json.data(), 1, json.size(), m_file);
+        std::fwrite(binHead, 1, sizeof(binHead), m_file);
+        ok = ok && !std::ferror(m_file);
+    }
+
+    ok = (std::fclose(m_file) == 0) && ok;
+    m_file = nullptr;
+    if (!ok) std::remove(m_path.c_str());
+    return ok;
+}
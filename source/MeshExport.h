@@ -0,0 +1,114 @@
+//MeshExport.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "TreeGen.h"
+
+// ---------------------------
+// Wavefront OBJ, written while the tree is being built
+// Vertex lines (v / vt / vn) go out chunk by chunk; the faces of the triangle list
+// (1 2 3, 4 5 6, ...) only need the final count, so they are written by close().
+// Nothing of the mesh is kept in memory, so chunk sizes don't matter (any count, in order).
+// ---------------------------
+class ObjStreamWriter {
+public:
+    ObjStreamWriter() = default;
+    ~ObjStreamWriter();
+
+    ObjStreamWriter(const ObjStreamWriter&) = delete;
+    ObjStreamWriter& operator=(const ObjStreamWriter&) = delete;
+
+    // `header` becomes a comment line at the top (e.g. preset / seed). False if the file can't be created.
+    bool open(const std::string& path, const std::string& header = std::string());
+
+    void append(const VertexPN* verts, std::size_t count);
+
+    // Writes the faces and closes the file. False if any write failed (disk full, ...).
+    bool close();
+
+    std::size_t vertexCount() const { return m_count; }
+
+private:
+    std::FILE* m_file = nullptr;
+    std::size_t m_count = 0;
+};
+
+// ---------------------------
+// glTF 2.0 binary (.glb), also written while the meshes are being built
+// Every mesh is one indexed primitive in a KHR_mesh_quantization layout, 28 bytes interleaved:
+//   POSITION float3 | NORMAL byte3 normalized (+1 pad) | TANGENT byte4 normalized | TEXCOORD_0 float2
+// (UVs stay float: bark V is in world-space repeats and runs far past what normalized shorts hold.)
+//
+// Vertices go into the file as they arrive; triangle-list chunks are welded chunk by chunk,
+// which catches nearly all duplicates since rings and caps are emitted together. Indices
+// are spooled to a temp file and appended at close(), which also fills in the JSON chunk
+// (it comes first in a GLB) in space reserved at open(). Memory stays at about one chunk.
+// ---------------------------
+struct GlbMaterial {
+    std::string name;
+    glm::vec3 baseColor = glm::vec3(1.0f);
+    float roughness = 1.0f;
+    // Image URIs relative to the .glb, "" = none (see GlbTextureUri)
+    std::string baseColorUri;
+    std::string normalUri;
+    std::string roughnessUri; // grayscale map: used as metallicRoughness with metallic forced to 0
+};
+
+// `file` as a URI relative to the directory of `glbPath` ('/' separators, percent-encoded)
+std::string GlbTextureUri(const std::string& glbPath, const std::string& file);
+
+class GlbStreamWriter {
+public:
+    GlbStreamWriter() = default;
+    ~GlbStreamWriter();
+
+    GlbStreamWriter(const GlbStreamWriter&) = delete;
+    GlbStreamWriter& operator=(const GlbStreamWriter&) = delete;
+
+    bool open(const std::string& path);
+
+    // Meshes are written one after another, each becomes a node of the scene
+    void beginMesh(const std::string& name, const GlbMaterial& material);
+    void appendTriangles(const VertexPN* verts, std::size_t count);   // triangle-list chunk, any size
+    void appendIndexed(const VertexPN* verts, std::size_t count,      // indices into this call's verts
+        const std::uint32_t* indices, std::size_t indexCount);
+    void endMesh();
+
+    // Indices + JSON + header. False on any write error or past the 4 GB GLB limit.
+    bool close();
+
+    std::size_t vertexCount() const;  // written so far, after welding
+    std::size_t indexCount() const;
+
+private:
+    struct Mesh {
+        std::string name;
+        GlbMaterial material;
+        std::uint64_t vertexOffset = 0; // in the BIN chunk
+        std::uint64_t vertexCount = 0;
+        std::uint64_t indexOffset = 0;  // in the index spool
+        std::uint64_t indexCount = 0;
+        glm::vec3 lo = glm::vec3(0.0f);
+        glm::vec3 hi = glm::vec3(0.0f);
+    };
+
+    void writeVertices(std::size_t count); // from m_unique
+    std::string buildJson(std::uint64_t binBytes) const;
+
+    std::FILE* m_file = nullptr;
+    std::FILE* m_indices = nullptr; // spool
+    std::string m_path;
+    std::vector<Mesh> m_meshes;
+    bool m_inMesh = false;
+    std::uint64_t m_vertexBytes = 0;
+    std::uint64_t m_indexBytes = 0;
+
+    // Per-chunk weld scratch, reused
+    std::vector<std::uint32_t> m_table;
+    std::vector<unsigned char> m_unique;
+    std::vector<std::uint32_t> m_chunkIndices;
+};
@@ -0,0 +1,139 @@
+//RenderState.cpp
+#include "RenderState.h"
+
+void RenderState::beginFrame()
+{
+    m_stats = RenderStats{};
+    invalidate();
+}
+
+void RenderState::invalidate()
+{
+    m_program = m_vao = m_activeUnit = kUnknown;
+    for (int i = 0; i < kMaxTextureUnits; ++i) m_tex2D[i] = m_texCube[i] = kUnknown;
+    for (UniformRange& r : m_uniformRanges) r = UniformRange{};
+
+    m_blend = m_blendSrc = m_blendDst = kUnknown;
+    m_depthTest = m_depthMask = m_depthFunc = m_colorMask = kUnknown;
+}
+
+bool RenderState::changed(int& cached, int value)
+{
+    ++m_stats.requests;
+    if (cached == value) return false;
+    cached = value;
+    ++m_stats.stateChanges;
+    return true;
+}
+
+void RenderState::useProgram(GLuint prog)
+{
+    if (changed(m_program, (int)prog)) glUseProgram(prog);
+}
+
+void RenderState::bindVertexArray(GLuint vao)
+{
+    if (changed(m_vao, (int)vao)) glBindVertexArray(vao);
+}
+
+void RenderState::bindTexture(int unit, GLenum target, GLuint tex)
+{
+    if (unit < 0 || unit >= kMaxTextureUnits) {
+        // Out of the tracked range: always issue
+        ++m_stats.requests;
+        ++m_stats.stateChanges;
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, tex);
+        m_activeUnit = unit;
+        return;
+    }
+
+    int& cached = (target == GL_TEXTURE_CUBE_MAP) ? m_texCube[unit] : m_tex2D[unit];
+    if (!changed(cached, (int)tex)) return;
+
+    // Switching the active unit is only needed when a bind actually happens
+    if (m_activeUnit != unit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        m_activeUnit = unit;
+        ++m_stats.requests;
+        ++m_stats.stateChanges;
+    }
+    glBindTexture(target, tex);
+}
+
+void RenderState::bindUniformRange(GLuint binding, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+    ++m_stats.requests;
+    if (binding < (GLuint)kMaxUniformBindings) {
+        UniformRange& r = m_uniformRanges[binding];
+        if (r.buffer == buffer && r.offset == offset && r.size == size) return;
+        r = UniformRange{ buffer, offset, size };
+    }
+    ++m_stats.stateChanges;
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size);
+}
+
+void RenderState::setBlend(bool on)
+{
+    if (changed(m_blend, on ? 1 : 0)) {
+        if (on) glEnable(GL_BLEND);
+        else    glDisable(GL_BLEND);
+    }
+}
+
+void RenderState::setBlendFunc(GLenum src, GLenum dst)
+{
+    ++m_stats.requests;
+    if (m_blendSrc == (int)src && m_blendDst == (int)dst) return;
+    m_blendSrc = (int)src;
+    m_blendDst = (int)dst;
+    ++m_stats.stateChanges;
+    glBlendFunc(src, dst);
+}
+
+void RenderState::setDepthTest(bool on)
+{
+    if (changed(m_depthTest, on ? 1 : 0)) {
+        if (on) glEnable(GL_DEPTH_TEST);
+        else    glDisable(GL_DEPTH_TEST);
+    }
+}
+
+void RenderState::setDepthMask(bool on)
+{
+    if (changed(m_depthMask, on ? 1 : 0)) glDepthMask(on ? GL_TRUE : GL_FALSE);
+}
+
+void RenderState::setDepthFunc(GLenum func)
+{
+    if (changed(m_depthFunc, (int)func)) glDepthFunc(func);
+}
+
+void RenderState::setColorMask(bool on)
+{
+    if (changed(m_colorMask, on ? 1 : 0)) {
+        const GLboolean b = on ? GL_TRUE : GL_FALSE;
+        glColorMask(b, b, b, b);
+    }
+}
+
+void RenderState::drawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    ++m_stats.drawCalls;
+    m_stats.vertices += (std::uint64_t)count;
+    glDrawArrays(mode, first, count);
+}
+
+void RenderState::drawElements(GLenum mode, GLsizei count, GLenum type, const void* offset)
+{
+    ++m_stats.drawCalls;
+    m_stats.vertices += (std::uint64_t)count;
+    glDrawElements(mode, count, type, offset);
+}
+
+void RenderState::drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances)
+{
+    ++m_stats.drawCalls;
+    m_stats.vertices += (std::uint64_t)count * (std::uint64_t)instances;
+    glDrawArraysInstanced(mode, first, count, instances);
+}
@@ -0,0 +1,78 @@
+//RenderState.h
+#pragma once
+#include <glad/glad.h>
+
+#include <cstdint>
+
+// ---------------------------
+// GL state cache
+// Thin layer over the state the frame touches (program, VAO, textures, uniform ranges,
+// blend / depth / color mask). Every setter compares against the last value it issued and
+// skips the GL call if nothing changes. Counters are per frame (beginFrame() resets them).
+//
+// Only calls made through this class are tracked: beginFrame() forgets everything, so GL
+// work done outside the frame (uploads, texture loader, terrain chunk uploads) is safe.
+// Code inside the frame that binds things directly must call invalidate() afterwards.
+// ---------------------------
+struct RenderStats {
+    std::uint32_t requests = 0;     // setter calls
+    std::uint32_t stateChanges = 0; // GL calls actually issued by setters
+    std::uint32_t drawCalls = 0;
+    std::uint64_t vertices = 0;     // vertices / indices submitted (times instances)
+
+    std::uint32_t skipped() const { return requests - stateChanges; }
+};
+
+class RenderState {
+public:
+    static constexpr int kMaxTextureUnits = 8;
+    static constexpr int kMaxUniformBindings = 4;
+
+    RenderState() { invalidate(); }
+
+    // Resets the counters and forgets the cached state (anything may have changed since)
+    void beginFrame();
+    void invalidate();
+
+    void useProgram(GLuint prog);
+    void bindVertexArray(GLuint vao);
+    void bindTexture(int unit, GLenum target, GLuint tex); // GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP
+    void bindUniformRange(GLuint binding, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+    void setBlend(bool on);
+    void setBlendFunc(GLenum src, GLenum dst);
+    void setDepthTest(bool on);
+    void setDepthMask(bool on);
+    void setDepthFunc(GLenum func);
+    void setColorMask(bool on); // all four channels
+
+    void drawArrays(GLenum mode, GLint first, GLsizei count);
+    void drawElements(GLenum mode, GLsizei count, GLenum type, const void* offset);
+    void drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances);
+
+    const RenderStats& stats() const { return m_stats; }
+
+private:
+    // Tri-state so "unknown" never matches a real value
+    enum : int { kUnknown = -1 };
+
+    bool changed(int& cached, int value);
+
+    RenderStats m_stats;
+
+    int m_program = kUnknown;
+    int m_vao = kUnknown;
+    int m_activeUnit = kUnknown;
+    int m_tex2D[kMaxTextureUnits];
+    int m_texCube[kMaxTextureUnits];
+
+    struct UniformRange { GLuint buffer = 0; GLintptr offset = -1; GLsizeiptr size = 0; };
+    UniformRange m_uniformRanges[kMaxUniformBindings];
+
+    int m_blend = kUnknown;
+    int m_blendSrc = kUnknown, m_blendDst = kUnknown;
+    int m_depthTest = kUnknown;
+    int m_depthMask = kUnknown;
+    int m_depthFunc = kUnknown;
+    int m_colorMask = kUnknown;
+};
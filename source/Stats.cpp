@@ -0,0 +1,333 @@
+//Stats.cpp
+#include "Stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <new>
+
+// ---------------------------
+// Allocation accounting
+// ---------------------------
+#if LSYS_ALLOC_STATS
+namespace {
+
+// Plain thread_local POD: constant-initialized, so touching it from inside operator new
+// never runs a TLS constructor (which could allocate)
+thread_local AllocCounters tAlloc;
+
+std::atomic<std::uint64_t> gAllocCount{ 0 };
+std::atomic<std::uint64_t> gAllocBytes{ 0 };
+std::atomic<std::int64_t> gAllocLive{ 0 };
+std::atomic<std::int64_t> gAllocPeak{ 0 };
+
+// Each block carries its size in front so delete can count it; 16 keeps malloc's alignment
+constexpr std::size_t kAllocHeader = 16;
+
+void* CountedAlloc(std::size_t n)
+{
+    void* raw = std::malloc(n + kAllocHeader);
+    if (!raw) return nullptr;
+    *static_cast<std::size_t*>(raw) = n;
+
+    ++tAlloc.count;
+    tAlloc.bytes += n;
+    tAlloc.live += (std::int64_t)n;
+    if (tAlloc.live > tAlloc.peak) tAlloc.peak = tAlloc.live;
+
+    gAllocCount.fetch_add(1, std::memory_order_relaxed);
+    gAllocBytes.fetch_add(n, std::memory_order_relaxed);
+    const std::int64_t live = gAllocLive.fetch_add((std::int64_t)n, std::memory_order_relaxed) + (std::int64_t)n;
+    std::int64_t peak = gAllocPeak.load(std::memory_order_relaxed);
+    while (live > peak && !gAllocPeak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+
+    return static_cast<char*>(raw) + kAllocHeader;
+}
+
+void CountedFree(void* p) noexcept
+{
+    if (!p) return;
+    void* raw = static_cast<char*>(p) - kAllocHeader;
+    const std::int64_t n = (std::int64_t)*static_cast<std::size_t*>(raw);
+    tAlloc.live -= n;
+    gAllocLive.fetch_sub(n, std::memory_order_relaxed);
+    std::free(raw);
+}
+
+} // namespace
+
+void* operator new(std::size_t n)
+{
+    if (void* p = CountedAlloc(n)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return operator new(n); }
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept { return CountedAlloc(n); }
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept { return CountedAlloc(n); }
+void operator delete(void* p) noexcept { CountedFree(p); }
+void operator delete[](void* p) noexcept { CountedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { CountedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { CountedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { CountedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { CountedFree(p); }
+
+AllocCounters ThreadAllocCounters()
+{
+    return tAlloc;
+}
+
+AllocCounters ProcessAllocCounters()
+{
+    AllocCounters c;
+    c.count = gAllocCount.load(std::memory_order_relaxed);
+    c.bytes = gAllocBytes.load(std::memory_order_relaxed);
+    c.live = gAllocLive.load(std::memory_order_relaxed);
+    c.peak = gAllocPeak.load(std::memory_order_relaxed);
+    return c;
+}
+
+void ResetProcessAllocPeak()
+{
+    gAllocPeak.store(gAllocLive.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+#else
+AllocCounters ThreadAllocCounters() { return {}; }
+AllocCounters ProcessAllocCounters() { return {}; }
+void ResetProcessAllocPeak() {}
+#endif
+
+// Name lookups compare the pointer first: callers pass the same literal every time
+static bool SameName(const char* a, const char* b)
+{
+    return a == b || std::strcmp(a, b) == 0;
+}
+
+void Stats::addPhase(const char* name, double ms, const AllocCounters* allocs)
+{
+    Phase* phase = nullptr;
+    for (Phase& p : phases) {
+        if (SameName(p.name, name)) {
+            phase = &p;
+            break;
+        }
+    }
+    if (!phase) {
+        phases.push_back({ name });
+        phase = &phases.back();
+    }
+
+    phase->ms += ms;
+    ++phase->calls;
+    if (allocs) {
+        phase->allocs += allocs->count;
+        phase->allocBytes += allocs->bytes;
+        phase->peakBytes = std::max(phase->peakBytes, allocs->peak);
+    }
+}
+
+void Stats::add(const char* name, std::int64_t n)
+{
+    for (Counter& c : counters) {
+        if (SameName(c.name, name)) {
+            c.value += n;
+            return;
+        }
+    }
+    counters.push_back({ name, n });
+}
+
+double Stats::phaseMs(const char* name) const
+{
+    const Phase* p = phase(name);
+    return p ? p->ms : 0.0;
+}
+
+const Stats::Phase* Stats::phase(const char* name) const
+{
+    for (const Phase& p : phases) if (SameName(p.name, name)) return &p;
+    return nullptr;
+}
+
+std::int64_t Stats::counter(const char* name) const
+{
+    for (const Counter& c : counters) if (SameName(c.name, name)) return c.value;
+    return 0;
+}
+
+void Stats::print(std::ostream& os) const
+{
+    const auto flags = os.flags();
+    const auto prec = os.precision();
+
+    for (std::size_t i = 0; i < phases.size(); ++i) {
+        const Phase& p = phases[i];
+        os << (i ? ", " : "") << p.name << " " << p.ms << " ms";
+        if (kAllocStats) {
+            os << std::fixed << std::setprecision(1) << " (" << p.allocs << " allocs, "
+                << double(p.allocBytes) / 1024.0 << " KB, peak " << double(p.peakBytes) / 1024.0 << " KB)";
+            os.flags(flags);
+            os.precision(prec);
+        }
+    }
+    if (!phases.empty() && !counters.empty()) os << " |";
+    for (const Counter& c : counters) os << " " << c.name << "=" << c.value;
+    os << "\n";
+
+    os.flags(flags);
+    os.precision(prec);
+}
+
+// ---------------------------
+// Trace
+// ---------------------------
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    std::uint32_t tid;
+    std::int64_t tsUs;
+    std::int64_t durUs;
+};
+
+// Frame and upload spans arrive every frame: a long run would grow the buffer without end.
+// The first kTraceMaxEvents are kept (startup is what --trace is for); the rest are counted.
+constexpr std::size_t kTraceMaxEvents = 1u << 20; // ~32 MB
+
+struct TraceState {
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    std::uint64_t dropped = 0;
+    std::map<std::uint32_t, std::string> threadNames;
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+};
+
+std::atomic<bool> gTraceOn{ false };
+std::atomic<std::uint32_t> gNextTid{ 1 };
+
+TraceState& Trace()
+{
+    static TraceState s;
+    return s;
+}
+
+// Small, stable per-thread ids read better in the viewer than hashed std::thread::ids
+std::uint32_t TraceTid()
+{
+    thread_local std::uint32_t tid = gNextTid.fetch_add(1);
+    return tid;
+}
+
+} // namespace
+
+void TraceEnable(bool on)
+{
+    Trace(); // pin the time origin before the first event
+    gTraceOn.store(on, std::memory_order_relaxed);
+}
+
+bool TraceEnabled()
+{
+    return gTraceOn.load(std::memory_order_relaxed);
+}
+
+void TraceSetThreadName(const char* name)
+{
+    TraceState& t = Trace();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    t.threadNames[TraceTid()] = name;
+}
+
+void TraceComplete(const char* name, std::chrono::steady_clock::time_point start,
+    std::chrono::steady_clock::time_point end)
+{
+    if (!TraceEnabled()) return;
+
+    using us = std::chrono::microseconds;
+    TraceState& t = Trace();
+    const TraceEvent e{ name, TraceTid(),
+        std::chrono::duration_cast<us>(start - t.origin).count(),
+        std::chrono::duration_cast<us>(end - start).count() };
+
+    std::lock_guard<std::mutex> lock(t.mutex);
+    if (t.events.size() < kTraceMaxEvents) t.events.push_back(e);
+    else ++t.dropped;
+}
+
+bool TraceWriteJson(const std::string& path)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+
+    TraceState& t = Trace();
+    std::lock_guard<std::mutex> lock(t.mutex);
+
+    // Lane labels first (metadata events), then the spans
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    for (const auto& kv : t.threadNames) {
+        out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << kv.first
+            << ", \"args\": {\"name\": \"" << kv.second << "\"}}";
+        first = false;
+    }
+    for (const TraceEvent& e : t.events) {
+        out << (first ? "" : ",\n") << "{\"name\": \"" << e.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << e.tid
+            << ", \"ts\": " << e.tsUs << ", \"dur\": " << e.durUs << "}";
+        first = false;
+    }
+    out << "\n]";
+    if (t.dropped) {
+        out << ",\n\"otherData\": {\"note\": \"event buffer full after " << kTraceMaxEvents
+            << " events\", \"dropped_events\": " << t.dropped << "}";
+    }
+    out << "}\n";
+    return bool(out);
+}
+
+// ---------------------------
+// ScopedPhase
+// ---------------------------
+ScopedPhase::ScopedPhase(Stats* stats, const char* name, bool trace)
+    : m_stats(stats), m_name(name), m_trace(trace && TraceEnabled()), m_uncaught(std::uncaught_exceptions())
+{
+    m_running = m_stats || m_trace;
+    if (m_running) m_start = std::chrono::steady_clock::now();
+
+#if LSYS_ALLOC_STATS
+    // Start a fresh thread peak for this scope; stop() folds it back into the outer one
+    if (m_stats) {
+        m_allocStart = tAlloc;
+        m_outerPeak = tAlloc.peak;
+        tAlloc.peak = tAlloc.live;
+    }
+#endif
+}
+
+void ScopedPhase::stop()
+{
+    if (!m_running) return;
+    m_running = false;
+
+    const auto end = std::chrono::steady_clock::now();
+    const double ms = std::chrono::duration<double, std::milli>(end - m_start).count();
+    if (m_stats && !m_stats->failedPhase && std::uncaught_exceptions() > m_uncaught) m_stats->failedPhase = m_name;
+#if LSYS_ALLOC_STATS
+    if (m_stats) {
+        AllocCounters used;
+        used.count = tAlloc.count - m_allocStart.count;
+        used.bytes = tAlloc.bytes - m_allocStart.bytes;
+        used.live = tAlloc.live - m_allocStart.live;
+        used.peak = tAlloc.peak - m_allocStart.live;
+        tAlloc.peak = std::max(tAlloc.peak, m_outerPeak);
+        m_stats->addPhase(m_name, ms, &used);
+    }
+#else
+    if (m_stats) m_stats->addPhase(m_name, ms);
+#endif
+    if (m_trace) TraceComplete(m_name, m_start, end);
+}
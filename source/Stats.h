@@ -0,0 +1,145 @@
+//Stats.h
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// ---------------------------
+// Phase timers + named counters
+// A Stats is filled by whoever does the work (e.g. TreeBuildInfo::stats) and handed back
+// with the result, instead of printing. Phases with the same name add up.
+//
+// The macros are the instrumentation surface; with LSYS_STATS=0 (CMake: -DENABLE_STATS=OFF)
+// they compile to nothing, so the timers cost no clock reads at all.
+//   STATS_PHASE(stats, "name")            scoped timer (+ trace event)
+//   STATS_PHASE_UNTRACED(stats, "name")   scoped timer only, for hot inner scopes
+//   STATS_PHASE_VAR(var, stats, "name") / STATS_PHASE_END(var)   timer that ends early
+//   STATS_COUNT(stats, "name", n)         counter += n
+// `stats` may be null: the timer then only feeds the trace (if tracing is on).
+// Names must be string literals (the trace keeps the pointers).
+// ---------------------------
+#ifndef LSYS_STATS
+#define LSYS_STATS 1
+#endif
+
+constexpr bool kStats = LSYS_STATS != 0;
+
+// ---------------------------
+// Allocation accounting (instrumented builds only)
+// With LSYS_ALLOC_STATS=1 (CMake: -DENABLE_ALLOC_STATS=ON; the benchmarks always have it)
+// Stats.cpp replaces the global operator new / delete with a counting shim, and every phase
+// timer also records what its scope allocated and how far live bytes rose above where they
+// were when it started. Live bytes are per thread: a block freed on another thread than
+// the one that allocated it lowers that thread's count instead.
+// ---------------------------
+#ifndef LSYS_ALLOC_STATS
+#define LSYS_ALLOC_STATS 0
+#endif
+
+struct AllocCounters {
+    std::uint64_t count = 0;   // operator new calls
+    std::uint64_t bytes = 0;   // requested bytes
+    std::int64_t live = 0;     // allocated - freed
+    std::int64_t peak = 0;     // highest `live` since the last reset
+};
+
+constexpr bool kAllocStats = LSYS_ALLOC_STATS != 0;
+
+// All zero without LSYS_ALLOC_STATS
+AllocCounters ThreadAllocCounters();
+AllocCounters ProcessAllocCounters();
+void ResetProcessAllocPeak(); // peak = live
+
+struct Stats {
+    struct Phase {
+        const char* name;
+        double ms = 0.0;
+        std::uint64_t calls = 0;
+        std::uint64_t allocs = 0;      // LSYS_ALLOC_STATS only
+        std::uint64_t allocBytes = 0;
+        std::int64_t peakBytes = 0;    // highest of any single call
+    };
+    struct Counter {
+        const char* name;
+        std::int64_t value = 0;
+    };
+
+    std::vector<Phase> phases;      // in first-use order
+    std::vector<Counter> counters;
+
+    // Innermost phase an exception unwound (the first to close while unwinding): the stage
+    // a bad_alloc came from. phases.back() is not it: outer phases are added on unwind too.
+    const char* failedPhase = nullptr;
+
+    void addPhase(const char* name, double ms, const AllocCounters* allocs = nullptr);
+    void add(const char* name, std::int64_t n = 1);
+
+    double phaseMs(const char* name) const;      // 0 if never timed
+    const Phase* phase(const char* name) const;  // null if never timed
+    std::int64_t counter(const char* name) const; // 0 if never counted
+
+    // "derive 1.2 ms, interpret 30.5 ms | sentence_length=6134 F=1488 ..."
+    // with allocation accounting: "derive 1.2 ms (75 allocs, 11.3 KB, peak 9.1 KB), ..."
+    void print(std::ostream& os) const;
+};
+
+// ---------------------------
+// Chrome trace-event timeline (chrome://tracing, Perfetto)
+// Every traced phase becomes a complete ("X") event in its thread's lane. Off by default;
+// while off, untraced phases with a null Stats skip the clock entirely.
+// ---------------------------
+void TraceEnable(bool on);
+bool TraceEnabled();
+
+// Label for the calling thread's lane (unnamed lanes show up as "thread N")
+void TraceSetThreadName(const char* name);
+
+void TraceComplete(const char* name, std::chrono::steady_clock::time_point start,
+    std::chrono::steady_clock::time_point end);
+
+// Writes everything recorded so far. False if the file can't be written.
+// Only the first ~1M events are kept; later ones are counted in "otherData" (meant for
+// startup and short runs, not hours of frames).
+bool TraceWriteJson(const std::string& path);
+
+class ScopedPhase {
+public:
+    ScopedPhase(Stats* stats, const char* name, bool trace = true);
+    ~ScopedPhase() { try { stop(); } catch (...) {} } // may run while unwinding a bad_alloc
+
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+    void stop();
+
+private:
+    Stats* m_stats;
+    const char* m_name;
+    bool m_trace;
+    bool m_running;
+    int m_uncaught; // std::uncaught_exceptions() at the start
+    std::chrono::steady_clock::time_point m_start;
+#if LSYS_ALLOC_STATS
+    AllocCounters m_allocStart;
+    std::int64_t m_outerPeak = 0;
+#endif
+};
+
+#define STATS_CONCAT2(a, b) a##b
+#define STATS_CONCAT(a, b) STATS_CONCAT2(a, b)
+
+#if LSYS_STATS
+#define STATS_PHASE(stats, name) ScopedPhase STATS_CONCAT(statsPhase_, __LINE__)((stats), (name))
+#define STATS_PHASE_UNTRACED(stats, name) ScopedPhase STATS_CONCAT(statsPhase_, __LINE__)((stats), (name), false)
+#define STATS_PHASE_VAR(var, stats, name) ScopedPhase var((stats), (name))
+#define STATS_PHASE_END(var) var.stop()
+#define STATS_COUNT(stats, name, n) do { if (stats) (stats)->add((name), (std::int64_t)(n)); } while (0)
+#else
+#define STATS_PHASE(stats, name) ((void)0)
+#define STATS_PHASE_UNTRACED(stats, name) ((void)0)
+#define STATS_PHASE_VAR(var, stats, name) ((void)0)
+#define STATS_PHASE_END(var) ((void)0)
+#define STATS_COUNT(stats, name, n) ((void)0)
+#endif
@@ -0,0 +1,239 @@
+//Terrain.cpp
+#include "Terrain.h"
+#include "VertexLayout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// ---------------------------
+// Chunk geometry
+// ---------------------------
+HillMesh BuildTerrainChunk(const TerrainSettings& s, int level, int x, int z)
+{
+    const float size = 2.0f * s.halfSize / float(1 << level);
+    const float x0 = -s.halfSize + x * size;
+    const float z0 = -s.halfSize + z * size;
+    const int N = s.chunkQuads + 1;
+
+    // One chunk per pool task: keep it on this thread
+    std::vector<std::uint32_t> gridToVertex;
+    HillMesh mesh = BuildHillPatch(s.baseY, x0, z0, size, N, s.uvWorld, s.uvWorld,
+        true, HillKernel::Simd, 1, &gridToVertex);
+
+    // Border vertex of grid point (i, j), edge by edge
+    auto at = [&](int i, int j) { return gridToVertex[(std::size_t)j * N + i]; };
+    std::vector<std::uint32_t> border((std::size_t)N * 4, 0);
+    for (int k = 0; k < N; ++k) {
+        border[k] = at(k, 0);                               // edge 0: z = z0
+        border[(std::size_t)N + k] = at(k, N - 1);          // edge 1: z = z0 + size
+        border[(std::size_t)N * 2 + k] = at(0, k);          // edge 2: x = x0
+        border[(std::size_t)N * 3 + k] = at(N - 1, k);      // edge 3: x = x0 + size
+    }
+
+    // Skirts: a copy of every border vertex pushed straight down, stitched to the border.
+    // Deep enough for the height error of a coarser neighbour (the noise has ~0.3 m amplitude).
+    const float skirt = std::max(0.5f, 0.05f * size);
+    for (int e = 0; e < 4; ++e) {
+        const std::uint32_t first = (std::uint32_t)mesh.vertices.size();
+        for (int k = 0; k < N; ++k) {
+            VertexPN v = mesh.vertices[border[(std::size_t)e * N + k]];
+            v.pos.y -= skirt;
+            mesh.vertices.push_back(v);
+        }
+        for (int k = 0; k + 1 < N; ++k) {
+            const std::uint32_t a = border[(std::size_t)e * N + k];
+            const std::uint32_t b = border[(std::size_t)e * N + k + 1];
+            const std::uint32_t a2 = first + k, b2 = first + k + 1;
+            mesh.indices.insert(mesh.indices.end(), { a, b, b2, a, b2, a2 });
+        }
+    }
+
+    return mesh;
+}
+
+// ---------------------------
+// TerrainSystem
+// ---------------------------
+
+TerrainSystem::TerrainSystem(ThreadPool& pool, const TerrainSettings& settings)
+    : m_pool(pool), m_settings(settings)
+{
+    m_settings.chunkQuads = std::max(4, m_settings.chunkQuads);
+    m_settings.minChunkSize = std::max(1e-3f, m_settings.minChunkSize);
+    m_settings.maxResident = std::max(16, m_settings.maxResident);
+    m_settings.uploadsPerFrame = std::max(1, m_settings.uploadsPerFrame);
+
+    // Deepest level whose chunks are still at least minChunkSize wide
+    const float rootSize = 2.0f * m_settings.halfSize;
+    while (m_maxLevel < 16 && rootSize / float(1 << (m_maxLevel + 1)) >= m_settings.minChunkSize)
+        ++m_maxLevel;
+}
+
+TerrainSystem::~TerrainSystem()
+{
+    for (auto& kv : m_chunks) release(*kv.second);
+}
+
+std::uint64_t TerrainSystem::Key(int level, int x, int z)
+{
+    return ((std::uint64_t)level << 48) | ((std::uint64_t)(std::uint32_t)x << 24) | (std::uint64_t)(std::uint32_t)z;
+}
+
+// True if the node's area is covered by resident chunks (pushed to m_draw)
+bool TerrainSystem::select(int level, int x, int z, const glm::vec3& focus)
+{
+    const float size = 2.0f * m_settings.halfSize / float(1 << level);
+    const float x0 = -m_settings.halfSize + x * size;
+    const float z0 = -m_settings.halfSize + z * size;
+
+    // Closest point of the node to the origin (mask cull) and to the focus (LOD)
+    if (m_settings.drawRadius > 0.0f) {
+        const float cx = std::clamp(0.0f, x0, x0 + size);
+        const float cz = std::clamp(0.0f, z0, z0 + size);
+        if (cx * cx + cz * cz > m_settings.drawRadius * m_settings.drawRadius) return true;
+    }
+
+    const float fx = focus.x - std::clamp(focus.x, x0, x0 + size);
+    const float fz = focus.z - std::clamp(focus.z, z0, z0 + size);
+    const float fy = focus.y - m_settings.baseY;
+    const float dist = std::sqrt(fx * fx + fy * fy + fz * fz);
+
+    if (level < m_maxLevel && dist < m_settings.splitDistance * size) {
+        // Visit all four (no short-circuit) so every missing child gets requested
+        const std::size_t mark = m_draw.size();
+        bool covered = true;
+        covered &= select(level + 1, 2 * x, 2 * z, focus);
+        covered &= select(level + 1, 2 * x + 1, 2 * z, focus);
+        covered &= select(level + 1, 2 * x, 2 * z + 1, focus);
+        covered &= select(level + 1, 2 * x + 1, 2 * z + 1, focus);
+        if (covered) return true;
+        m_draw.resize(mark); // fall back to this node until the children are in
+    }
+
+    const std::uint64_t key = Key(level, x, z);
+    auto it = m_chunks.find(key);
+    if (it == m_chunks.end()) {
+        m_wanted.push_back(key);
+        return false;
+    }
+
+    Chunk& c = *it->second;
+    c.lastUsed = m_frame;
+    if (!c.vao) return false;
+
+    m_draw.push_back(&c);
+    return true;
+}
+
+void TerrainSystem::upload(Chunk& c, const HillMesh& mesh)
+{
+    glGenVertexArrays(1, &c.vao);
+    glGenBuffers(1, &c.vbo);
+    glGenBuffers(1, &c.ebo);
+
+    glBindVertexArray(c.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, c.vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(mesh.vertices.size() * sizeof(VertexPN)),
+        mesh.vertices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, c.ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)(mesh.indices.size() * sizeof(std::uint32_t)),
+        mesh.indices.data(), GL_STATIC_DRAW);
+
+    SetupVertexPNAttribs();
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    c.indexCount = (GLsizei)mesh.indices.size();
+    c.vertexCount = (GLsizei)mesh.vertices.size();
+}
+
+void TerrainSystem::release(Chunk& c)
+{
+    if (!c.vao) return;
+    glDeleteBuffers(1, &c.vbo);
+    glDeleteBuffers(1, &c.ebo);
+    glDeleteVertexArrays(1, &c.vao);
+    c.vao = c.vbo = c.ebo = 0;
+}
+
+void TerrainSystem::update(const glm::vec3& focus)
+{
+    ++m_frame;
+
+    // Finished builds -> GPU, a few per frame
+    int uploads = 0;
+    int building = 0;
+    for (auto& kv : m_chunks) {
+        Chunk& c = *kv.second;
+        if (!c.building.valid()) continue;
+        if (uploads < m_settings.uploadsPerFrame && IsReady(c.building)) {
+            upload(c, c.building.get());
+            ++uploads;
+        }
+        else {
+            ++building;
+        }
+    }
+
+    m_draw.clear();
+    m_wanted.clear();
+    select(0, 0, 0, focus);
+
+    // Coarse chunks first: they are what gets drawn while the fine ones are missing.
+    // Keep the queue short so other pool work (textures, the tree) isn't starved.
+    std::sort(m_wanted.begin(), m_wanted.end());
+    const int maxBuilding = 2 * (int)std::max(1u, m_pool.size());
+    for (std::uint64_t key : m_wanted) {
+        if (building >= maxBuilding) break;
+
+        auto c = std::make_unique<Chunk>();
+        c->level = (int)(key >> 48);
+        c->x = (int)((key >> 24) & 0xffffffu);
+        c->z = (int)(key & 0xffffffu);
+        c->lastUsed = m_frame;
+
+        const TerrainSettings s = m_settings;
+        const int level = c->level, x = c->x, z = c->z;
+        c->building = m_pool.submit([s, level, x, z]() { return BuildTerrainChunk(s, level, x, z); });
+
+        m_chunks.emplace(key, std::move(c));
+        ++building;
+        ++m_stats.built;
+    }
+
+    // LRU eviction of resident chunks the current selection doesn't touch
+    int resident = 0;
+    for (auto& kv : m_chunks) resident += kv.second->vao ? 1 : 0;
+
+    if (resident > m_settings.maxResident) {
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> old; // lastUsed, key
+        for (auto& kv : m_chunks) {
+            if (kv.second->vao && kv.second->lastUsed < m_frame)
+                old.push_back({ kv.second->lastUsed, kv.first });
+        }
+        std::sort(old.begin(), old.end());
+
+        for (std::size_t k = 0; k < old.size() && resident > m_settings.maxResident; ++k, --resident) {
+            auto it = m_chunks.find(old[k].second);
+            release(*it->second);
+            m_chunks.erase(it);
+        }
+    }
+
+    m_stats.drawnChunks = (int)m_draw.size();
+    m_stats.drawnVertices = 0;
+    for (const Chunk* c : m_draw) m_stats.drawnVertices += (std::uint64_t)c->vertexCount;
+    m_stats.resident = resident;
+    m_stats.building = building;
+}
+
+void TerrainSystem::draw(RenderState& rs) const
+{
+    for (const Chunk* c : m_draw) {
+        rs.bindVertexArray(c->vao);
+        rs.drawElements(GL_TRIANGLES, c->indexCount, GL_UNSIGNED_INT, nullptr);
+    }
+}
@@ -0,0 +1,95 @@
+//Terrain.h
+#pragma once
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Hill.h"
+#include "RenderState.h"
+#include "ThreadPool.h"
+
+// ---------------------------
+// Chunked terrain (quadtree LOD)
+// The ground square [-halfSize, halfSize]^2 is a quadtree and every node is the same
+// chunkQuads x chunkQuads patch (BuildHillPatch), so a node one level up covers four times
+// the area for the same vertex count. Each frame update() walks the tree from the focus
+// point (split while closer than splitDistance node sizes), builds missing chunks lazily
+// on the pool, uploads a few per frame and evicts the least recently used ones. A node is
+// drawn in place of its children until all four of them are resident.
+// Cracks between neighbouring LODs are covered by skirts hanging down from every border.
+// ---------------------------
+struct TerrainSettings {
+    float baseY = 0.0f;
+    float halfSize = 400.0f;
+    float uvWorld = 14.0f;       // metres per texture repeat
+    int   chunkQuads = 32;       // quads per chunk side, every level
+    float minChunkSize = 12.5f;  // edge of the finest chunks (world units)
+    float splitDistance = 1.0f;  // split a node while the focus is closer than this many node sizes
+    float drawRadius = 0.0f;     // skip nodes entirely beyond this distance from the origin (0 = off)
+    int   maxResident = 256;     // chunks kept on the GPU
+    int   uploadsPerFrame = 4;
+};
+
+struct TerrainStats {
+    int           drawnChunks = 0;
+    std::uint64_t drawnVertices = 0;
+    int           resident = 0;
+    int           building = 0;
+    std::uint64_t built = 0;     // total chunk builds so far
+};
+
+// One chunk: the patch for quadtree node (level, x, z) plus its skirts. CPU only.
+HillMesh BuildTerrainChunk(const TerrainSettings& s, int level, int x, int z);
+
+class TerrainSystem {
+public:
+    TerrainSystem(ThreadPool& pool, const TerrainSettings& settings);
+
+    // GL thread. Builds still in flight finish on the pool and are dropped.
+    ~TerrainSystem();
+
+    TerrainSystem(const TerrainSystem&) = delete;
+    TerrainSystem& operator=(const TerrainSystem&) = delete;
+
+    // GL thread, once per frame. focus is in terrain (model) space.
+    void update(const glm::vec3& focus);
+
+    // GL thread. Draws the current selection; program, uniforms and textures are the caller's.
+    void draw(RenderState& rs) const;
+
+    const TerrainSettings& settings() const { return m_settings; }
+    const TerrainStats& stats() const { return m_stats; }
+    int levels() const { return m_maxLevel + 1; }
+
+private:
+    struct Chunk {
+        int level = 0, x = 0, z = 0;
+        std::future<HillMesh> building;
+        GLuint vao = 0, vbo = 0, ebo = 0;
+        GLsizei indexCount = 0;
+        GLsizei vertexCount = 0;
+        std::uint64_t lastUsed = 0;
+    };
+
+    static std::uint64_t Key(int level, int x, int z);
+
+    bool select(int level, int x, int z, const glm::vec3& focus);
+    void upload(Chunk& c, const HillMesh& mesh);
+    void release(Chunk& c);
+
+    ThreadPool& m_pool;
+    TerrainSettings m_settings;
+    int m_maxLevel = 0;
+
+    std::unordered_map<std::uint64_t, std::unique_ptr<Chunk>> m_chunks;
+    std::vector<const Chunk*> m_draw;            // this frame's selection
+    std::vector<std::uint64_t> m_wanted;         // missing chunks found by select()
+    std::uint64_t m_frame = 0;
+    TerrainStats m_stats;
+};
@@ -0,0 +1,280 @@
+//TextureCache.cpp
+#include "TextureCache.h"
+#include "Textures.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+static const char kTexCacheMagic[8] = { 'L', 'T', 'E', 'X', 'C', 'A', 'C', 'H' };
+
+fs::path TextureCachePath(const fs::path& src)
+{
+    fs::path p = src;
+    p += ".texcache";
+    return p;
+}
+
+// ---------------------------
+// Mip generation
+// ---------------------------
+const float* SrgbToLinearLUT()
+{
+    static const std::vector<float> lut = []() {
+        std::vector<float> t(256);
+        for (int i = 0; i < 256; ++i) {
+            float c = i / 255.0f;
+            t[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return t;
+    }();
+    return lut.data();
+}
+
+static unsigned char LinearToSrgb8(float v)
+{
+    // 4096 steps is finer than 8-bit sRGB needs anywhere on the curve
+    static const std::vector<unsigned char> lut = []() {
+        std::vector<unsigned char> t(4096);
+        for (int i = 0; i < 4096; ++i) {
+            float l = i / 4095.0f;
+            float c = (l <= 0.0031308f) ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+            t[i] = (unsigned char)std::lround(std::clamp(c, 0.0f, 1.0f) * 255.0f);
+        }
+        return t;
+    }();
+    int idx = (int)std::lround(std::clamp(v, 0.0f, 1.0f) * 4095.0f);
+    return lut[idx];
+}
+
+static int MipCountFor(int w, int h)
+{
+    int n = 1;
+    while (w > 1 || h > 1) {
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+        ++n;
+    }
+    return n;
+}
+
+// Fills out.levels[i].w/h/bytes for a w x h base, returns total bytes
+static std::size_t LayoutLevels(MipChain& out, int w, int h)
+{
+    out.levels.resize((std::size_t)MipCountFor(w, h));
+    std::size_t total = 0;
+    for (auto& lv : out.levels) {
+        lv.w = w;
+        lv.h = h;
+        lv.bytes = (std::size_t)w * (std::size_t)h * 4;
+        total += lv.bytes;
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+    }
+    out.totalBytes = total;
+    return total;
+}
+
+static void PointLevelsAt(MipChain& out, const unsigned char* base)
+{
+    std::size_t off = 0;
+    for (auto& lv : out.levels) {
+        lv.data = base + off;
+        off += lv.bytes;
+    }
+}
+
+void BuildMipChainRGBA8(MipChain& out, const unsigned char* rgba, int w, int h, bool srgb)
+{
+    out.storage.resize(LayoutLevels(out, w, h));
+    PointLevelsAt(out, out.storage.data());
+
+    std::memcpy(out.storage.data(), rgba, out.levels[0].bytes);
+
+    const float* toLinear = SrgbToLinearLUT();
+
+    for (std::size_t li = 1; li < out.levels.size(); ++li) {
+        const MipChain::Level& src = out.levels[li - 1];
+        MipChain::Level& dst = out.levels[li];
+        unsigned char* d = const_cast<unsigned char*>(dst.data);
+
+        for (int y = 0; y < dst.h; ++y) {
+            // 2x2 box; odd edges repeat the last row/column
+            const int y0 = std::min(2 * y, src.h - 1);
+            const int y1 = std::min(2 * y + 1, src.h - 1);
+
+            for (int x = 0; x < dst.w; ++x) {
+                const int x0 = std::min(2 * x, src.w - 1);
+                const int x1 = std::min(2 * x + 1, src.w - 1);
+
+                const unsigned char* p[4] = {
+                    src.data + ((std::size_t)y0 * src.w + x0) * 4,
+                    src.data + ((std::size_t)y0 * src.w + x1) * 4,
+                    src.data + ((std::size_t)y1 * src.w + x0) * 4,
+                    src.data + ((std::size_t)y1 * src.w + x1) * 4,
+                };
+
+                unsigned char* o = d + ((std::size_t)y * dst.w + x) * 4;
+                for (int c = 0; c < 4; ++c) {
+                    if (srgb && c < 3) {
+                        float l = 0.25f * (toLinear[p[0][c]] + toLinear[p[1][c]] + toLinear[p[2][c]] + toLinear[p[3][c]]);
+                        o[c] = LinearToSrgb8(l);
+                    }
+                    else {
+                        o[c] = (unsigned char)((p[0][c] + p[1][c] + p[2][c] + p[3][c] + 2) / 4);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// ---------------------------
+// Cache I/O
+// ---------------------------
+std::uint64_t HashFileFNV1a(const fs::path& path)
+{
+    MappedFile f;
+    if (!f.open(path)) return 0;
+
+    std::uint64_t h = 1469598103934665603ull;
+    const unsigned char* p = f.data();
+    for (std::size_t i = 0; i < f.size(); ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+std::int64_t FileMtime(const fs::path& path)
+{
+    std::error_code ec;
+    auto t = fs::last_write_time(path, ec);
+    return ec ? 0 : (std::int64_t)t.time_since_epoch().count();
+}
+
+// The source was touched but not changed (checkout, copy): write its new mtime into the
+// header so later launches take the fast path again instead of re-hashing the PNG.
+// Best effort: on failure the next launch just hashes once more.
+static void RestampCacheMtime(const fs::path& src, std::int64_t mtime)
+{
+    std::fstream f(TextureCachePath(src), std::ios::in | std::ios::out | std::ios::binary);
+    if (!f) return;
+    f.seekp((std::streamoff)offsetof(TexCacheHeader, srcMtime));
+    f.write(reinterpret_cast<const char*>(&mtime), sizeof(mtime));
+}
+
+static bool TryLoadCache(const fs::path& src, bool srgb, MipChain& out)
+{
+    auto map = std::make_unique<MappedFile>();
+    if (!map->open(TextureCachePath(src))) return false;
+    if (map->size() < sizeof(TexCacheHeader)) return false;
+
+    TexCacheHeader hdr;
+    std::memcpy(&hdr, map->data(), sizeof(hdr));
+
+    if (std::memcmp(hdr.magic, kTexCacheMagic, sizeof(kTexCacheMagic)) != 0) return false;
+    if (hdr.version != kTexCacheVersion) return false;
+    if (hdr.format != (std::uint32_t)TexCacheFormat::RGBA8) return false;
+    if (((hdr.flags & 1u) != 0) != srgb) return false;
+    if (hdr.width == 0 || hdr.height == 0) return false;
+
+    std::error_code ec;
+    const std::uint64_t srcSize = (std::uint64_t)fs::file_size(src, ec);
+    if (ec || srcSize != hdr.srcSize) return false;
+
+    // mtime is the fast path; if it moved, the content hash gets the final say
+    const std::int64_t srcMtime = FileMtime(src);
+    const bool restamp = srcMtime != hdr.srcMtime;
+    if (restamp && HashFileFNV1a(src) != hdr.srcHash) return false;
+
+    const std::size_t total = LayoutLevels(out, (int)hdr.width, (int)hdr.height);
+    if (hdr.mipCount != out.levels.size() || hdr.dataBytes != total) return false;
+    if (map->size() != sizeof(TexCacheHeader) + total) return false;
+
+    // Only the header's mtime field changes; the mapped pixels stay valid
+    if (restamp) RestampCacheMtime(src, srcMtime);
+
+    PointLevelsAt(out, map->data() + sizeof(TexCacheHeader));
+    out.mapping = std::move(map);
+    out.fromCache = true;
+    return true;
+}
+
+static void WriteCache(const fs::path& src, bool srgb, const MipChain& chain)
+{
+    TexCacheHeader hdr{};
+    std::memcpy(hdr.magic, kTexCacheMagic, sizeof(kTexCacheMagic));
+    hdr.version = kTexCacheVersion;
+    hdr.format = (std::uint32_t)TexCacheFormat::RGBA8;
+    hdr.flags = srgb ? 1u : 0u;
+    hdr.width = (std::uint32_t)chain.levels[0].w;
+    hdr.height = (std::uint32_t)chain.levels[0].h;
+    hdr.mipCount = (std::uint32_t)chain.levels.size();
+
+    std::error_code ec;
+    hdr.srcSize = (std::uint64_t)fs::file_size(src, ec);
+    hdr.srcMtime = FileMtime(src);
+    hdr.srcHash = HashFileFNV1a(src);
+    hdr.dataBytes = chain.totalBytes;
+
+    // Write to a temp name and rename, so a half-written cache is never picked up
+    const fs::path finalPath = TextureCachePath(src);
+    fs::path tmpPath = finalPath;
+    tmpPath += ".tmp";
+
+    {
+        std::ofstream f(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!f) {
+            std::cerr << "Warning: can't write texture cache " << finalPath << "\n";
+            return;
+        }
+        f.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+        for (const auto& lv : chain.levels)
+            f.write(reinterpret_cast<const char*>(lv.data), (std::streamsize)lv.bytes);
+        if (!f) {
+            std::cerr << "Warning: failed writing texture cache " << finalPath << "\n";
+            f.close();
+            fs::remove(tmpPath, ec);
+            return;
+        }
+    }
+
+    fs::remove(finalPath, ec); // rename() won't replace an existing file on Windows
+    fs::rename(tmpPath, finalPath, ec);
+    if (ec) {
+        std::cerr << "Warning: failed to move texture cache into place: " << finalPath << "\n";
+        fs::remove(tmpPath, ec);
+    }
+}
+
+MipChain LoadTextureMips(const fs::path& src, bool srgb, bool useCache)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    auto msSince = [&]() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    };
+
+    MipChain chain;
+    if (useCache && TryLoadCache(src, srgb, chain)) {
+        chain.loadMs = msSince();
+        return chain;
+    }
+    chain = MipChain{};
+
+    DecodedImage img = DecodeImageRGBA8(src);
+    if (!img.pixels) return chain;
+
+    BuildMipChainRGBA8(chain, img.pixels.get(), img.w, img.h, srgb);
+    if (useCache) WriteCache(src, srgb, chain);
+
+    chain.loadMs = msSince();
+    return chain;
+}
@@ -0,0 +1,81 @@
+//TextureCache.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "MappedFile.h"
+
+// ---------------------------
+// Precompiled texture cache
+// `<image>.texcache` sits next to the source PNG and holds the decoded RGBA8 pixels
+// plus the full CPU-built mip chain, so later launches skip PNG inflate and
+// glGenerateMipmap entirely and just memory-map the file.
+//
+// Layout (native endian):
+//   TexCacheHeader (64 bytes)
+//   level 0, level 1, ... level N-1   tightly packed RGBA8, sizes follow from width/height
+//
+// A cache is valid when its source has the same size and mtime, or (if the mtime moved,
+// e.g. after a fresh checkout) the same FNV-1a hash.
+// ---------------------------
+constexpr std::uint32_t kTexCacheVersion = 1;
+
+// Only plain RGBA8 for now. GL 3.3 core has no BC formats (S3TC is an extension,
+// BPTC is 4.2), so block compression is left as a future format id.
+enum class TexCacheFormat : std::uint32_t {
+    RGBA8 = 0,
+};
+
+struct TexCacheHeader {
+    char          magic[8];   // "LTEXCACH"
+    std::uint32_t version;
+    std::uint32_t format;     // TexCacheFormat
+    std::uint32_t flags;      // bit 0: mips averaged in linear space (sRGB source)
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t mipCount;
+    std::uint64_t srcSize;
+    std::int64_t  srcMtime;
+    std::uint64_t srcHash;
+    std::uint64_t dataBytes;
+};
+static_assert(sizeof(TexCacheHeader) == 64, "texcache header must stay 64 bytes");
+
+// One RGBA8 image with its full mip chain (level 0 = full size).
+// Pixels live either in the memory-mapped cache or in `storage`.
+struct MipChain {
+    struct Level {
+        int w = 0;
+        int h = 0;
+        const unsigned char* data = nullptr;
+        std::size_t bytes = 0;
+    };
+
+    std::vector<Level> levels;
+    std::size_t totalBytes = 0;
+
+    bool   fromCache = false;
+    double loadMs = 0.0;   // cache hit: map + validate; miss: decode + mips + cache write
+
+    std::unique_ptr<MappedFile> mapping;
+    std::vector<unsigned char> storage;
+};
+
+std::filesystem::path TextureCachePath(const std::filesystem::path& src);
+
+// Source stamps shared by the on-disk caches (texture, environment cube, SH)
+std::uint64_t HashFileFNV1a(const std::filesystem::path& path); // 0 if unreadable
+std::int64_t  FileMtime(const std::filesystem::path& path);     // 0 if unreadable
+
+// 256-entry 8-bit sRGB -> linear table
+const float* SrgbToLinearLUT();
+
+// Box-filtered chain down to 1x1. sRGB inputs are averaged in linear space (alpha is always linear).
+void BuildMipChainRGBA8(MipChain& out, const unsigned char* rgba, int w, int h, bool srgb);
+
+// Cache hit -> mapped chain. Miss -> decode `src`, build the chain and, if `useCache`,
+// write the cache next to it. `levels` is empty if the source can't be loaded.
+MipChain LoadTextureMips(const std::filesystem::path& src, bool srgb, bool useCache);
@@ -0,0 +1,237 @@
+//Textures.cpp
+#include "Textures.h"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+namespace fs = std::filesystem;
+
+static double MsSince(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+DecodedImage DecodeImageRGBA8(const fs::path& path)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+
+    DecodedImage img;
+    int comp = 0;
+
+    // Force 4 channels so OpenGL upload format is always consistent
+    img.pixels.reset(stbi_load(path.string().c_str(), &img.w, &img.h, &comp, 4));
+    if (!img.pixels) {
+        std::cerr << "Failed to load texture: " << path << "\n";
+    }
+
+    img.decodeMs = MsSince(t0);
+    return img;
+}
+
+GLuint Make1x1TextureRGBA(unsigned char r, unsigned char g, unsigned char b, unsigned char a)
+{
+    GLuint tex = 0;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    unsigned char px[4] = { r, g, b, a };
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, px);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return tex;
+}
+
+// ---------------------------
+// TextureBatchLoader
+// ---------------------------
+TextureBatchLoader::TextureBatchLoader(ThreadPool& pool)
+    : m_pool(pool)
+{
+    // Global in stb_image: set here on the GL thread, before any decode task exists
+    stbi_set_flip_vertically_on_load(true);
+}
+
+TextureBatchLoader::~TextureBatchLoader()
+{
+    for (auto& r : m_requests) {
+        if (r->stage != Stage::Copying) continue;
+
+        // The worker is writing into mapped memory: let it finish before unmapping
+        if (r->copied.valid()) r->copied.wait();
+
+        // pbo == 0: the map failed and the copy went to client memory, nothing to unmap
+        if (r->pbo) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, r->pbo);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glDeleteBuffers(1, &r->pbo);
+        }
+    }
+    // Requests still loading just drop their futures (the pool task owns its own state)
+}
+
+void TextureBatchLoader::add(const fs::path& path, bool srgb, DoneFn onDone)
+{
+    auto r = std::make_unique<Request>();
+    r->path = path;
+    r->srgb = srgb;
+    r->onDone = std::move(onDone);
+    const bool useCache = m_useCache;
+    r->loaded = m_pool.submit([path, srgb, useCache]() { return LoadTextureMips(path, srgb, useCache); });
+    m_requests.push_back(std::move(r));
+}
+
+void TextureBatchLoader::startCopy(Request& r)
+{
+    MipChain chain = r.loaded.get();
+    r.loadMs = chain.loadMs;
+    r.fromCache = chain.fromCache;
+
+    if (chain.levels.empty()) {
+        r.stage = Stage::Done;
+        if (r.onDone) r.onDone(0);
+        return;
+    }
+
+    r.w = chain.levels[0].w;
+    r.h = chain.levels[0].h;
+    const GLsizeiptr bytes = (GLsizeiptr)chain.totalBytes;
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    glGenBuffers(1, &r.pbo);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, r.pbo);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    r.uploadMs += MsSince(t0);
+
+    r.mips = std::make_shared<MipChain>(std::move(chain));
+
+    if (!dst) {
+        // No mapping (driver refused): upload straight from client memory instead
+        glDeleteBuffers(1, &r.pbo);
+        r.pbo = 0;
+        r.stage = Stage::Copying;
+        std::promise<double> none;
+        none.set_value(0.0);
+        r.copied = none.get_future();
+        return;
+    }
+
+    // The big memcpy (levels packed back to back) runs on the pool; the buffer
+    // stays mapped until finishUpload(). With a cache hit this is the first time
+    // the mapped pages are actually read.
+    std::shared_ptr<MipChain> src = r.mips;
+    r.copied = m_pool.submit([src, dst]() {
+        const auto c0 = std::chrono::steady_clock::now();
+        unsigned char* out = static_cast<unsigned char*>(dst);
+        for (const auto& lv : src->levels) {
+            std::memcpy(out, lv.data, lv.bytes);
+            out += lv.bytes;
+        }
+        return MsSince(c0);
+    });
+    r.stage = Stage::Copying;
+}
+
+void TextureBatchLoader::finishUpload(Request& r)
+{
+    r.copyMs = r.copied.get();
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    if (r.pbo) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, r.pbo);
+        if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) != GL_TRUE) {
+            // Store got trashed while mapped (rare): fall back to client memory
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glDeleteBuffers(1, &r.pbo);
+            r.pbo = 0;
+        }
+    }
+
+    GLuint tex = 0;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+
+    // Safe even if widths are odd
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // Precomputed chain: no glGenerateMipmap
+    GLenum internalFormat = r.srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+    std::size_t offset = 0;
+    for (std::size_t li = 0; li < r.mips->levels.size(); ++li) {
+        const MipChain::Level& lv = r.mips->levels[li];
+
+        // PBO bound: the pointer argument is a byte offset into it
+        const void* src = r.pbo ? reinterpret_cast<const void*>(offset) : static_cast<const void*>(lv.data);
+        glTexImage2D(GL_TEXTURE_2D, (GLint)li, internalFormat, lv.w, lv.h, 0, GL_RGBA, GL_UNSIGNED_BYTE, src);
+        offset += lv.bytes;
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)r.mips->levels.size() - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (r.pbo) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &r.pbo); // deferred by the driver until the transfer is done
+        r.pbo = 0;
+    }
+
+    r.uploadMs += MsSince(t0);
+
+    r.mips.reset();
+    r.stage = Stage::Done;
+    if (r.onDone) r.onDone(tex);
+}
+
+void TextureBatchLoader::pump()
+{
+    for (auto& rp : m_requests) {
+        Request& r = *rp;
+        if (r.stage == Stage::Loading && IsReady(r.loaded)) startCopy(r);
+        if (r.stage == Stage::Copying && IsReady(r.copied)) finishUpload(r);
+    }
+}
+
+bool TextureBatchLoader::idle() const
+{
+    for (const auto& r : m_requests)
+        if (r->stage != Stage::Done) return false;
+    return true;
+}
+
+void TextureBatchLoader::printTimings(std::ostream& os) const
+{
+    os << "Texture timings (ms):\n";
+    for (const auto& r : m_requests) {
+        os << "  " << std::left << std::setw(40) << r->path.filename().string() << std::right
+            << std::fixed << std::setprecision(2)
+            << (r->fromCache ? " cache " : " png   ")
+            << " load=" << std::setw(8) << r->loadMs
+            << " copy=" << std::setw(7) << r->copyMs
+            << " upload=" << std::setw(7) << r->uploadMs
+            << " (" << r->w << "x" << r->h << ")\n";
+    }
+    os.unsetf(std::ios_base::floatfield);
+}
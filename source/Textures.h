@@ -0,0 +1,94 @@
+//Textures.h
+#pragma once
+#include <glad/glad.h>
+
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <stb_image.h>
+
+#include "ThreadPool.h"
+#include "TextureCache.h"
+
+// Decoded RGBA8 image (CPU only, safe to produce on a worker thread).
+// pixels come from stbi_load, so they go back through stbi_image_free (honours STBI_FREE).
+struct DecodedImage {
+    int w = 0;
+    int h = 0;
+    std::unique_ptr<unsigned char, void (*)(void*)> pixels{ nullptr, stbi_image_free };
+    double decodeMs = 0.0;
+};
+
+// stb_image decode, forced to 4 channels and flipped for GL. Logs and returns an empty image on failure.
+DecodedImage DecodeImageRGBA8(const std::filesystem::path& path);
+
+GLuint Make1x1TextureRGBA(unsigned char r, unsigned char g, unsigned char b, unsigned char a);
+
+// ---------------------------
+// Batch texture loader
+// Every add() loads on the pool right away (mapped .texcache, or PNG decode + CPU mips
+// + cache write on a miss). pump() (GL thread, once per frame) walks each request through:
+//   loaded    -> map a pixel unpack buffer, hand the memcpy of all mip levels to the pool
+//   copied    -> unmap, one glTexImage2D per level from the PBO, call onDone
+// so neither the decode nor the copy into GL memory run on the main thread.
+// ---------------------------
+class TextureBatchLoader {
+public:
+    // tex == 0 if the file failed to load
+    using DoneFn = std::function<void(GLuint tex)>;
+
+    explicit TextureBatchLoader(ThreadPool& pool);
+
+    // Waits for in-flight copies, releases any PBO still mapped
+    ~TextureBatchLoader();
+
+    TextureBatchLoader(const TextureBatchLoader&) = delete;
+    TextureBatchLoader& operator=(const TextureBatchLoader&) = delete;
+
+    void add(const std::filesystem::path& path, bool srgb, DoneFn onDone);
+
+    // Off = always decode the PNG and never write .texcache files (applies to later add() calls)
+    void setUseCache(bool use) { m_useCache = use; }
+
+    // GL thread. Never blocks on the workers.
+    void pump();
+
+    // Everything added so far is uploaded (or failed)
+    bool idle() const;
+
+    // One line per texture: load (cache or PNG) / copy / GL upload time
+    void printTimings(std::ostream& os) const;
+
+private:
+    enum class Stage { Loading, Copying, Done };
+
+    struct Request {
+        std::filesystem::path path;
+        bool   srgb = false;
+        DoneFn onDone;
+        Stage  stage = Stage::Loading;
+
+        std::future<MipChain> loaded;
+        std::shared_ptr<MipChain> mips;      // kept alive until the copy task is done
+        std::future<double> copied;          // returns copy time in ms
+        GLuint pbo = 0;
+
+        bool   fromCache = false;
+        double loadMs = 0.0;
+        double copyMs = 0.0;
+        double uploadMs = 0.0;               // GL-thread time: map + unmap + TexImage per level
+        int w = 0, h = 0;
+    };
+
+    void startCopy(Request& r);
+    void finishUpload(Request& r);
+
+    ThreadPool& m_pool;
+    bool m_useCache = true;
+    std::vector<std::unique_ptr<Request>> m_requests;
+};
@@ -0,0 +1,119 @@
+//ThreadPool.cpp
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    m_workers.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i)
+        m_workers.emplace_back([this]() { workerLoop(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+
+    for (auto& t : m_workers)
+        if (t.joinable()) t.join();
+}
+
+void ThreadPool::workerLoop()
+{
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+
+            // Drain the queue before honouring stop
+            if (m_tasks.empty()) return;
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task(); // packaged_task stores exceptions in the future
+    }
+}
+
+void ParallelFor(int count, const std::function<void(int begin, int end)>& fn, unsigned threads)
+{
+    if (count <= 0) return;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, (unsigned)count);
+
+    if (threads == 1) {
+        fn(0, count);
+        return;
+    }
+
+    // The calling thread takes the last range itself
+    std::vector<std::future<void>> parts;
+    parts.reserve(threads - 1);
+
+    const int per = count / (int)threads;
+    const int extra = count % (int)threads;
+    int begin = 0;
+    for (unsigned t = 0; t < threads; ++t) {
+        const int end = begin + per + ((int)t < extra ? 1 : 0);
+        if (t + 1 == threads) fn(begin, end);
+        else parts.push_back(std::async(std::launch::async, [&fn, begin, end]() { fn(begin, end); }));
+        begin = end;
+    }
+
+    for (auto& f : parts) f.get(); // rethrows the first worker exception
+}
+
+void ParallelForEach(int count, const std::function<void(int index, unsigned worker)>& fn, unsigned threads)
+{
+    if (count <= 0) return;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, (unsigned)count);
+
+    std::atomic<int> next{ 0 };
+    std::atomic<bool> failed{ false };
+    auto work = [&](unsigned worker) {
+        while (!failed.load(std::memory_order_relaxed)) {
+            const int i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= count) return;
+            try {
+                fn(i, worker);
+            }
+            catch (...) {
+                failed = true;
+                throw;
+            }
+        }
+    };
+
+    // The calling thread is the last worker
+    std::vector<std::future<void>> parts;
+    parts.reserve(threads - 1);
+    for (unsigned t = 0; t + 1 < threads; ++t)
+        parts.push_back(std::async(std::launch::async, work, t));
+
+    std::exception_ptr first;
+    try {
+        work(threads - 1);
+    }
+    catch (...) {
+        first = std::current_exception();
+    }
+    for (auto& f : parts) {
+        try {
+            f.get();
+        }
+        catch (...) {
+            if (!first) first = std::current_exception();
+        }
+    }
+    if (first) std::rethrow_exception(first);
+}
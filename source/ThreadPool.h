@@ -0,0 +1,70 @@
+//ThreadPool.h
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed-size worker pool for CPU-only jobs (image decode, mesh building, ...).
+// Never touch OpenGL from a pool task: the context lives on the main thread.
+class ThreadPool {
+public:
+    // threads == 0 -> one per hardware thread
+    explicit ThreadPool(unsigned threads = 0);
+
+    // Finishes whatever is already queued, then joins
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template <class F>
+    auto submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+    {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        std::future<R> fut = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.emplace_back([task]() { (*task)(); });
+        }
+        m_cv.notify_one();
+        return fut;
+    }
+
+    unsigned size() const { return (unsigned)m_workers.size(); }
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop = false;
+};
+
+// Non-blocking readiness check for futures coming out of the pool
+template <class T>
+bool IsReady(const std::future<T>& f)
+{
+    return f.valid() && f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+// Splits [0, count) into contiguous ranges and runs fn(begin, end) on short-lived threads,
+// returning when all are done. Safe to call from inside a pool task (it never queues onto
+// the pool, so it can't deadlock waiting on itself). threads == 0 -> one per hardware thread.
+void ParallelFor(int count, const std::function<void(int begin, int end)>& fn, unsigned threads = 0);
+
+// Same threads, but for items of very uneven cost: every thread takes the next index as soon
+// as it finishes the last one, so nobody sits idle while another still has a long tail.
+// `worker` is in [0, threads) and fixed per thread (index per-thread scratch with it).
+// After an exception the remaining items are skipped and the first exception is rethrown.
+void ParallelForEach(int count, const std::function<void(int index, unsigned worker)>& fn, unsigned threads = 0);
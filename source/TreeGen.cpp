@@ -1,15 +1,19 @@
 //TreeGen.cpp
 #include "TreeGen.h"
 #include "LSystem.h"
+#include "Stats.h"
 
 #include <random>
 #include <cstdint>
 #include <algorithm>
 
 #include <cmath>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 #include <glm/gtc/matrix_transform.hpp>
-#include <iostream>
 
 struct TurtleState {
     glm::mat4 transform;
@@ -32,12 +36,81 @@ struct TurtleState {
 
 };
 
+// ---------------------------
+// Geometry templates
+// Unit ring and unit sphere directions for one (radial, lat, lon) segment count. Every
+// segment and joint sphere of a tree uses the same ones, so the trig runs once per template
+// instead of once per segment. Built on first use and shared read-only by every thread
+// (same expressions as before, so the vertices come out bit for bit the same).
+// ---------------------------
+struct RingPoint {
+    float t;           // fraction around the ring (U before the bark repeats)
+    float c, s;        // cos / sin of the angle
+    glm::vec3 tangent; // increasing U
+};
+
+struct GeometryTemplates {
+    int radialSegments = 0;
+    int latSegments = 0;
+    int lonSegments = 0;
+    std::vector<RingPoint> ring;     // radialSegments + 1, the last one closes the ring
+    std::vector<glm::vec3> sphereN;  // (lat + 1) rows of (lon + 1)
+    std::vector<glm::vec3> sphereT;  // lon + 1
+};
+
+static std::shared_ptr<const GeometryTemplates> GetGeometryTemplates(int radialSegments, int latSegments, int lonSegments)
+{
+    static std::mutex mutex;
+    static std::vector<std::shared_ptr<const GeometryTemplates>> cache; // a handful at most
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& t : cache) {
+        if (t->radialSegments == radialSegments && t->latSegments == latSegments && t->lonSegments == lonSegments)
+            return t;
+    }
+
+    const float PI = 3.14159265359f;
+    const float TWO_PI = 6.28318530718f;
+
+    auto t = std::make_shared<GeometryTemplates>();
+    t->radialSegments = radialSegments;
+    t->latSegments = latSegments;
+    t->lonSegments = lonSegments;
+
+    for (int i = 0; radialSegments > 0 && i <= radialSegments; ++i) {
+        RingPoint r;
+        r.t = static_cast<float>(i) / radialSegments;
+        const float a = r.t * TWO_PI;
+        r.c = std::cos(a);
+        r.s = std::sin(a);
+        r.tangent = glm::normalize(glm::vec3(-std::sin(a), 0.0f, std::cos(a)));
+        t->ring.push_back(r);
+    }
+
+    if (latSegments > 0 && lonSegments > 0) {
+        for (int lat = 0; lat <= latSegments; ++lat) {
+            const float phi = (static_cast<float>(lat) / latSegments) * PI;
+            for (int lon = 0; lon <= lonSegments; ++lon) {
+                const float th = (static_cast<float>(lon) / lonSegments) * TWO_PI;
+                t->sphereN.push_back(glm::vec3(std::sin(phi) * std::cos(th), std::cos(phi), std::sin(phi) * std::sin(th)));
+            }
+        }
+        for (int lon = 0; lon <= lonSegments; ++lon) {
+            const float th = (static_cast<float>(lon) / lonSegments) * TWO_PI;
+            t->sphereT.push_back(glm::vec3(-std::sin(th), 0.0f, std::cos(th)));
+        }
+    }
+
+    cache.push_back(t);
+    return t;
+}
+
 static void appendFrustumSegment(std::vector<VertexPN>& out,
     float length,
     float radiusBottom,
     float radiusTop,
     const glm::mat4& transform,
-    int radialSegments,
+    const GeometryTemplates& tpl,
     float v0World,
     float v1World,
     float barkRepeatWorldU,
@@ -63,30 +136,24 @@ static void appendFrustumSegment(std::vector<VertexPN>& out,
     };
 
     const float avgR = 0.5f * (radiusBottom + radiusTop);
+    const float repeatsU = std::max(1.0f, std::round((TWO_PI * avgR) / uWorld));
 
     // Pre-scale V once (world -> UV space)
     const float vb = v0World / vWorld;
     const float vt = v1World / vWorld;
 
-    for (int i = 0; i < radialSegments; ++i) {
-        float t0 = static_cast<float>(i) / radialSegments;
-        float t1 = static_cast<float>(i + 1) / radialSegments;
-
-        float a0 = t0 * TWO_PI;
-        float a1 = t1 * TWO_PI;
+    for (int i = 0; i < tpl.radialSegments; ++i) {
+        const RingPoint& r0 = tpl.ring[i];
+        const RingPoint& r1 = tpl.ring[i + 1];
 
-        glm::vec3 p0b(radiusBottom * std::cos(a0), 0.0f, radiusBottom * std::sin(a0));
-        glm::vec3 p1b(radiusBottom * std::cos(a1), 0.0f, radiusBottom * std::sin(a1));
-        glm::vec3 p0t(radiusTop * std::cos(a0), length, radiusTop * std::sin(a0));
-        glm::vec3 p1t(radiusTop * std::cos(a1), length, radiusTop * std::sin(a1));
+        glm::vec3 p0b(radiusBottom * r0.c, 0.0f, radiusBottom * r0.s);
+        glm::vec3 p1b(radiusBottom * r1.c, 0.0f, radiusBottom * r1.s);
+        glm::vec3 p0t(radiusTop * r0.c, length, radiusTop * r0.s);
+        glm::vec3 p1t(radiusTop * r1.c, length, radiusTop * r1.s);
 
         // Better frustum-side normals (includes taper slope)
-        glm::vec3 n0 = glm::normalize(glm::vec3(std::cos(a0), -k, std::sin(a0)));
-        glm::vec3 n1 = glm::normalize(glm::vec3(std::cos(a1), -k, std::sin(a1)));
-
-        // Tangent direction for increasing U (around the trunk)
-        glm::vec3 t0dir = glm::normalize(glm::vec3(-std::sin(a0), 0.0f, std::cos(a0)));
-        glm::vec3 t1dir = glm::normalize(glm::vec3(-std::sin(a1), 0.0f, std::cos(a1)));
+        glm::vec3 n0 = glm::normalize(glm::vec3(r0.c, -k, r0.s));
+        glm::vec3 n1 = glm::normalize(glm::vec3(r1.c, -k, r1.s));
 
         // World-space values
         glm::vec3 tp0b = XformPos(p0b);
@@ -97,12 +164,12 @@ static void appendFrustumSegment(std::vector<VertexPN>& out,
         glm::vec3 wn0 = XformDir(n0);
         glm::vec3 wn1 = XformDir(n1);
 
-        glm::vec3 wt0 = XformDir(t0dir);
-        glm::vec3 wt1 = XformDir(t1dir);
+        // Tangent direction for increasing U (around the trunk)
+        glm::vec3 wt0 = XformDir(r0.tangent);
+        glm::vec3 wt1 = XformDir(r1.tangent);
 
-        float repeatsU = std::max(1.0f, std::round((TWO_PI * avgR) / uWorld));
-        float u0 = t0 * repeatsU;
-        float u1 = t1 * repeatsU;
+        float u0 = r0.t * repeatsU;
+        float u1 = r1.t * repeatsU;
 
         auto push = [&](const glm::vec3& wp,
             const glm::vec3& wn,
@@ -127,11 +194,11 @@ static void appendFrustumSegment(std::vector<VertexPN>& out,
 static void appendSphere(std::vector<VertexPN>& out,
     float radius,
     const glm::mat4& transform,
-    int latSegments,
-    int lonSegments)
+    const GeometryTemplates& tpl)
 {
-    const float PI = 3.14159265359f;
-    const float TWO_PI = 6.28318530718f;
+    const int latSegments = tpl.latSegments;
+    const int lonSegments = tpl.lonSegments;
+    if (tpl.sphereN.empty()) return;
 
     const glm::mat3 normalMatrix = glm::mat3(transform);
 
@@ -155,24 +222,19 @@ static void appendSphere(std::vector<VertexPN>& out,
         out.push_back({ wp, wn, glm::vec2(u, v), glm::vec4(wt, 1.0f) });
     };
 
+    const int row = lonSegments + 1;
     for (int lat = 0; lat < latSegments; ++lat) {
         float v0 = static_cast<float>(lat) / latSegments;
         float v1 = static_cast<float>(lat + 1) / latSegments;
 
-        float phi0 = v0 * PI;
-        float phi1 = v1 * PI;
-
         for (int lon = 0; lon < lonSegments; ++lon) {
             float u0 = static_cast<float>(lon) / lonSegments;
             float u1 = static_cast<float>(lon + 1) / lonSegments;
 
-            float th0 = u0 * TWO_PI;
-            float th1 = u1 * TWO_PI;
-
-            glm::vec3 n00(std::sin(phi0) * std::cos(th0), std::cos(phi0), std::sin(phi0) * std::sin(th0));
-            glm::vec3 n01(std::sin(phi0) * std::cos(th1), std::cos(phi0), std::sin(phi0) * std::sin(th1));
-            glm::vec3 n10(std::sin(phi1) * std::cos(th0), std::cos(phi1), std::sin(phi1) * std::sin(th0));
-            glm::vec3 n11(std::sin(phi1) * std::cos(th1), std::cos(phi1), std::sin(phi1) * std::sin(th1));
+            const glm::vec3& n00 = tpl.sphereN[lat * row + lon];
+            const glm::vec3& n01 = tpl.sphereN[lat * row + lon + 1];
+            const glm::vec3& n10 = tpl.sphereN[(lat + 1) * row + lon];
+            const glm::vec3& n11 = tpl.sphereN[(lat + 1) * row + lon + 1];
 
             glm::vec3 p00 = radius * n00;
             glm::vec3 p01 = radius * n01;
@@ -180,8 +242,8 @@ static void appendSphere(std::vector<VertexPN>& out,
             glm::vec3 p11 = radius * n11;
 
             // Tangent for increasing theta (u direction)
-            glm::vec3 t0(-std::sin(th0), 0.0f, std::cos(th0));
-            glm::vec3 t1(-std::sin(th1), 0.0f, std::cos(th1));
+            const glm::vec3& t0 = tpl.sphereT[lon];
+            const glm::vec3& t1 = tpl.sphereT[lon + 1];
 
             push(p00, n00, t0, u0, v0);
             push(p10, n10, t0, u0, v1);
@@ -382,9 +444,48 @@ static void SetupConiferGrammar(LSystem& lsys, const TreeParams& p)
 }
 
 
-std::vector<VertexPN> BuildTreeVertices(const TreeParams& p)
+void SetupTreeGrammar(LSystem& lsys, const TreeParams& p)
 {
-    std::vector<VertexPN> verts;
+    if (p.preset == TreePreset::Deciduous)
+        SetupDeciduousGrammar(lsys, p);
+    else
+        SetupConiferGrammar(lsys, p);
+}
+
+// Shared body of BuildTreeVertices / BuildTreeVerticesStreamed.
+// With onChunk == nullptr everything stays in `verts`; otherwise `verts` only
+// ever holds the unflushed tail (< chunkVerts + one segment).
+static std::size_t BuildTreeImpl(const TreeParams& p,
+    std::vector<VertexPN>& verts,
+    std::size_t chunkVerts,
+    const TreeChunkFn* onChunk,
+    const std::atomic<bool>* cancel,
+    TreeBuildInfo* info,
+    TreeSentenceCache* sentences,
+    TreeBuildArena* arena = nullptr)
+{
+    Stats* stats = info ? &info->stats : nullptr;
+    if (stats) *stats = Stats{};
+    STATS_PHASE_VAR(derivePhase, stats, "derive");
+    std::size_t segments = 0, spheres = 0;
+
+    auto checkCancel = [&]() {
+        if (cancel && cancel->load(std::memory_order_relaxed)) throw TreeBuildCancelled();
+    };
+
+    std::size_t flushedVerts = 0;
+
+    // Streaming: hand out every full chunk and keep only the remainder
+    auto flushFullChunks = [&]() {
+        if (!onChunk || verts.size() < chunkVerts) return;
+        std::size_t off = 0;
+        while (verts.size() - off >= chunkVerts) {
+            (*onChunk)(verts.data() + off, chunkVerts);
+            off += chunkVerts;
+        }
+        verts.erase(verts.begin(), verts.begin() + off);
+        flushedVerts += off;
+    };
 
     // RNG for interpreter-side jitter (separate from L-system RNG)
     std::mt19937 rng(p.seed);
@@ -416,22 +517,29 @@ std::vector<VertexPN> BuildTreeVertices(const TreeParams& p)
     };
 
 
-    //Instead of the whole decidious rule grammar we set the helper function
-    LSystem lsys;
-    if (p.preset == TreePreset::Deciduous)
-        SetupDeciduousGrammar(lsys, p);
-    else
-        SetupConiferGrammar(lsys, p);
-    
-
-    std::string sentence = lsys.generate(p.iterations);
-
-    // Print Stats
-    std::cout << "seed=" << p.seed
-        << " iter=" << p.iterations
-        << " enableSkip=" << p.enableBranchSkipping
-        << " sentenceLen=" << sentence.size()
-        << "\n";
+    // Sentence: from the cache, else rewritten with the shared preset grammar into the
+    // arena's buffers (or fresh ones when it has to go into the cache)
+    std::shared_ptr<const std::string> derived = sentences ? sentences->find(p) : nullptr;
+    const bool sentenceCached = derived != nullptr;
+    const std::string* sentencePtr = derived.get();
+    if (!derived) {
+        std::mt19937 lsysRng(p.seed); // what SetupTreeGrammar's setSeed does
+        if (arena && !sentences) {
+            PresetGrammar(p.preset).generate(p.iterations, lsysRng, arena->sentence, arena->rewrite, cancel);
+            sentencePtr = &arena->sentence;
+        }
+        else {
+            auto fresh = std::make_shared<std::string>();
+            std::string scratch;
+            PresetGrammar(p.preset).generate(p.iterations, lsysRng, *fresh, scratch, cancel);
+            checkCancel(); // generate() bails out early with a partial sentence
+            if (sentences) sentences->insert(p, fresh);
+            derived = std::move(fresh);
+            sentencePtr = derived.get();
+        }
+        checkCancel();
+    }
+    const std::string& sentence = *sentencePtr;
 
     size_t countF = 0, countX = 0, countY = 0, countC = 0, countT = 0, countBrack = 0;
     for (char c : sentence) {
@@ -442,8 +550,19 @@ std::vector<VertexPN> BuildTreeVertices(const TreeParams& p)
         else if (c == 'T') ++countT;
         else if (c == '[') ++countBrack;
     }
-    std::cout << "F=" << countF << " X=" << countX << " Y=" << countY
-        << " C=" << countC << " T=" << countT << " [=" << countBrack << "\n";
+    STATS_COUNT(stats, "sentence_length", sentence.size());
+    STATS_COUNT(stats, "F", countF);
+    STATS_COUNT(stats, "X", countX);
+    STATS_COUNT(stats, "Y", countY);
+    STATS_COUNT(stats, "C", countC);
+    STATS_COUNT(stats, "T", countT);
+    STATS_COUNT(stats, "[", countBrack);
+    STATS_PHASE_END(derivePhase);
+
+    STATS_PHASE_VAR(interpretPhase, stats, "interpret");
+
+    const std::shared_ptr<const GeometryTemplates> geometry =
+        GetGeometryTemplates(p.radialSegments, p.sphereLatSegments, p.sphereLonSegments);
 
     // 2) Turtle init
     TurtleState cur;
@@ -465,8 +584,6 @@ std::vector<VertexPN> BuildTreeVertices(const TreeParams& p)
     std::uint32_t branchIndex = 0;
     std::uint32_t trunkBranchIndex = 0;
 
-    std::cout << "[TreeGen] BUILD MARKER: 2025-12-17 A\n";
-
     // Helper: apply a local-space rotation (post-multiply)
     //auto rotateLocal = [&](float radians, const glm::vec3& localAxis) {
     //    cur.transform = cur.transform * glm::rotate(glm::mat4(1.0f), radians, localAxis);
@@ -590,6 +707,8 @@ std::vector<VertexPN> BuildTreeVertices(const TreeParams& p)
 
     // 3) Interpret
     for (size_t i = 0; i < sentence.size(); ++i) {
+        if ((i & 0xFFF) == 0) checkCancel();
+
         char c = sentence[i];
         switch (c) {
         case 'F': {
@@ -682,19 +801,26 @@ std::vector<VertexPN> BuildTreeVertices(const TreeParams& p)
             float v1World = cur.barkV + len;
 
             if (draw) {
-                if (p.addSpheres) {
-                    appendSphere(verts, rBottom, cur.transform, p.sphereLatSegments, p.sphereLonSegments);
+                {
+                    STATS_PHASE_UNTRACED(stats, "mesh"); // one per segment: no trace events
+                    if (p.addSpheres) {
+                        appendSphere(verts, rBottom, cur.transform, *geometry);
+                        ++spheres;
+                    }
+                    ++segments;
+                    appendFrustumSegment(verts,
+                        len,
+                        rBottom,
+                        rTop,
+                        cur.transform,
+                        *geometry,
+                        v0World,
+                        v1World,
+                        p.barkRepeatWorldU,
+                        p.barkRepeatWorldV);
                 }
-                appendFrustumSegment(verts,
-                    len,
-                    rBottom,
-                    rTop,
-                    cur.transform,
-                    p.radialSegments,
-                    v0World,
-                    v1World,
-                    p.barkRepeatWorldU,
-                    p.barkRepeatWorldV);
+
+                flushFullChunks();
             }
 
             // Advance bark mapping even if we stop drawing (keeps UVs consistent)
@@ -885,10 +1011,405 @@ std::vector<VertexPN> BuildTreeVertices(const TreeParams& p)
         }
     }
 
-    std::cout << "trunkBranchStarts=" << trunkBranchStarts
-        << " nonTrunkBranchStarts=" << nonTrunkBranchStarts << "\n";
+    STATS_PHASE_END(interpretPhase);
+
+    STATS_COUNT(stats, "trunk_branch_starts", trunkBranchStarts);
+    STATS_COUNT(stats, "non_trunk_branch_starts", nonTrunkBranchStarts);
+    STATS_COUNT(stats, "skipped_branches", skippedBranches);
+    STATS_COUNT(stats, "segments", segments);
+    STATS_COUNT(stats, "spheres", spheres);
+
+    // Last (partial) chunk
+    if (onChunk && !verts.empty()) {
+        (*onChunk)(verts.data(), verts.size());
+        flushedVerts += verts.size();
+        verts.clear();
+    }
+
+    const std::size_t total = onChunk ? flushedVerts : verts.size();
+    STATS_COUNT(stats, "vertices", total);
+    if (info) {
+        info->sentenceLength = sentence.size();
+        info->sentenceCached = sentenceCached;
+        info->forwardSymbols = countF;
+        info->segments = segments;
+        info->spheres = spheres;
+        info->vertices = total;
+        info->rewriteMs = info->stats.phaseMs("derive");
+        info->interpretMs = info->stats.phaseMs("interpret");
+        info->meshMs = info->stats.phaseMs("mesh");
+        if (kAllocStats) {
+            const Stats::Phase* derive = info->stats.phase("derive");
+            const Stats::Phase* interpret = info->stats.phase("interpret");
+            const Stats::Phase* mesh = info->stats.phase("mesh");
+            if (derive) info->rewriteAllocs = { derive->allocs, derive->allocBytes, 0, derive->peakBytes };
+            if (mesh) info->meshAllocs = { mesh->allocs, mesh->allocBytes, 0, mesh->peakBytes };
+            if (interpret) {
+                info->turtleAllocs = { interpret->allocs - info->meshAllocs.count,
+                    interpret->allocBytes - info->meshAllocs.bytes, 0, interpret->peakBytes };
+            }
+        }
+    }
+    return total;
+}
+
+// The rules don't depend on the params (setSeed aside), so defaults do
+static LGrammar MakePresetGrammar(TreePreset preset)
+{
+    TreeParams p;
+    p.preset = preset;
+    LSystem lsys;
+    SetupTreeGrammar(lsys, p);
+    return LGrammar(lsys);
+}
+
+const LGrammar& PresetGrammar(TreePreset preset)
+{
+    // Function statics: built once, thread-safe
+    static const LGrammar deciduous = MakePresetGrammar(TreePreset::Deciduous);
+    static const LGrammar conifer = MakePresetGrammar(TreePreset::Conifer);
+    return preset == TreePreset::Conifer ? conifer : deciduous;
+}
+
+std::size_t BuildTreeVerticesInto(const TreeParams& p, TreeBuildArena& arena, TreeBuildInfo* info)
+{
+    arena.vertices.clear();
+    return BuildTreeImpl(p, arena.vertices, 0, nullptr, nullptr, info, nullptr, &arena);
+}
+
+std::vector<VertexPN> BuildTreeVertices(const TreeParams& p, TreeBuildInfo* info, TreeSentenceCache* sentences)
+{
+    std::vector<VertexPN> verts;
+    BuildTreeImpl(p, verts, 0, nullptr, nullptr, info, sentences);
+    return verts;
+}
+
+std::size_t BuildTreeVerticesStreamed(const TreeParams& p, std::size_t chunkVerts, const TreeChunkFn& onChunk,
+    const std::atomic<bool>* cancel, TreeBuildInfo* info, TreeSentenceCache* sentences)
+{
+    chunkVerts = std::max<std::size_t>(1, chunkVerts);
+
+    // Chunk + headroom for the segment that pushes us over the edge
+    std::vector<VertexPN> tail;
+    tail.reserve(chunkVerts + 4096);
+
+    return BuildTreeImpl(p, tail, chunkVerts, &onChunk, cancel, info, sentences);
+}
+
+// ---------------------------
+// Sentence cache
+// ---------------------------
+static std::uint64_t SentenceKey(const TreeParams& p)
+{
+    return (std::uint64_t(p.preset) << 56) ^ (std::uint64_t(std::uint32_t(p.iterations)) << 32) ^ p.seed;
+}
+
+TreeSentenceCache::TreeSentenceCache(std::size_t maxBytes)
+    : m_maxBytes(maxBytes)
+{
+}
+
+std::shared_ptr<const std::string> TreeSentenceCache::find(const TreeParams& p)
+{
+    const std::uint64_t key = SentenceKey(p);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_lru.begin(); it != m_lru.end(); ++it) {
+        if (it->key != key) continue;
+        m_lru.splice(m_lru.begin(), m_lru, it);
+        ++m_hits;
+        return m_lru.front().sentence;
+    }
+    ++m_misses;
+    return nullptr;
+}
+
+// Two builds missing the same key at once both derive it; the second insert is dropped
+void TreeSentenceCache::insert(const TreeParams& p, std::shared_ptr<const std::string> sentence)
+{
+    const std::uint64_t key = SentenceKey(p);
+    const std::size_t size = sentence->size();
+    if (size > m_maxBytes) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const Entry& e : m_lru) {
+        if (e.key == key) return;
+    }
+    m_lru.push_front({ key, std::move(sentence) });
+    m_bytes += size;
+    while (m_bytes > m_maxBytes) {
+        m_bytes -= m_lru.back().sentence->size();
+        m_lru.pop_back();
+    }
+}
+
+std::size_t TreeSentenceCache::hits() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hits;
+}
+
+std::size_t TreeSentenceCache::misses() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_misses;
+}
+
+std::size_t TreeSentenceCache::bytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes;
+}
+
+// ---------------------------
+// Preset tuning
+// ---------------------------
+void ApplyTreePreset(TreeParams& p)
+{
+    p.iterations = 15;          // start lower to avoid twig explosion; bump to 15 if too sparse
+
+    p.radialSegments = 12;
+
+    //p.seed = 1166707377;
+    p.addSpheres = true;
+
+    p.branchAngleDeg = 22.0f;
+
+    p.usePhyllotaxisRoll = true;
+    p.phyllotaxisDeg = 137.5f;
+
+    p.branchPitchMaxDeg = 60.0f;   // was 45 (or 35 earlier)
+
+    p.baseRadius = 0.55f;
+    p.baseLength = 1.6f;
+
+    p.enableBranchSkipping = false;
+    p.branchSkipMaxProb = 0.25f; // keep it mild for now
+    p.branchSkipStartDepth = 3;
+    p.minRadiusForBranch = 0.040f;
+    p.depthFullEffect = 10;
+
+
+    p.enableTropism = true;
+    p.tropismDir = glm::vec3(0, 1, 0);
+    p.tropismStrength = 0.015f;
+    p.tropismThinBoost = 0.18f;
+
+    p.maxLenToRadius = 14.0f;   // fine
+
+    p.minBranchSpacing = 1;   // 2 will kills most branches!!!!!!
+    p.maxBranchesPerNode = 128;   // start generous
+
+    p.branchRadiusDecay = 0.75f;   // helps preserve twig thickness
+    p.branchLengthDecay = 0.85f;   // longer sub-branches than 0.55
+    p.twigLengthBoost = 0.15f;    // 0.30 shortens twigs a lot -> looks fuzzy and cramped
+
+    p.angleJitterDeg = 17.0f;    // less random-looking noise
+
+    p.lengthJitterFrac = 0.08f; // more consistent segment lengths
+    p.radiusJitterFrac = 0.06f; // less sparkly thickness noise
+
+    p.branchRollJitterDeg = 35.0f; // 90 makes distribution look chaotic; phyllotaxis already spreads 360
+    p.branchPitchMinDeg = 15.0f;
+    p.branchPitchMaxDeg = 50.0f;   // better 3D crown without relying on huge roll jitter
+
+    p.enableRadiusPruning = true;
+    p.pruneRadius = 0.0020f;       // prune more of the ultra-fine structural recursion (reduces clutter)
+
+    p.minRadius = 0.0016f;         // draw fewer micro-twigs
+    p.minLength = 0.010f;          // avoid tiny hair segments
+
+    p.enableCrookedness = true;
+
+    // stronger than 1, but not insane
+    p.crookStrength = 2.4f;
+
+    // bigger noise = more zig-zag
+    p.crookAccelDeg = 18.0f;
+
+    // smoothing: 0.85–0.95 is the useful range
+    p.crookDamping = 0.10f;
+
+    p.enableTrunkTaperCurve = false;
+
+    p.trunkTaperPower = 2.2f;
+
+    p.trunkTaperTopMult = 0.95f;
+
+    //new conifer params
+    if (p.preset == TreePreset::Conifer) {
+
+        p.addSpheres = true;
+
+        // Spruce: enough iterations for tufting, without blowing up too hard
+        p.iterations = 15;
+
+        // Trunk / taper: avoid “everything shrinks linearly with height”
+        p.baseRadius = 0.30f;
+        p.baseLength = 1.5f;   // slightly shorter = more whorl nodes
+        p.radiusDecayF = 0.955f;  // gentler continuous taper (big difference)
+        p.lengthDecayF = 0.955f;  // trunk segments don’t shrink away quickly
+
+        // Enable curved taper for trunk (keeps base sturdy, tapers more near the top)
+        p.enableTrunkTaperCurve = true;
+        p.trunkTaperPower = 1.35f;
+        p.trunkTaperTopMult = 0.75f; //0.92
+
+        //enable scaffold taper curve 
+        p.enableScaffoldTaperCurve = true;
+
+
+        // Branch scaling at '[' : THIS fixes “branches are too thin”
+        p.branchRadiusDecay = 0.38f;  // (was 0.20!) big improvement to scaffold thickness
+        p.branchLengthDecay = 0.60f;  // branches start shorter than trunk, but not tiny
+
+        // Angles: smaller angle + grammar controls whorl tilt (spruce look)
+        p.branchAngleDeg = 35.0f;
+        p.angleJitterDeg = 5.0f;
+
+        // Mild geometry noise (breaks symmetry without chaos)
+        p.lengthJitterFrac = 0.05f;
+        p.radiusJitterFrac = 0.02f;
+
+        // Distribute branches around trunk
+        p.usePhyllotaxisRoll = true;
+        p.phyllotaxisDeg = 137.5f;
+        p.branchRollJitterDeg = 10.0f;
+
+        // Allow a small random pitch kick to break perfect tier symmetry
+        p.branchPitchMinDeg = 3.0f;
+        p.branchPitchMaxDeg = 10.0f;
+
+        // Branch crowding controls
+        p.maxBranchesPerNode = 115;
+        p.minBranchSpacing = 1;
+
+        // Optional skipping (creates gaps, reduces “uniform cone” feeling)
+        p.enableBranchSkipping = false; // too inconsistent atm
+        p.branchSkipMaxProb = 0.15f;
+        p.branchSkipStartDepth = 3;
+        p.minRadiusForBranch = 0.010f;
+
+        // IMPORTANT: keep trunk from entering “twig scaling” too early
+        p.depthFullEffect = 40;
+
+        // Tropism: for spruce, use slight downward bend (droop)
+        p.enableTropism = true;
+        p.tropismDir = glm::vec3(0, 1, 0);
+        p.tropismStrength = 0.008f;
+        p.tropismThinBoost = 0.25f;
+
+        // Twigs: don’t over-shorten (old 0.6 made upper structure collapse)
+        p.twigLengthBoost = 0.20f;
+        p.maxLenToRadius = 14.0f;
+
+        // Pruning / visibility (keeps tips from turning into hair)
+        p.enableRadiusPruning = false;
+        p.pruneRadius = 0.0015f;
+
+        p.minRadius = 0.0012f;
+        p.minLength = 0.012f;
+
+        // Crookedness
+        p.enableCrookedness = false;
+        p.crookStrength = 0.5f;
+        p.crookAccelDeg = 20.2f;
+        p.crookDamping = 0.10f;
+
+        p.radialSegments = 8;
+
+        p.enableCrookedness = true;
+    }
+
+    if (p.preset == TreePreset::Conifer) {
+        p.barkRepeatWorldU = 1.10f;
+        p.barkRepeatWorldV = 2.00f;
+    }
+    else { // Deciduous
+        p.barkRepeatWorldU = 1.60f;
+        p.barkRepeatWorldV = 2.60f;
+    }
+}
+
+BarkTextureFiles PresetBarkTextures(TreePreset preset)
+{
+    if (preset == TreePreset::Conifer) {
+        return { "pine_bark_1k.blend/pine_bark_diff_1k.png",
+                 "pine_bark_1k.blend/pine_bark_nor_gl_1k.png",
+                 "pine_bark_1k.blend/pine_bark_rough_1k.png" };
+    }
+    return { "bark_brown_02_1k.blend/bark_brown_02_diff_1k.png",
+             "bark_brown_02_1k.blend/bark_brown_02_nor_gl_1k.png",
+             "bark_brown_02_1k.blend/bark_brown_02_rough_1k.png" };
+}
+
+// ---------------------------
+// Params hash
+// ---------------------------
+namespace {
+
+struct ParamsHasher {
+    std::uint64_t h = 1469598103934665603ull; // FNV-1a
+
+    template <class T>
+    ParamsHasher& operator<<(const T& v)
+    {
+        unsigned char bytes[sizeof(T)];
+        std::memcpy(bytes, &v, sizeof(T));
+        for (unsigned char b : bytes) {
+            h ^= b;
+            h *= 1099511628211ull;
+        }
+        return *this;
+    }
+    ParamsHasher& operator<<(const glm::vec3& v) { return *this << v.x << v.y << v.z; }
+    ParamsHasher& operator<<(bool v) { return *this << (std::uint8_t)(v ? 1 : 0); }
+};
+
+} // namespace
+
+// Field by field: struct padding isn't guaranteed to be zero, so hashing the raw bytes of p
+// would make equal params hash differently. New TreeParams fields must be added here.
+std::uint64_t HashTreeParams(const TreeParams& p)
+{
+    ParamsHasher s;
+    s << kTreeGenVersion << (std::uint32_t)p.preset << p.iterations << p.seed
+        << p.baseRadius << p.baseLength << p.radiusDecayF << p.lengthDecayF << p.branchRadiusDecay
+        << p.branchAngleDeg << p.radialSegments
+        << p.addSpheres << p.sphereLatSegments << p.sphereLonSegments << p.baseTranslation
+        << p.angleJitterDeg << p.lengthJitterFrac << p.radiusJitterFrac
+        << p.usePhyllotaxisRoll << p.phyllotaxisDeg << p.branchRollJitterDeg
+        << p.minRadius << p.minLength
+        << p.enableBranchSkipping << p.branchSkipStartDepth << p.branchSkipMaxProb << p.minRadiusForBranch
+        << p.minBranchSpacing << p.maxBranchesPerNode << p.depthFullEffect
+        << p.branchPitchMinDeg << p.branchPitchMaxDeg
+        << p.enableTropism << p.tropismDir << p.tropismStrength << p.tropismThinBoost
+        << p.branchLengthDecay << p.twigLengthBoost << p.maxLenToRadius
+        << p.enableRadiusPruning << p.pruneRadius
+        << p.enableCrookedness << p.crookStrength << p.crookAccelDeg << p.crookDamping
+        << p.enableTrunkTaperCurve << p.trunkTaperPower << p.trunkTaperTopMult
+        << p.barkRepeatWorldU << p.barkRepeatWorldV << p.resetBarkVOnBranch
+        << p.enableScaffoldTaperCurve;
+    return s.h;
+}
+
+std::vector<VertexPN> BuildPlaceholderVertices(const TreeParams& p)
+{
+    std::vector<VertexPN> verts;
 
-    std::cout << "skippedBranches=" << skippedBranches << "\n";
+    // A plain tapered stub roughly where the real trunk will be
+    const float len = 4.0f * p.baseLength;
+    const glm::mat4 xf = glm::translate(glm::mat4(1.0f), p.baseTranslation);
+
+    appendFrustumSegment(verts,
+        len,
+        p.baseRadius,
+        p.baseRadius * 0.6f,
+        xf,
+        *GetGeometryTemplates(std::max(3, p.radialSegments), 0, 0),
+        0.0f,
+        len,
+        p.barkRepeatWorldU,
+        p.barkRepeatWorldV);
 
     return verts;
 }
@@ -4,6 +4,16 @@
 #include <cstdint> 
 #include <glm/glm.hpp>
 #include <random>
+#include <cstddef>
+#include <functional>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#include "Stats.h"
 
 struct VertexPN {
     glm::vec3 pos;
@@ -126,4 +136,124 @@ struct TreeParams {
 
 };
 
-std::vector<VertexPN> BuildTreeVertices(const TreeParams& p);
+class LSystem;
+class LGrammar;
+
+// What a build produced and where its time went (optional out-param of the builders).
+// `stats` has the phases "derive", "interpret", "mesh" and every counter (symbol counts,
+// branch starts, skipped branches, ...); the fields below are the common ones, typed.
+// The times come from the phases, so they are 0 when built with LSYS_STATS=0.
+struct TreeBuildInfo {
+    std::size_t sentenceLength = 0;  // symbols after rewriting
+    bool sentenceCached = false;     // rewriting skipped: the sentence came from a TreeSentenceCache
+    std::size_t forwardSymbols = 0;  // 'F' in the sentence
+    std::size_t segments = 0;        // branch segments emitted (drawn ones only)
+    std::size_t spheres = 0;         // joint spheres emitted
+    std::size_t vertices = 0;
+    double rewriteMs = 0.0;          // "derive": grammar setup + LSystem::generate
+    double interpretMs = 0.0;        // "interpret": turtle walk + mesh
+    double meshMs = 0.0;             // "mesh": part of interpretMs spent writing segment / sphere vertices
+    // Per-stage heap use (all zero without LSYS_ALLOC_STATS). Turtle is "interpret" minus
+    // "mesh" for counts and bytes; its peak is that of the whole interpret phase.
+    AllocCounters rewriteAllocs, turtleAllocs, meshAllocs;
+    Stats stats;
+};
+
+// Fills in the tuned parameters of p.preset (iterations, shape, bark tiling). Leaves the seed alone.
+void ApplyTreePreset(TreeParams& p);
+
+// Bark texture set of a preset, relative to assets/textures (the renderer and the exporters share it)
+struct BarkTextureFiles {
+    const char* albedo;
+    const char* normal;     // OpenGL convention (+Y up)
+    const char* roughness;  // grayscale
+};
+BarkTextureFiles PresetBarkTextures(TreePreset preset);
+
+// Bump when the builder's output changes for the same params (invalidates saved .treemesh files)
+constexpr std::uint32_t kTreeGenVersion = 1;
+
+// Everything that shapes the mesh, kTreeGenVersion included. Equal hash -> same vertices.
+std::uint64_t HashTreeParams(const TreeParams& p);
+
+// Axiom + rules of p.preset (the same grammar the builders rewrite)
+void SetupTreeGrammar(LSystem& lsys, const TreeParams& p);
+
+// The preset's grammar in shared, read-only form: what every build rewrites with.
+// Built once on first use; safe to use from any number of threads at once.
+const LGrammar& PresetGrammar(TreePreset preset);
+
+// ---------------------------
+// Derived sentences, shared between builds
+// The rewrite depends on (preset, seed, iterations) only: the grammars take no other
+// parameter. A long-running caller (tree-server) keeps one cache so builds that only
+// change shape parameters, or repeat a tree, skip "derive". Thread-safe; least recently
+// used sentences are dropped once the total passes maxBytes.
+// ---------------------------
+class TreeSentenceCache {
+public:
+    explicit TreeSentenceCache(std::size_t maxBytes = std::size_t(256) << 20);
+
+    std::shared_ptr<const std::string> find(const TreeParams& p);
+    void insert(const TreeParams& p, std::shared_ptr<const std::string> sentence);
+
+    std::size_t hits() const;
+    std::size_t misses() const;
+    std::size_t bytes() const;
+
+private:
+    struct Entry {
+        std::uint64_t key;
+        std::shared_ptr<const std::string> sentence;
+    };
+
+    mutable std::mutex m_mutex;
+    std::list<Entry> m_lru; // front = most recently used
+    std::size_t m_bytes = 0;
+    std::size_t m_maxBytes;
+    std::size_t m_hits = 0;
+    std::size_t m_misses = 0;
+};
+
+std::vector<VertexPN> BuildTreeVertices(const TreeParams& p, TreeBuildInfo* info = nullptr,
+    TreeSentenceCache* sentences = nullptr);
+
+// Scratch one thread reuses from build to build: the rewrite ping-pongs between the two
+// strings and the mesh lands in `vertices`. Capacity is kept, so a worker building many
+// trees stops allocating once it has built its biggest one.
+struct TreeBuildArena {
+    std::string sentence;
+    std::string rewrite;
+    std::vector<VertexPN> vertices;
+};
+
+// Same mesh as BuildTreeVertices, into arena.vertices (cleared first). Returns the vertex count.
+std::size_t BuildTreeVerticesInto(const TreeParams& p, TreeBuildArena& arena, TreeBuildInfo* info = nullptr);
+
+// ---------------------------
+// Streaming build
+// The turtle hands out vertices in fixed-size chunks while it is still walking
+// the sentence, so the caller can upload them (or write them out) without ever
+// holding the whole mesh in one CPU-side vector.
+// ---------------------------
+
+// Default chunk size in vertices (64k * 48 bytes = 3 MB per flush)
+constexpr std::size_t kTreeChunkVerts = 64 * 1024;
+
+// Called with exactly `chunkVerts` vertices per call, except the last call
+// which carries the remainder (may be smaller, never empty).
+using TreeChunkFn = std::function<void(const VertexPN* verts, std::size_t count)>;
+
+// Thrown out of a build when its cancel flag is raised
+struct TreeBuildCancelled : std::runtime_error {
+    TreeBuildCancelled() : std::runtime_error("tree build cancelled") {}
+};
+
+// Same mesh as BuildTreeVertices, delivered through `onChunk`. Returns the total vertex count.
+// `cancel` is polled during rewriting and interpretation; once it is true the build
+// throws TreeBuildCancelled (chunks already delivered are left to the caller).
+std::size_t BuildTreeVerticesStreamed(const TreeParams& p, std::size_t chunkVerts, const TreeChunkFn& onChunk,
+    const std::atomic<bool>* cancel = nullptr, TreeBuildInfo* info = nullptr, TreeSentenceCache* sentences = nullptr);
+
+// Cheap stand-in drawn while the real tree is still building: one tapered trunk segment
+std::vector<VertexPN> BuildPlaceholderVertices(const TreeParams& p);
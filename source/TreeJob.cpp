@@ -0,0 +1,77 @@
+//TreeJob.cpp
+#include "TreeJob.h"
+
+#include <chrono>
+
+TreeBuildJob::TreeBuildJob(const TreeParams& p, std::size_t chunkVerts, std::size_t maxQueuedChunks)
+    : m_params(p),
+      m_chunkVerts(chunkVerts),
+      m_maxQueued(maxQueuedChunks > 0 ? maxQueuedChunks : 1)
+{
+    // Start last: the worker touches every member above
+    m_future = std::async(std::launch::async, [this]() { return run(); });
+}
+
+TreeBuildJob::~TreeBuildJob()
+{
+    cancel();
+    if (m_future.valid()) m_future.wait();
+}
+
+void TreeBuildJob::cancel()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cancel.store(true, std::memory_order_relaxed);
+    }
+    m_spaceCv.notify_all();
+}
+
+std::size_t TreeBuildJob::run()
+{
+    TraceSetThreadName("tree build");
+    return BuildTreeVerticesStreamed(m_params, m_chunkVerts,
+        [this](const VertexPN* v, std::size_t n) {
+            std::vector<VertexPN> chunk(v, v + n);
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            // Back-pressure: don't run ahead of the uploader by more than a few chunks
+            m_spaceCv.wait(lock, [this]() {
+                return m_queue.size() < m_maxQueued || m_cancel.load(std::memory_order_relaxed);
+            });
+            if (m_cancel.load(std::memory_order_relaxed)) throw TreeBuildCancelled();
+
+            m_queue.push_back(std::move(chunk));
+        },
+        &m_cancel, &m_info);
+}
+
+std::size_t TreeBuildJob::takeChunks(std::vector<std::vector<VertexPN>>& out, std::size_t maxChunks)
+{
+    std::size_t taken = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while (taken < maxChunks && !m_queue.empty()) {
+            out.push_back(std::move(m_queue.front()));
+            m_queue.pop_front();
+            ++taken;
+        }
+    }
+    if (taken > 0) m_spaceCv.notify_one();
+    return taken;
+}
+
+bool TreeBuildJob::done() const
+{
+    if (!m_future.valid()) return true; // already collected with get()
+    if (m_future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_queue.empty();
+}
+
+std::size_t TreeBuildJob::get()
+{
+    return m_future.get();
+}
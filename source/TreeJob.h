@@ -0,0 +1,62 @@
+//TreeJob.h
+#pragma once
+#include "TreeGen.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <vector>
+
+// Background tree build.
+// The worker runs BuildTreeVerticesStreamed and queues finished chunks; the GL thread
+// polls takeChunks() once per frame and uploads whatever is there, so it never waits
+// on generation. At most `maxQueuedChunks` are buffered (the worker blocks past that),
+// which keeps the CPU side to a few chunks instead of a full copy of the mesh.
+class TreeBuildJob {
+public:
+    explicit TreeBuildJob(const TreeParams& p,
+        std::size_t chunkVerts = kTreeChunkVerts,
+        std::size_t maxQueuedChunks = 8);
+
+    // Cancels and joins
+    ~TreeBuildJob();
+
+    TreeBuildJob(const TreeBuildJob&) = delete;
+    TreeBuildJob& operator=(const TreeBuildJob&) = delete;
+
+    // Cancellation token: the worker throws TreeBuildCancelled at its next check
+    void cancel();
+
+    // Non-blocking: moves up to `maxChunks` ready chunks into `out`. Returns how many.
+    std::size_t takeChunks(std::vector<std::vector<VertexPN>>& out, std::size_t maxChunks);
+
+    // Worker has returned (or thrown) and every chunk has been taken
+    bool done() const;
+
+    // Total vertex count; rethrows whatever the worker threw. Only call once done() is true.
+    std::size_t get();
+
+    // Phase times and counters of the finished build; valid once get() has returned
+    const TreeBuildInfo& info() const { return m_info; }
+
+    const TreeParams& params() const { return m_params; }
+
+private:
+    std::size_t run();
+
+    TreeParams  m_params;
+    std::size_t m_chunkVerts;
+    std::size_t m_maxQueued;
+    TreeBuildInfo m_info;
+
+    std::atomic<bool> m_cancel{ false };
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_spaceCv;
+    std::deque<std::vector<VertexPN>> m_queue;
+
+    std::future<std::size_t> m_future;
+};
@@ -0,0 +1,229 @@
+//TreeMesh.cpp
+#include "TreeMesh.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+static const char kTreeMeshMagic[8] = { 'L', 'T', 'R', 'E', 'M', 'E', 'S', 'H' };
+
+static std::uint64_t Align16(std::uint64_t n)
+{
+    return (n + 15) & ~std::uint64_t(15);
+}
+
+// ---------------------------
+// Load
+// ---------------------------
+bool OpenTreeMesh(const fs::path& path, std::uint64_t expectedHash, TreeMeshView& out)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+
+    auto map = std::make_unique<MappedFile>();
+    if (!map->open(path)) return false;
+    if (map->size() < sizeof(TreeMeshHeader)) return false;
+
+    // The mapping is page aligned, so the header (and the 16-aligned sections) can be used in place
+    const TreeMeshHeader* hdr = reinterpret_cast<const TreeMeshHeader*>(map->data());
+
+    if (std::memcmp(hdr->magic, kTreeMeshMagic, sizeof(kTreeMeshMagic)) != 0) return false;
+    if (hdr->version != kTreeMeshVersion) return false;
+    if (hdr->vertexFormat != (std::uint32_t)TreeMeshVertexFormat::PN48) return false;
+    if (hdr->vertexStride != sizeof(VertexPN)) return false;
+    if (expectedHash != 0 && hdr->paramsHash != expectedHash) return false;
+    if (hdr->fileBytes != map->size()) return false; // truncated or appended to
+
+    // Sections must sit inside the file. Written as offset <= size && count <= room / stride,
+    // so no sum or product of file values can wrap around and slip past the check.
+    const std::uint64_t size = map->size();
+    auto sectionFits = [size](std::uint64_t offset, std::uint64_t count, std::uint64_t stride) {
+        return offset <= size && count <= (size - offset) / stride;
+    };
+    if (hdr->vertexCount == 0) return false;
+    if (hdr->vertexOffset % 16 != 0 || hdr->vertexOffset < sizeof(TreeMeshHeader)) return false;
+    if (!sectionFits(hdr->vertexOffset, hdr->vertexCount, sizeof(VertexPN))) return false;
+
+    const bool indexed = (hdr->flags & kTreeMeshIndexed) != 0;
+    if (indexed != (hdr->indexCount != 0)) return false;
+
+    // The only pass over the payload: an index past the end would have the GPU read outside the buffer
+    const std::uint32_t* indices = nullptr;
+    if (indexed) {
+        if (hdr->indexOffset % 16 != 0 || hdr->indexOffset < sizeof(TreeMeshHeader)) return false;
+        if (!sectionFits(hdr->indexOffset, hdr->indexCount, sizeof(std::uint32_t))) return false;
+        indices = reinterpret_cast<const std::uint32_t*>(map->data() + hdr->indexOffset);
+        for (std::uint64_t i = 0; i < hdr->indexCount; ++i) {
+            if (indices[i] >= hdr->vertexCount) return false;
+        }
+    }
+
+    out.header = hdr;
+    out.vertices = reinterpret_cast<const VertexPN*>(map->data() + hdr->vertexOffset);
+    out.vertexCount = (std::size_t)hdr->vertexCount;
+    out.indices = indices;
+    out.indexCount = (std::size_t)hdr->indexCount;
+    out.mapping = std::move(map);
+    out.loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return true;
+}
+
+// ---------------------------
+// Save
+// ---------------------------
+// Header + section layout shared by the file writer and the in-memory encoder
+static TreeMeshHeader MakeTreeMeshHeader(std::uint64_t paramsHash,
+    const VertexPN* vertices, std::size_t vertexCount,
+    const std::uint32_t* indices, std::size_t indexCount)
+{
+    TreeMeshHeader hdr{};
+    std::memcpy(hdr.magic, kTreeMeshMagic, sizeof(kTreeMeshMagic));
+    hdr.version = kTreeMeshVersion;
+    hdr.vertexFormat = (std::uint32_t)TreeMeshVertexFormat::PN48;
+    hdr.vertexStride = sizeof(VertexPN);
+    hdr.flags = (indices && indexCount) ? kTreeMeshIndexed : 0u;
+    hdr.paramsHash = paramsHash;
+
+    glm::vec3 lo(std::numeric_limits<float>::max()), hi(-std::numeric_limits<float>::max());
+    for (std::size_t i = 0; i < vertexCount; ++i) {
+        lo = glm::min(lo, vertices[i].pos);
+        hi = glm::max(hi, vertices[i].pos);
+    }
+    if (vertexCount == 0) lo = hi = glm::vec3(0.0f);
+    for (int k = 0; k < 3; ++k) {
+        hdr.boundsMin[k] = lo[k];
+        hdr.boundsMax[k] = hi[k];
+    }
+
+    hdr.vertexCount = vertexCount;
+    hdr.indexCount = (hdr.flags & kTreeMeshIndexed) ? indexCount : 0;
+    hdr.vertexOffset = Align16(sizeof(TreeMeshHeader));
+    hdr.indexOffset = Align16(hdr.vertexOffset + hdr.vertexCount * sizeof(VertexPN));
+    hdr.skeletonOffset = Align16(hdr.indexOffset + hdr.indexCount * sizeof(std::uint32_t));
+    hdr.fileBytes = hdr.skeletonOffset;
+    return hdr;
+}
+
+bool WriteTreeMesh(const fs::path& path, std::uint64_t paramsHash,
+    const VertexPN* vertices, std::size_t vertexCount,
+    const std::uint32_t* indices, std::size_t indexCount)
+{
+    const TreeMeshHeader hdr = MakeTreeMeshHeader(paramsHash, vertices, vertexCount, indices, indexCount);
+
+    fs::path tmpPath = path;
+    tmpPath += ".tmp";
+
+    std::error_code ec;
+    {
+        std::ofstream f(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!f) {
+            std::cerr << "Warning: can't write tree mesh " << path << "\n";
+            return false;
+        }
+
+        // Everything in file order, zero padding between sections
+        static const char kPad[16] = {};
+        auto pad = [&](std::uint64_t at, std::uint64_t to) { f.write(kPad, (std::streamsize)(to - at)); };
+
+        f.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+        pad(sizeof(hdr), hdr.vertexOffset);
+        f.write(reinterpret_cast<const char*>(vertices), (std::streamsize)(hdr.vertexCount * sizeof(VertexPN)));
+        pad(hdr.vertexOffset + hdr.vertexCount * sizeof(VertexPN), hdr.indexOffset);
+        if (hdr.indexCount) {
+            f.write(reinterpret_cast<const char*>(indices), (std::streamsize)(hdr.indexCount * sizeof(std::uint32_t)));
+            pad(hdr.indexOffset + hdr.indexCount * sizeof(std::uint32_t), hdr.skeletonOffset);
+        }
+
+        if (!f) {
+            std::cerr << "Warning: failed writing tree mesh " << path << "\n";
+            f.close();
+            fs::remove(tmpPath, ec);
+            return false;
+        }
+    }
+
+    fs::remove(path, ec); // rename() won't replace an existing file on Windows
+    fs::rename(tmpPath, path, ec);
+    if (ec) {
+        std::cerr << "Warning: failed to move tree mesh into place: " << path << "\n";
+        fs::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
+
+void EncodeTreeMesh(std::uint64_t paramsHash,
+    const VertexPN* vertices, std::size_t vertexCount,
+    const std::uint32_t* indices, std::size_t indexCount,
+    std::vector<unsigned char>& out)
+{
+    const TreeMeshHeader hdr = MakeTreeMeshHeader(paramsHash, vertices, vertexCount, indices, indexCount);
+
+    // Zero-filled, so the padding between sections is already there
+    out.assign((std::size_t)hdr.fileBytes, 0);
+    std::memcpy(out.data(), &hdr, sizeof(hdr));
+    if (hdr.vertexCount)
+        std::memcpy(out.data() + hdr.vertexOffset, vertices, (std::size_t)hdr.vertexCount * sizeof(VertexPN));
+    if (hdr.indexCount)
+        std::memcpy(out.data() + hdr.indexOffset, indices, (std::size_t)hdr.indexCount * sizeof(std::uint32_t));
+}
+
+// ---------------------------
+// Weld
+// ---------------------------
+static std::uint64_t HashVertex(const VertexPN& v)
+{
+    std::uint32_t w[12];
+    std::memcpy(w, &v, sizeof(w));
+    std::uint64_t h = 0x9E3779B97F4A7C15ull;
+    for (std::uint32_t x : w) h = (h ^ x) * 0xFF51AFD7ED558CCDull;
+    return h ^ (h >> 32);
+}
+
+void WeldTreeVertices(const VertexPN* vertices, std::size_t count,
+    std::vector<VertexPN>& outVertices, std::vector<std::uint32_t>& outIndices)
+{
+    outVertices.clear();
+    outIndices.clear();
+    if (count == 0) return;
+
+    // Too big for 32-bit ids: keep the triangle list (empty indices)
+    constexpr std::uint32_t kEmpty = std::numeric_limits<std::uint32_t>::max();
+    if (count >= kEmpty) {
+        outVertices.assign(vertices, vertices + count);
+        return;
+    }
+
+    // Open addressing over output vertex ids, at most half full
+    std::size_t slots = 16;
+    while (slots < count * 2) slots *= 2;
+    std::vector<std::uint32_t> table(slots, kEmpty);
+    const std::size_t mask = slots - 1;
+
+    outVertices.reserve(count / 2);
+    outIndices.resize(count);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const VertexPN& v = vertices[i];
+        std::size_t s = (std::size_t)HashVertex(v) & mask;
+        for (;;) {
+            const std::uint32_t id = table[s];
+            if (id == kEmpty) {
+                table[s] = (std::uint32_t)outVertices.size();
+                outIndices[i] = table[s];
+                outVertices.push_back(v);
+                break;
+            }
+            if (std::memcmp(&outVertices[id], &v, sizeof(VertexPN)) == 0) {
+                outIndices[i] = id;
+                break;
+            }
+            s = (s + 1) & mask;
+        }
+    }
+}
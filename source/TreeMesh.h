@@ -0,0 +1,89 @@
+//TreeMesh.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "MappedFile.h"
+#include "TreeGen.h"
+
+// ---------------------------
+// Saved tree mesh (.treemesh)
+// A finished tree, laid out the way the GPU wants it, so loading is: map the file,
+// check the header, hand the mapped ranges to glBufferData. Nothing is parsed or copied.
+//
+// Layout (native endian, every section 16-byte aligned):
+//   TreeMeshHeader (128 bytes)
+//   vertices   vertexCount * vertexStride, VertexPN for format PN48
+//   indices    indexCount * uint32 (absent when indexCount == 0: plain triangle list)
+//   skeleton   reserved: skeletonCount is always 0 in version 1
+//
+// The file is written front to back in one pass (temp name + rename, like .texcache).
+// paramsHash is HashTreeParams() of the params it was built from; loaders that know the
+// params they want compare it to decide whether the file is still that tree.
+// ---------------------------
+constexpr std::uint32_t kTreeMeshVersion = 1;
+
+enum class TreeMeshVertexFormat : std::uint32_t {
+    PN48 = 0, // VertexPN: pos3, normal3, uv2, tangent4 (floats)
+};
+
+enum TreeMeshFlags : std::uint32_t {
+    kTreeMeshIndexed = 1u << 0,
+    kTreeMeshSkeleton = 1u << 1,
+};
+
+struct TreeMeshHeader {
+    char          magic[8];       // "LTREMESH"
+    std::uint32_t version;
+    std::uint32_t vertexFormat;   // TreeMeshVertexFormat
+    std::uint32_t vertexStride;
+    std::uint32_t flags;          // TreeMeshFlags
+    std::uint64_t paramsHash;
+    float         boundsMin[3];
+    float         boundsMax[3];
+    std::uint64_t vertexCount;
+    std::uint64_t indexCount;
+    std::uint64_t skeletonCount;
+    std::uint64_t vertexOffset;   // from the start of the file
+    std::uint64_t indexOffset;
+    std::uint64_t skeletonOffset;
+    std::uint64_t fileBytes;
+    std::uint8_t  reserved[16];
+};
+static_assert(sizeof(TreeMeshHeader) == 128, "treemesh header must stay 128 bytes");
+static_assert(sizeof(VertexPN) == 48, "PN48 is the on-disk vertex layout");
+
+// A validated, mapped .treemesh. Pointers stay valid while `mapping` lives.
+struct TreeMeshView {
+    std::unique_ptr<MappedFile> mapping;
+    const TreeMeshHeader* header = nullptr;
+    const VertexPN* vertices = nullptr;
+    std::size_t vertexCount = 0;
+    const std::uint32_t* indices = nullptr; // null: draw as a triangle list
+    std::size_t indexCount = 0;
+    double loadMs = 0.0;                    // map + validate
+};
+
+// Maps `path` and checks magic, version, vertex format, section bounds, index range and
+// (if expectedHash != 0) the params hash. False if any of it doesn't match.
+bool OpenTreeMesh(const std::filesystem::path& path, std::uint64_t expectedHash, TreeMeshView& out);
+
+// `indices` may be null (triangle list). False (with a warning) if the file can't be written.
+bool WriteTreeMesh(const std::filesystem::path& path, std::uint64_t paramsHash,
+    const VertexPN* vertices, std::size_t vertexCount,
+    const std::uint32_t* indices = nullptr, std::size_t indexCount = 0);
+
+// The exact bytes WriteTreeMesh would put in the file (for sending a tree over a pipe or socket)
+void EncodeTreeMesh(std::uint64_t paramsHash,
+    const VertexPN* vertices, std::size_t vertexCount,
+    const std::uint32_t* indices, std::size_t indexCount,
+    std::vector<unsigned char>& out);
+
+// Merges bit-identical vertices of a triangle list into an indexed mesh. Leaves `outIndices`
+// empty (the list unchanged) if it has more vertices than 32-bit indices can address
+// (segment rings and sphere caps share most of theirs: the file ends up about a third the size).
+void WeldTreeVertices(const VertexPN* vertices, std::size_t count,
+    std::vector<VertexPN>& outVertices, std::vector<std::uint32_t>& outIndices);
@@ -0,0 +1,96 @@
+//Uniforms.cpp
+#include "Uniforms.h"
+
+#include <algorithm>
+#include <iostream>
+
+const char* const kSceneBlocksGLSL = R"GLSL(
+        layout(std140) uniform Frame {
+            mat4  uViewProj;
+            mat4  uModel;
+            mat3  uEnvRot;          // the rotation the sky is drawn with
+            vec3  uCamPos;
+            vec3  uLightDir;
+            vec3  uAmbient;
+        };
+
+        layout(std140) uniform Material {
+            vec3  uBaseColor;
+            float uNormalStrength;  // 0..2
+            float uSpecPower;       // e.g. 32
+            float uSpecStrength;    // 0..1
+            bool  uFlipNormalY;     // set true only if bumps look inverted
+            float uMacroFreq;       // e.g. 0.12
+            float uMacroStrength;   // e.g. 0.20
+            float uUVWarp;          // e.g. 0.02
+            float uBarkTwist;       // e.g. 0.08
+            bool  uUseAltTiling;    // ground: ON, tree: OFF
+            float uAltTilingMix;    // 0..1
+            bool  uUseGroundMask;   // ground: ON, tree: OFF
+            float uGroundRadius;    // world units
+            float uGroundFade;      // world units
+            float uGroundCutoff;    // 0 = disabled, >0 = discard alpha below cutoff (for depth prepass)
+            bool  uGpuGround;       // aPos is on the unit grid (BuildGroundGrid)
+            float uGroundStep;      // world spacing of the current LOD (difference step)
+            float uGroundRelief;    // scales mound + noise + displacement
+        };
+)GLSL";
+
+void BindSceneBlocks(GLuint prog)
+{
+    const GLuint frame = glGetUniformBlockIndex(prog, "Frame");
+    const GLuint material = glGetUniformBlockIndex(prog, "Material");
+
+    if (frame == GL_INVALID_INDEX || material == GL_INVALID_INDEX) {
+        std::cerr << "Warning: program is missing the Frame / Material uniform blocks.\n";
+        return;
+    }
+    glUniformBlockBinding(prog, frame, kFrameBlockBinding);
+    glUniformBlockBinding(prog, material, kMaterialBlockBinding);
+}
+
+// ---------------------------
+// UniformSlots
+// ---------------------------
+UniformSlots::UniformSlots(GLuint binding, std::size_t blockBytes, int slots)
+    : m_binding(binding), m_blockBytes(blockBytes)
+{
+    GLint align = 256; // the largest value drivers report; used if the query fails
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+    align = std::max(align, 16);
+
+    m_stride = (blockBytes + (std::size_t)align - 1) / (std::size_t)align * (std::size_t)align;
+    slots = std::max(1, slots);
+
+    m_cpu.assign(m_stride * (std::size_t)slots, 0);
+    m_dirty.assign((std::size_t)slots, 1);
+
+    glGenBuffers(1, &m_ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    glBufferData(GL_UNIFORM_BUFFER, (GLsizeiptr)m_cpu.size(), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+UniformSlots::~UniformSlots()
+{
+    if (m_ubo) glDeleteBuffers(1, &m_ubo);
+}
+
+UniformSlots::Range UniformSlots::range(int slot)
+{
+    const GLintptr offset = (GLintptr)((std::size_t)slot * m_stride);
+
+    if (m_dirty[slot]) {
+        glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, (GLsizeiptr)m_blockBytes, cpu(slot));
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        m_dirty[slot] = 0;
+    }
+    return { m_ubo, offset, (GLsizeiptr)m_blockBytes };
+}
+
+void UniformSlots::bindSlot(int slot)
+{
+    const Range r = range(slot);
+    glBindBufferRange(GL_UNIFORM_BUFFER, m_binding, r.buffer, r.offset, r.size);
+}
@@ -0,0 +1,115 @@
+//Uniforms.h
+#pragma once
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// ---------------------------
+// Uniform blocks for the material program
+// Per-frame state (camera, model, light) and per-material parameters live in std140
+// uniform buffers instead of loose uniforms, so a draw binds a prebuilt buffer range
+// rather than looking up names and issuing a dozen glUniform* calls.
+// kSceneBlocksGLSL is pasted into both stages; the structs below mirror it byte for byte.
+// ---------------------------
+constexpr GLuint kFrameBlockBinding = 0;
+constexpr GLuint kMaterialBlockBinding = 1;
+
+extern const char* const kSceneBlocksGLSL;
+
+struct FrameBlock {
+    glm::mat4 viewProj;
+    glm::mat4 model;
+    glm::vec4 envRot[3];   // mat3: std140 pads every column to a vec4
+    glm::vec3 camPos;   float pad0 = 0.0f;
+    glm::vec3 lightDir; float pad1 = 0.0f;
+    glm::vec3 ambient;  float pad2 = 0.0f;
+};
+static_assert(offsetof(FrameBlock, envRot) == 128 && offsetof(FrameBlock, camPos) == 176 &&
+    sizeof(FrameBlock) == 224, "FrameBlock must match the std140 layout of Frame");
+
+// bools are 4-byte ints in std140
+struct MaterialBlock {
+    glm::vec3     baseColor{ 1.0f };
+    float         normalStrength = 1.0f;
+    float         specPower = 32.0f;
+    float         specStrength = 0.35f;
+    std::int32_t  flipNormalY = 0;
+    float         macroFreq = 0.12f;
+    float         macroStrength = 0.20f;
+    float         uvWarp = 0.02f;
+    float         barkTwist = 0.0f;
+    std::int32_t  useAltTiling = 0;
+    float         altTilingMix = 0.0f;
+    std::int32_t  useGroundMask = 0;
+    float         groundRadius = 50.0f;
+    float         groundFade = 18.0f;
+    float         groundCutoff = 0.0f;  // > 0: discard alpha below it (depth prepass)
+    std::int32_t  gpuGround = 0;
+    float         groundStep = 1.0f;
+    float         groundRelief = 1.0f;
+};
+static_assert(offsetof(MaterialBlock, groundCutoff) == 64 && sizeof(MaterialBlock) == 80,
+    "MaterialBlock must match the std140 layout of Material");
+
+// Points the program's Frame / Material blocks at their binding points (once, after linking)
+void BindSceneBlocks(GLuint prog);
+
+// ---------------------------
+// Uniform buffer with a fixed number of block slots
+// Every slot sits at an offset aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT. edit() marks a
+// slot dirty; range() uploads it (glBufferSubData) only if it changed and returns where it
+// lives, bind() also binds that range.
+// ---------------------------
+class UniformSlots {
+public:
+    UniformSlots(GLuint binding, std::size_t blockBytes, int slots);
+    ~UniformSlots();
+
+    UniformSlots(const UniformSlots&) = delete;
+    UniformSlots& operator=(const UniformSlots&) = delete;
+
+    struct Range {
+        GLuint     buffer;
+        GLintptr   offset;
+        GLsizeiptr size;
+    };
+
+    // For binding through RenderState (which skips rebinding the same range)
+    Range range(int slot);
+    GLuint binding() const { return m_binding; }
+
+protected:
+    void* cpu(int slot) { return m_cpu.data() + (std::size_t)slot * m_stride; }
+    const void* cpu(int slot) const { return m_cpu.data() + (std::size_t)slot * m_stride; }
+
+    void markDirty(int slot) { m_dirty[slot] = 1; }
+    void bindSlot(int slot);
+
+private:
+    GLuint m_ubo = 0;
+    GLuint m_binding = 0;
+    std::size_t m_blockBytes = 0;
+    std::size_t m_stride = 0;
+    std::vector<unsigned char> m_cpu;
+    std::vector<char> m_dirty;
+};
+
+template <class Block>
+class UniformBuffer : public UniformSlots {
+public:
+    UniformBuffer(GLuint binding, int slots)
+        : UniformSlots(binding, sizeof(Block), slots)
+    {
+        for (int i = 0; i < slots; ++i) new (cpu(i)) Block();
+    }
+
+    Block& edit(int slot) { markDirty(slot); return *static_cast<Block*>(cpu(slot)); }
+    const Block& get(int slot) const { return *static_cast<const Block*>(cpu(slot)); }
+
+    void bind(int slot) { bindSlot(slot); }
+};
@@ -0,0 +1,11 @@
+//VertexLayout.h
+#pragma once
+#include <glad/glad.h>
+
+#include "TreeGen.h" // VertexPN
+
+// ---------------------------
+// VAO layout of VertexPN (tree, hill, terrain chunks, forest blocks)
+// Locations 0..3: pos, normal, uv, tangent. Expects the VAO and GL_ARRAY_BUFFER bound.
+// ---------------------------
+void SetupVertexPNAttribs();
@@ -2,8 +2,18 @@
 #include <iostream>
 #include <vector>
 #include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
 #include<string>
 #include <filesystem>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <fstream>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -11,24 +21,42 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-
 #include "TreeGen.h"
+#include "TreeJob.h"
+#include "ThreadPool.h"
+#include "Textures.h"
+#include "EnvMap.h"
+#include "Hill.h"
+#include "Terrain.h"
+#include "Uniforms.h"
+#include "RenderState.h"
+#include "FrameTimer.h"
+#include "Stats.h"
+#include "TreeMesh.h"
+#include "Forest.h"
+#include "VertexLayout.h"
 
 namespace fs = std::filesystem;
 
 static int gWidth = 800;
 static int gHeight = 600;
 
+// Runtime parameter edits from the keyboard (consumed by the render loop)
+static bool gReseedRequested = false;
+static int  gIterationDelta = 0;
+static int  gGroundReliefSteps = 0; // GPU ground: '[' / ']'
+static int  gGroundLodSteps = 0;    // GPU ground: 'G'
+
 static void ProcessInput(GLFWwindow* window) {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 }
 
-static GLuint CompileShader(GLenum type, const char* src) {
+// Source parts are concatenated in order (e.g. version line, shared blocks, body)
+static GLuint CompileShader(GLenum type, std::initializer_list<const char*> parts) {
+    std::vector<const char*> src(parts);
     GLuint s = glCreateShader(type);
-    glShaderSource(s, 1, &src, nullptr);
+    glShaderSource(s, (GLsizei)src.size(), src.data(), nullptr);
     glCompileShader(s);
 
     GLint ok = 0;
@@ -74,217 +102,196 @@ static fs::path FindProjectRoot()
     return fs::current_path(); // fallback
 }
 
-static GLuint Make1x1TextureRGBA(unsigned char r, unsigned char g, unsigned char b, unsigned char a)
+// Forest instance attributes: model columns at 4..7, tint at 8, one step per instance
+// (expects VAO + the instance buffer bound). GL 3.3 has no base instance, so each variant
+// gets its own VAO whose pointers start at its instance range.
+static void SetupForestInstanceAttribs(std::size_t firstInstance)
 {
-    GLuint tex = 0;
-    glGenTextures(1, &tex);
-    glBindTexture(GL_TEXTURE_2D, tex);
-
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-    unsigned char px[4] = { r, g, b, a };
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, px);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    const std::size_t base = firstInstance * sizeof(ForestInstance);
+    for (int c = 0; c < 4; ++c) {
+        glEnableVertexAttribArray(4 + c);
+        glVertexAttribPointer(4 + c, 4, GL_FLOAT, GL_FALSE, sizeof(ForestInstance),
+            (void*)(base + offsetof(ForestInstance, model) + c * sizeof(glm::vec4)));
+        glVertexAttribDivisor(4 + c, 1);
+    }
+    glEnableVertexAttribArray(8);
+    glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, sizeof(ForestInstance), (void*)(base + offsetof(ForestInstance, tint)));
+    glVertexAttribDivisor(8, 1);
+}
 
-    glBindTexture(GL_TEXTURE_2D, 0);
-    return tex;
+// Disabled arrays read the current generic attribute (context state, not VAO state):
+// every non-instanced draw gets an identity instance model and a white tint for free
+static void SetDefaultInstanceAttribs()
+{
+    glVertexAttrib4f(4, 1.0f, 0.0f, 0.0f, 0.0f);
+    glVertexAttrib4f(5, 0.0f, 1.0f, 0.0f, 0.0f);
+    glVertexAttrib4f(6, 0.0f, 0.0f, 1.0f, 0.0f);
+    glVertexAttrib4f(7, 0.0f, 0.0f, 0.0f, 1.0f);
+    glVertexAttrib4f(8, 1.0f, 1.0f, 1.0f, 1.0f);
 }
 
 // ---------------------------
-// Hill mesh generation (Part 2)
-// Uses VertexPN = { pos, normal, uv, tangent } like tree.
-// Generates a gentle mound + subtle noise, centered at (0, baseY, 0).
+// Streamed tree VBO
+// Chunks from BuildTreeVerticesStreamed go straight into buffer storage through
+// mapped ranges. Capacity doubles on demand with a GPU-side copy, so the CPU
+// never holds more than one chunk. [0, vertCount) is always drawable.
 // ---------------------------
-static float HillHeightFn(float x, float z, float baseY)
+struct TreeStreamBuffer {
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    GLuint ebo = 0;            // only for a tree loaded from a .treemesh
+    GLsizeiptr capacityVerts = 0;
+    GLsizei    vertCount = 0;
+    GLsizei    indexCount = 0; // > 0: draw indexed (loaded tree)
+};
+
+static void BeginTreeStream(TreeStreamBuffer& sb, GLsizeiptr initialVerts)
 {
-    // Broad mound (Gaussian-ish)
-    float r2 = x * x + z * z;
-    float moundHeight = 0.55f;
-    float sigma = 10.0f; // bigger = wider hill
-    float mound = moundHeight * std::exp(-r2 / (2.0f * sigma * sigma));
-
-    // Subtle noise
-    float noiseAmp = 0.25f;
-    float n =
-        0.60f * std::sin(0.35f * x + 0.15f * z) +
-        0.40f * std::cos(0.25f * z - 0.10f * x) +
-        0.25f * std::sin(0.18f * (x + z));
-
-    return baseY + mound + noiseAmp * n;
-}
+    if (!sb.vao) glGenVertexArrays(1, &sb.vao);
+    if (!sb.vbo) glGenBuffers(1, &sb.vbo);
 
-static std::vector<VertexPN> BuildHillVertices(
-    float baseY,
-    float halfSize,
-    int   gridN,
-    float uvWorldU,
-    float uvWorldV)
-{
-    gridN = std::max(4, gridN);
-    uvWorldU = std::max(1e-6f, uvWorldU);
-    uvWorldV = std::max(1e-6f, uvWorldV);
-
-    const int N = gridN;
-    const float size = 2.0f * halfSize;
-    const float dx = size / float(N - 1);
-    const float dz = size / float(N - 1);
-
-    auto idx = [&](int i, int j) { return j * N + i; };
-
-    std::vector<float> H(N * N, 0.0f);
-    for (int j = 0; j < N; ++j) {
-        float z = -halfSize + j * dz;
-        for (int i = 0; i < N; ++i) {
-            float x = -halfSize + i * dx;
-            H[idx(i, j)] = HillHeightFn(x, z, baseY);
-        }
-    }
+    sb.capacityVerts = std::max<GLsizeiptr>(initialVerts, 1);
+    sb.vertCount = 0;
+    sb.indexCount = 0;
 
-    std::vector<glm::vec3> P(N * N);
-    std::vector<glm::vec3> Nrm(N * N);
-    std::vector<glm::vec4> Tan(N * N);
-    std::vector<glm::vec2> UV(N * N);
+    glBindVertexArray(sb.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, sb.vbo);
 
-    for (int j = 0; j < N; ++j) {
-        float z = -halfSize + j * dz;
-        for (int i = 0; i < N; ++i) {
-            float x = -halfSize + i * dx;
+    // Orphan: the driver gives us fresh storage, draws still in flight keep the old one
+    glBufferData(GL_ARRAY_BUFFER, sb.capacityVerts * (GLsizeiptr)sizeof(VertexPN), nullptr, GL_DYNAMIC_DRAW);
+    SetupVertexPNAttribs();
 
-            float hC = H[idx(i, j)];
-            int iL = std::max(0, i - 1), iR = std::min(N - 1, i + 1);
-            int jD = std::max(0, j - 1), jU = std::min(N - 1, j + 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-            float hL = H[idx(iL, j)];
-            float hR = H[idx(iR, j)];
-            float hD = H[idx(i, jD)];
-            float hU = H[idx(i, jU)];
+static void GrowTreeStream(TreeStreamBuffer& sb, GLsizeiptr minVerts)
+{
+    GLsizeiptr newCap = std::max<GLsizeiptr>(sb.capacityVerts, 1);
+    while (newCap < minVerts) newCap *= 2;
+
+    GLuint newVbo = 0;
+    glGenBuffers(1, &newVbo);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newVbo);
+    glBufferData(GL_COPY_WRITE_BUFFER, newCap * (GLsizeiptr)sizeof(VertexPN), nullptr, GL_DYNAMIC_DRAW);
+
+    // Keep what we already streamed (GPU -> GPU, no CPU copy)
+    if (sb.vertCount > 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, sb.vbo);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+            (GLsizeiptr)sb.vertCount * (GLsizeiptr)sizeof(VertexPN));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
 
-            float dhdx = (hR - hL) / (float(iR - iL) * dx);
-            float dhdz = (hU - hD) / (float(jU - jD) * dz);
+    glDeleteBuffers(1, &sb.vbo);
+    sb.vbo = newVbo;
+    sb.capacityVerts = newCap;
 
-            glm::vec3 pos(x, hC, z);
+    // Re-point the VAO at the new storage
+    glBindVertexArray(sb.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, sb.vbo);
+    SetupVertexPNAttribs();
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-            // Normal from heightfield gradients
-            glm::vec3 n = glm::normalize(glm::vec3(-dhdx, 1.0f, -dhdz));
+static void AppendTreeStream(TreeStreamBuffer& sb, const VertexPN* v, std::size_t n)
+{
+    if (n == 0) return;
 
-            // Tangent along +X direction (dP/dx)
-            glm::vec3 t = glm::normalize(glm::vec3(1.0f, dhdx, 0.0f));
+    if ((GLsizeiptr)sb.vertCount + (GLsizeiptr)n > sb.capacityVerts)
+        GrowTreeStream(sb, (GLsizeiptr)sb.vertCount + (GLsizeiptr)n);
 
-            // Bitangent along +Z direction (dP/dz)
-            glm::vec3 b = glm::normalize(glm::vec3(0.0f, dhdz, 1.0f));
+    const GLintptr   offset = (GLintptr)sb.vertCount * (GLintptr)sizeof(VertexPN);
+    const GLsizeiptr bytes = (GLsizeiptr)n * (GLsizeiptr)sizeof(VertexPN);
 
-            // Orthonormalize tangent to normal and compute sign
-            t = glm::normalize(t - n * glm::dot(n, t));
-            float sign = (glm::dot(glm::cross(n, t), b) < 0.0f) ? -1.0f : 1.0f;
+    glBindBuffer(GL_ARRAY_BUFFER, sb.vbo);
 
-            // UV in world meters
-            glm::vec2 uv(x / uvWorldU, z / uvWorldV);
+    // Unsynchronized is fine: no draw has referenced this range yet
+    void* dst = glMapBufferRange(GL_ARRAY_BUFFER, offset, bytes,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
 
-            P[idx(i, j)]   = pos;
-            Nrm[idx(i, j)] = n;
-            Tan[idx(i, j)] = glm::vec4(t, sign);
-            UV[idx(i, j)]  = uv;
-        }
+    bool ok = false;
+    if (dst) {
+        std::memcpy(dst, v, (std::size_t)bytes);
+        ok = (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE);
     }
-
-    // Build triangle list (no EBO) so it matches tree draw style
-    std::vector<VertexPN> out;
-    out.reserve((N - 1) * (N - 1) * 6);
-
-    auto push = [&](int i, int j) {
-        int k = idx(i, j);
-        out.push_back({ P[k], Nrm[k], UV[k], Tan[k] });
-    };
-
-    for (int j = 0; j < N - 1; ++j) {
-        for (int i = 0; i < N - 1; ++i) {
-            // Quad corners: (i,j)=00, (i+1,j)=10, (i+1,j+1)=11, (i,j+1)=01
-            push(i,     j);
-            push(i + 1, j);
-            push(i + 1, j + 1);
-
-            push(i,     j);
-            push(i + 1, j + 1);
-            push(i,     j + 1);
-        }
+    if (!ok) {
+        // Mapping failed or the store got corrupted on unmap: plain upload instead
+        glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, v);
     }
 
-    return out;
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    sb.vertCount += (GLsizei)n;
 }
 
-static GLuint LoadTexture2D(const fs::path& path, bool srgb)
+// Saved tree (TreeMesh.h): the mapped file ranges go to the driver as they are,
+// no parsing and no staging copy on our side
+static void UploadTreeMesh(TreeStreamBuffer& sb, const TreeMeshView& m)
 {
-    int w = 0, h = 0, comp = 0;
-    stbi_set_flip_vertically_on_load(true);
-
-    // Force 4 channels so OpenGL upload format is always consistent
-    unsigned char* data = stbi_load(path.string().c_str(), &w, &h, &comp, 4);
-    if (!data) {
-        std::cerr << "Failed to load texture: " << path << "\n";
-        return 0;
+    if (!sb.vao) glGenVertexArrays(1, &sb.vao);
+    if (!sb.vbo) glGenBuffers(1, &sb.vbo);
+
+    glBindVertexArray(sb.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, sb.vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(m.vertexCount * sizeof(VertexPN)), m.vertices, GL_STATIC_DRAW);
+    SetupVertexPNAttribs();
+
+    if (m.indices) {
+        if (!sb.ebo) glGenBuffers(1, &sb.ebo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sb.ebo); // recorded in the VAO
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)(m.indexCount * sizeof(std::uint32_t)), m.indices, GL_STATIC_DRAW);
     }
 
-    GLenum srcFormat = GL_RGBA;
-    GLenum internalFormat = srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
-
-    GLuint tex = 0;
-    glGenTextures(1, &tex);
-    glBindTexture(GL_TEXTURE_2D, tex);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    // Safe even if widths are odd
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    sb.capacityVerts = (GLsizeiptr)m.vertexCount;
+    sb.vertCount = (GLsizei)m.vertexCount;
+    sb.indexCount = (GLsizei)m.indexCount;
+}
 
-    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, w, h, 0, srcFormat, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+// ---------------------------
+// Startup task graph: GL work that waits on CPU work.
+// ready() is polled on the context thread every frame; run() fires once it is true.
+// ---------------------------
+struct PendingGLStep {
+    std::function<bool()> ready;
+    std::function<void()> run;
+};
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+// Runs (and drops) every step whose inputs are ready. Never blocks.
+static void PumpPendingGLSteps(std::vector<PendingGLStep>& steps)
+{
+    for (std::size_t i = 0; i < steps.size();) {
+        if (steps[i].ready()) {
+            PendingGLStep step = std::move(steps[i]);
+            steps.erase(steps.begin() + (std::ptrdiff_t)i);
+            step.run();
+        }
+        else {
+            ++i;
+        }
+    }
+}
 
-    glBindTexture(GL_TEXTURE_2D, 0);
-    stbi_image_free(data);
-    return tex;
+// Nearest-rank percentile (p in 0..100) of an ascending list
+static double Percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty()) return 0.0;
+    std::size_t rank = (std::size_t)std::ceil(p / 100.0 * double(sorted.size()));
+    rank = std::clamp<std::size_t>(rank, 1, sorted.size());
+    return sorted[rank - 1];
 }
 
 //here in the declaration added the params : (int argc, char** argv)
 int main(int argc, char** argv) {
-    if (!glfwInit()) {
-        std::cerr << "glfwInit failed\n";
-        return -1;
-    }
-
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    GLFWwindow* window = glfwCreateWindow(gWidth, gHeight, "L-System Tree", nullptr, nullptr);
-    if (!window) {
-        std::cerr << "Failed to create GLFW window\n";
-        glfwTerminate();
-        return -1;
-    }
-
-    glfwMakeContextCurrent(window);
-
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Failed to initialize GLAD\n";
-        glfwTerminate();
-        return -1;
-    }
-
-    glfwSetFramebufferSizeCallback(window, [](GLFWwindow*, int w, int h) {
-        gWidth = (w > 0) ? w : 1;
-        gHeight = (h > 0) ? h : 1;
-        glViewport(0, 0, gWidth, gHeight);
-        });
-
-    glViewport(0, 0, gWidth, gHeight);
-    glEnable(GL_DEPTH_TEST);
+    // Time-to-first-frame is measured from here
+    const auto startupBegin = std::chrono::steady_clock::now();
+    auto msSinceStartup = [&]() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupBegin).count();
+    };
 
     // ---- Build tree geometry (CPU) ----
     TreeParams params;
@@ -302,6 +309,20 @@ int main(int argc, char** argv) {
     bool envMode = false; // enable HDRI environment background (Part 1)
 
     bool DeciduousMode = true;
+
+    bool useTexCache = true; // .texcache files next to the PNGs (see TextureCache.h)
+    bool gpuGround = false;  // displace a flat grid in the vertex shader instead of BuildHillMesh
+    bool terrainMode = false; // quadtree-chunked ground instead of the single hill mesh
+    float terrainHalfSize = 400.0f;
+    bool renderStats = false; // print draw / state-change counters once a second
+    bool frameTiming = false; // per-pass CPU + GPU times once a second (FrameTimer.h)
+    std::string frameTimingCsv; // ... to this CSV file instead of stdout
+    std::string tracePath;        // Chrome trace of the run (Stats.h), written at exit
+    std::string treeMeshPath;     // .treemesh to load the tree from, or to save it to after building
+    int benchFrames = 0;          // > 0: hidden window, offscreen target, fixed camera path, then exit
+    double benchBudgetMs = 0.0;   // > 0: exit code 1 if the p95 frame time is above it
+    int forestCount = 0;          // > 0: a stand of that many trees around the main one (Forest.h)
+    int forestVariants = 8;       // unique meshes the stand is drawn from (instanced)
     
     // Iteration variables
     bool OWitFlag = false;
@@ -324,6 +345,19 @@ int main(int argc, char** argv) {
                 << "  -e, --environment   Enable HDRI background environment\n"
                 << "  -i <number>         Set iteration count (default: 1)\n"
                 << "  -seed <number>      Set generation seed (default: 2025)\n"
+                << "  --no-tex-cache      Always decode PNGs, don't read/write .texcache files\n"
+                << "  --gpu-ground        Displace the ground on the GPU (with -e; [ ] relief, G resolution)\n"
+                << "  --terrain           Chunked LOD terrain instead of the single hill (with -e)\n"
+                << "  --terrain-size <n>  Terrain half extent in world units (default: 400, implies --terrain)\n"
+                << "  --render-stats      Print draw calls and GL state changes per frame (1 s averages)\n"
+                << "  --frame-timing      Print CPU and GPU time per render pass (1 s averages)\n"
+                << "  --frame-timing-csv <file>  Write the pass times to a CSV file instead\n"
+                << "  --trace <file>      Write a Chrome trace (chrome://tracing) of the run at exit\n"
+                << "  --tree-mesh <file>  Load the tree from a .treemesh made with the same options, or save it there\n"
+                << "  --forest <n>        Surround the tree with n more of the same preset (instanced)\n"
+                << "  --forest-variants <k>  Unique trees the forest is drawn from (default: 8)\n"
+                << "  --bench-frames <n>  Headless benchmark: render n frames offscreen, print percentiles, exit\n"
+                << "  --bench-budget <ms> With --bench-frames: exit code 1 if p95 frame time is above <ms>\n"
                 << "  -h, --help          Show this help message\n\n"
                 << "Examples:\n"
                 << "  ./program.exe -c -i 12 -s\n"
@@ -336,6 +370,83 @@ int main(int argc, char** argv) {
         else if (arg == "-e" || arg == "--environment") {
             envMode = true;
         }
+        else if (arg == "--no-tex-cache") {
+            useTexCache = false;
+        }
+        else if (arg == "--gpu-ground") {
+            gpuGround = true;
+        }
+        else if (arg == "--render-stats") {
+            renderStats = true;
+        }
+        else if (arg == "--frame-timing") {
+            frameTiming = true;
+        }
+        else if (arg == "--frame-timing-csv") {
+            if (i + 1 < argc) {
+                frameTimingCsv = argv[++i];
+                frameTiming = true;
+            }
+            else {
+                std::cout << "Error: --frame-timing-csv requires a file name.\n";
+            }
+        }
+        else if (arg == "--trace") {
+            if (i + 1 < argc) tracePath = argv[++i];
+            else std::cout << "Error: --trace requires a file name.\n";
+        }
+        else if (arg == "--tree-mesh") {
+            if (i + 1 < argc) treeMeshPath = argv[++i];
+            else std::cout << "Error: --tree-mesh requires a file name.\n";
+        }
+        else if (arg == "--forest" || arg == "--forest-variants") {
+            if (i + 1 < argc) {
+                i++;
+                try {
+                    if (arg == "--forest") forestCount = std::max(0, std::stoi(argv[i]));
+                    else forestVariants = std::max(1, std::stoi(argv[i]));
+                }
+                catch (...) {
+                    std::cout << "Error: Invalid number provided for " << arg << "\n";
+                }
+            }
+            else {
+                std::cout << "Error: " << arg << " requires a number.\n";
+            }
+        }
+        else if (arg == "--bench-frames" || arg == "--bench-budget") {
+            if (i + 1 < argc) {
+                i++;
+                try {
+                    if (arg == "--bench-frames") benchFrames = std::max(1, std::stoi(argv[i]));
+                    else benchBudgetMs = std::max(0.0, std::stod(argv[i]));
+                }
+                catch (...) {
+                    std::cout << "Error: Invalid number provided for " << arg << "\n";
+                }
+            }
+            else {
+                std::cout << "Error: " << arg << " requires a number.\n";
+            }
+        }
+        else if (arg == "--terrain") {
+            terrainMode = true;
+        }
+        else if (arg == "--terrain-size") {
+            if (i + 1 < argc) {
+                i++;
+                try {
+                    terrainHalfSize = std::max(25.0f, std::stof(argv[i]));
+                    terrainMode = true;
+                }
+                catch (...) {
+                    std::cout << "Error: Invalid terrain size '" << argv[i] << "'. Using default.\n";
+                }
+            }
+            else {
+                std::cout << "Error: --terrain-size requires a number.\n";
+            }
+        }
         else if (arg == "deciduous" || arg == "--deciduous" || arg == "-d") {
             params.preset = TreePreset::Deciduous;
             DeciduousMode = true;
@@ -392,470 +503,427 @@ int main(int argc, char** argv) {
         }
     }
 
+    if (terrainMode && gpuGround) {
+        std::cout << "Warning: --gpu-ground is ignored with --terrain.\n";
+        gpuGround = false;
+    }
+
     if (solidMode) {
         std::cout << "SOLID MODE enabled (light gray bark, no texture detail)\n";
     }
     if (envMode) {
         std::cout << "ENVIRONMENT MODE enabled (HDRI background)\n";
     }
+    if (!tracePath.empty()) {
+        TraceEnable(true);
+        TraceSetThreadName("main");
+    }
+    if (benchBudgetMs > 0.0 && benchFrames == 0) {
+        std::cout << "Warning: --bench-budget is ignored without --bench-frames.\n";
+    }
+
+    // Benchmark: fixed 720p offscreen target, the window only carries the context.
+    // Needs a display server (run under xvfb-run on machines without one).
+    if (benchFrames > 0) {
+        gWidth = 1280;
+        gHeight = 720;
+    }
+
+    if (!glfwInit()) {
+        std::cerr << "glfwInit failed\n";
+        return -1;
+    }
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (benchFrames > 0) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE); // hints only stick after glfwInit
+
+    GLFWwindow* window = glfwCreateWindow(gWidth, gHeight, "L-System Tree", nullptr, nullptr);
+    if (!window) {
+        std::cerr << "Failed to create GLFW window\n";
+        glfwTerminate();
+        return -1;
+    }
+
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cerr << "Failed to initialize GLAD\n";
+        glfwTerminate();
+        return -1;
+    }
+
+    glfwSetFramebufferSizeCallback(window, [](GLFWwindow*, int w, int h) {
+        gWidth = (w > 0) ? w : 1;
+        gHeight = (h > 0) ? h : 1;
+        glViewport(0, 0, gWidth, gHeight);
+        });
+
+    // N = new seed, Up/Down = iterations +/- 1 (each restarts the background build)
+    // [ / ] = GPU ground relief down/up, G = next GPU ground resolution (no rebuild)
+    glfwSetKeyCallback(window, [](GLFWwindow*, int key, int, int action, int) {
+        if (action != GLFW_PRESS) return;
+        if (key == GLFW_KEY_N)    gReseedRequested = true;
+        if (key == GLFW_KEY_UP)   gIterationDelta += 1;
+        if (key == GLFW_KEY_DOWN) gIterationDelta -= 1;
+        if (key == GLFW_KEY_LEFT_BRACKET)  gGroundReliefSteps -= 1;
+        if (key == GLFW_KEY_RIGHT_BRACKET) gGroundReliefSteps += 1;
+        if (key == GLFW_KEY_G)    gGroundLodSteps += 1;
+        });
+
+    glViewport(0, 0, gWidth, gHeight);
+    glEnable(GL_DEPTH_TEST);
+
+    // Benchmark render target: the frames never reach a window, so nothing waits for vsync
+    GLuint benchFBO = 0, benchColorRB = 0, benchDepthRB = 0;
+    if (benchFrames > 0) {
+        glfwSwapInterval(0);
+
+        glGenRenderbuffers(1, &benchColorRB);
+        glBindRenderbuffer(GL_RENDERBUFFER, benchColorRB);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, gWidth, gHeight);
+        glGenRenderbuffers(1, &benchDepthRB);
+        glBindRenderbuffer(GL_RENDERBUFFER, benchDepthRB);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, gWidth, gHeight);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glGenFramebuffers(1, &benchFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, benchFBO);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, benchColorRB);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, benchDepthRB);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Benchmark framebuffer is incomplete\n";
+            glfwTerminate();
+            return -1;
+        }
+        // Stays bound for the whole run
+    }
 
     fs::path root = FindProjectRoot();
     fs::path texRoot = root / "assets" / "textures";
 
+    // Look of both presets (TreeGen.cpp); the CLI overrides below go on top
+    ApplyTreePreset(params);
+
+    if (OWitFlag) {
+        params.iterations = iterationCount;
+    }
+
+    if (seedFlag) {
+        params.seed = seedValue;
+    }
+
     // ---------------------------
-    // Ground textures (Part 2)
+    // Startup task graph
+    //   CPU (pool): texture load (cache map or PNG decode + mips) for ground / HDRI / bark, BuildHillMesh
+    //   CPU (job):  the tree itself (TreeBuildJob, started right below)
+    //   GL (here):  shaders compile now; each upload runs once its input is ready
+    // The render loop starts as soon as the shaders are linked.
     // ---------------------------
+    ThreadPool pool;
+    TextureBatchLoader textures(pool);
+    textures.setUseCache(useTexCache);
+
+    // Until their real inputs arrive, bark uses neutral 1x1 stand-ins (the same ones
+    // solid mode keeps), the hill is skipped and the sky falls back to the clear color.
+    GLuint texAlbedo = Make1x1TextureRGBA(255, 255, 255, 255);
+    GLuint texNormal = Make1x1TextureRGBA(128, 128, 255, 255);
+    GLuint texRough = Make1x1TextureRGBA(200, 200, 200, 255);
+
     GLuint texGroundAlbedo = 0;
     GLuint texGroundNormal = 0;
     GLuint texGroundRough = 0;
+    GLuint texGroundDisp = 0; // GPU ground only; mid-gray stand-in = no displacement
+    GLuint texSkyCube = 0;
 
+    // Ground textures (Part 2)
     if (envMode) {
         fs::path groundRoot = root / "assets" / "ground";
         fs::path gset = (params.preset == TreePreset::Conifer)
             ? (groundRoot / "conifer")
             : (groundRoot / "deciduous");
 
-        fs::path gDiff, gNor, gRough;
+        fs::path gDiff, gNor, gRough, gDisp;
 
         if (params.preset == TreePreset::Conifer) {
             gDiff = gset / "forrest_ground_01_diff_1k.png";
             gNor = gset / "forrest_ground_01_nor_gl_1k.png";
             gRough = gset / "forrest_ground_01_rough_1k.png";
+            gDisp = gset / "forrest_ground_01_disp_1k.png";
         }
         else {
             gDiff = gset / "red_laterite_soil_stones_diff_1k.png";
             gNor = gset / "red_laterite_soil_stones_nor_gl_1k.png";
             gRough = gset / "red_laterite_soil_stones_rough_1k.png";
+            gDisp = gset / "red_laterite_soil_stones_disp_1k.png";
         }
 
         std::cout << "Loading ground textures from:\n"
             << gDiff << "\n" << gNor << "\n" << gRough << "\n";
 
-        texGroundAlbedo = LoadTexture2D(gDiff, true);
-        texGroundNormal = LoadTexture2D(gNor, false);
-        texGroundRough = LoadTexture2D(gRough, false);
-
-        if (!texGroundAlbedo || !texGroundNormal || !texGroundRough) {
-            std::cerr << "Warning: ground textures failed to load. Disabling env ground.\n";
-            texGroundAlbedo = texGroundNormal = texGroundRough = 0;
+        // The hill is only drawn once all three are in; one failure disables it
+        auto groundDone = [](GLuint& dst) {
+            return [&dst](GLuint tex) {
+                dst = tex;
+                if (!tex) std::cerr << "Warning: ground textures failed to load. Disabling env ground.\n";
+            };
+        };
+        textures.add(gDiff, true, groundDone(texGroundAlbedo));
+        textures.add(gNor, false, groundDone(texGroundNormal));
+        textures.add(gRough, false, groundDone(texGroundRough));
+
+        // Displacement is optional: without it the GPU ground is just the hill function
+        if (gpuGround) {
+            texGroundDisp = Make1x1TextureRGBA(128, 128, 128, 255);
+            textures.add(gDisp, false, [&texGroundDisp](GLuint tex) {
+                if (!tex) { std::cerr << "Warning: ground displacement map failed to load.\n"; return; }
+                glDeleteTextures(1, &texGroundDisp);
+                texGroundDisp = tex;
+            });
         }
     }
 
-    // ---------------------------
     // Environment HDRI (Part 1)
-    // ---------------------------
-    fs::path hdriPath;
-    GLuint texHDRI = 0;
-
+    std::future<EnvCube> envCubeFuture;
     if (envMode) {
         fs::path hdriRoot = root / "assets" / "HDRIs";
-        if (params.preset == TreePreset::Conifer) {
-            hdriPath = hdriRoot / "conifer" / "autumn_park_2k.png";
-        }
-        else {
-            hdriPath = hdriRoot / "deciduous" / "belfast_sunset_2k.png";
-        }
+        fs::path hdriPath = (params.preset == TreePreset::Conifer)
+            ? (hdriRoot / "conifer" / "autumn_park_2k.png")
+            : (hdriRoot / "deciduous" / "belfast_sunset_2k.png");
 
         std::cout << "Loading HDRI from:\n" << hdriPath << "\n";
-        texHDRI = LoadTexture2D(hdriPath, true); // sRGB for PNG
-
-        if (texHDRI) {
-            // For lat-long env maps: wrap S, clamp T is usually best
-
-            glBindTexture(GL_TEXTURE_2D, texHDRI);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glBindTexture(GL_TEXTURE_2D, 0);
 
-        }
-        else {
-            std::cerr << "Warning: HDRI failed to load, environment will be disabled.\n";
-            envMode = false;
-        }
-    }
-
-    fs::path diffPath, norPath, roughPath;
-
-    if (params.preset == TreePreset::Conifer) {
-        fs::path p = texRoot / "pine_bark_1k.blend";
-        diffPath = p / "pine_bark_diff_1k.png";
-        norPath = p / "pine_bark_nor_gl_1k.png";
-        roughPath = p / "pine_bark_rough_1k.png";
-    }
-    else {
-        fs::path p = texRoot / "bark_brown_02_1k.blend";
-        diffPath = p / "bark_brown_02_diff_1k.png";
-        norPath = p / "bark_brown_02_nor_gl_1k.png";
-        roughPath = p / "bark_brown_02_rough_1k.png";
+        // Resampled into a cube on the pool (or mapped from the .cubecache), uploaded below
+        envCubeFuture = pool.submit([hdriPath, useTexCache]() {
+            return LoadEnvironmentCube(hdriPath, useTexCache);
+        });
     }
 
-    GLuint texAlbedo = 0, texNormal = 0, texRough = 0;
-
+    // Bark
     if (!solidMode) {
+        const BarkTextureFiles bark = PresetBarkTextures(params.preset);
+        const fs::path diffPath = texRoot / bark.albedo;
+        const fs::path norPath = texRoot / bark.normal;
+        const fs::path roughPath = texRoot / bark.roughness;
+
         std::cout << "Loading bark textures from:\n"
             << diffPath << "\n"
             << norPath << "\n"
             << roughPath << "\n";
 
-        std::cout << "Loading albedo...\n";
-        texAlbedo = LoadTexture2D(diffPath, true);
-
-        std::cout << "Loading normal...\n";
-        texNormal = LoadTexture2D(norPath, false);
-
-        std::cout << "Loading roughness...\n";
-        texRough = LoadTexture2D(roughPath, false);
-
-        std::cout << "All textures loaded.\n";
-    }
-    else {
-        // Solid-look “textures”:
-        // - Albedo: white (so uBaseColor controls the final color)
-        // - Normal: flat normal (no bumps)
-        // - Roughness: constant mid/high roughness (less shiny)
-        texAlbedo = Make1x1TextureRGBA(255, 255, 255, 255);
-        texNormal = Make1x1TextureRGBA(128, 128, 255, 255);
-        texRough = Make1x1TextureRGBA(200, 200, 200, 255);
-    }
-
-    params.iterations = 15;          // start lower to avoid twig explosion; bump to 15 if too sparse
-
-    params.radialSegments = 12;
-
-    //params.seed = 1166707377;
-    params.addSpheres = true;
-
-    params.branchAngleDeg = 22.0f;
-
-    params.usePhyllotaxisRoll = true;
-    params.phyllotaxisDeg = 137.5f;
-
-    params.branchPitchMaxDeg = 60.0f;   // was 45 (or 35 earlier)
-
-    params.baseRadius = 0.55f;
-    params.baseLength = 1.6f;
-
-    params.enableBranchSkipping = false;
-    params.branchSkipMaxProb = 0.25f; // keep it mild for now
-    params.branchSkipStartDepth = 3;
-    params.minRadiusForBranch = 0.040f;
-    params.depthFullEffect = 10;
-
-
-    params.enableTropism = true;
-    params.tropismDir = glm::vec3(0, 1, 0);
-    params.tropismStrength = 0.015f;
-    params.tropismThinBoost = 0.18f;
-
-    params.maxLenToRadius = 14.0f;   // fine
-
-    params.minBranchSpacing = 1;   // 2 will kills most branches!!!!!!
-    params.maxBranchesPerNode = 128;   // start generous
-
-    params.branchRadiusDecay = 0.75f;   // helps preserve twig thickness
-    params.branchLengthDecay = 0.85f;   // longer sub-branches than 0.55
-    params.twigLengthBoost = 0.15f;    // 0.30 shortens twigs a lot -> looks fuzzy and cramped
-
-    params.angleJitterDeg = 17.0f;    // less random-looking noise
-
-    params.lengthJitterFrac = 0.08f; // more consistent segment lengths
-    params.radiusJitterFrac = 0.06f; // less sparkly thickness noise
-
-    params.branchRollJitterDeg = 35.0f; // 90 makes distribution look chaotic; phyllotaxis already spreads 360
-    params.branchPitchMinDeg = 15.0f;
-    params.branchPitchMaxDeg = 50.0f;   // better 3D crown without relying on huge roll jitter
-
-    params.enableRadiusPruning = true;
-    params.pruneRadius = 0.0020f;       // prune more of the ultra-fine structural recursion (reduces clutter)
-
-    params.minRadius = 0.0016f;         // draw fewer micro-twigs
-    params.minLength = 0.010f;          // avoid tiny hair segments
-
-    params.enableCrookedness = true;
-
-    // stronger than 1, but not insane
-    params.crookStrength = 2.4f;
-
-    // bigger noise = more zig-zag
-    params.crookAccelDeg = 18.0f;
-
-    // smoothing: 0.85–0.95 is the useful range
-    params.crookDamping = 0.10f;
-
-    params.enableTrunkTaperCurve = false;
-
-    params.trunkTaperPower = 2.2f;
-
-    params.trunkTaperTopMult = 0.95f;
-
-    //new conifer params
-    if (params.preset == TreePreset::Conifer) {
-
-        params.addSpheres = true;
-
-        // Spruce: enough iterations for tufting, without blowing up too hard
-        params.iterations = 15;
-
-        // Trunk / taper: avoid “everything shrinks linearly with height”
-        params.baseRadius = 0.30f;
-        params.baseLength = 1.5f;   // slightly shorter = more whorl nodes
-        params.radiusDecayF = 0.955f;  // gentler continuous taper (big difference)
-        params.lengthDecayF = 0.955f;  // trunk segments don’t shrink away quickly
-
-        // Enable curved taper for trunk (keeps base sturdy, tapers more near the top)
-        params.enableTrunkTaperCurve = true;
-        params.trunkTaperPower = 1.35f;
-        params.trunkTaperTopMult = 0.75f; //0.92
-
-        //enable scaffold taper curve 
-        params.enableScaffoldTaperCurve = true;
-
-
-        // Branch scaling at '[' : THIS fixes “branches are too thin”
-        params.branchRadiusDecay = 0.38f;  // (was 0.20!) big improvement to scaffold thickness
-        params.branchLengthDecay = 0.60f;  // branches start shorter than trunk, but not tiny
-
-        // Angles: smaller angle + grammar controls whorl tilt (spruce look)
-        params.branchAngleDeg = 35.0f;
-        params.angleJitterDeg = 5.0f;
-
-        // Mild geometry noise (breaks symmetry without chaos)
-        params.lengthJitterFrac = 0.05f;
-        params.radiusJitterFrac = 0.02f;
-
-        // Distribute branches around trunk
-        params.usePhyllotaxisRoll = true;
-        params.phyllotaxisDeg = 137.5f;
-        params.branchRollJitterDeg = 10.0f;
-
-        // Allow a small random pitch kick to break perfect tier symmetry
-        params.branchPitchMinDeg = 3.0f;
-        params.branchPitchMaxDeg = 10.0f;
-
-        // Branch crowding controls
-        params.maxBranchesPerNode = 115;
-        params.minBranchSpacing = 1;
-
-        // Optional skipping (creates gaps, reduces “uniform cone” feeling)
-        params.enableBranchSkipping = false; // too inconsistent atm
-        params.branchSkipMaxProb = 0.15f;
-        params.branchSkipStartDepth = 3;
-        params.minRadiusForBranch = 0.010f;
-
-        // IMPORTANT: keep trunk from entering “twig scaling” too early
-        params.depthFullEffect = 40;
-
-        // Tropism: for spruce, use slight downward bend (droop)
-        params.enableTropism = true;
-        params.tropismDir = glm::vec3(0, 1, 0);
-        params.tropismStrength = 0.008f;
-        params.tropismThinBoost = 0.25f;
-
-        // Twigs: don’t over-shorten (old 0.6 made upper structure collapse)
-        params.twigLengthBoost = 0.20f;
-        params.maxLenToRadius = 14.0f;
-
-        // Pruning / visibility (keeps tips from turning into hair)
-        params.enableRadiusPruning = false;
-        params.pruneRadius = 0.0015f;
-
-        params.minRadius = 0.0012f;
-        params.minLength = 0.012f;
-
-        // Crookedness
-        params.enableCrookedness = false;
-        params.crookStrength = 0.5f;
-        params.crookAccelDeg = 20.2f;
-        params.crookDamping = 0.10f;
-
-        params.radialSegments = 8;
-
-        params.enableCrookedness = true;
+        // Swap the 1x1 stand-in for the real texture (keep the stand-in if the file failed)
+        auto replaceStandIn = [](GLuint& dst) {
+            return [&dst](GLuint tex) {
+                if (!tex) return;
+                glDeleteTextures(1, &dst);
+                dst = tex;
+            };
+        };
+        textures.add(diffPath, true, replaceStandIn(texAlbedo));
+        textures.add(norPath, false, replaceStandIn(texNormal));
+        textures.add(roughPath, false, replaceStandIn(texRough));
     }
 
-    if (params.preset == TreePreset::Conifer) {
-        params.barkRepeatWorldU = 1.10f;
-        params.barkRepeatWorldV = 2.00f;
+    // Hill mesh (Part 2)
+    // Put ground near the tree base 
+    const float hillBaseY = params.baseTranslation.y - 0.20f;
+
+    // Size/resolution (tweak later)
+    const float hillHalfSize = 100.0f;   // 
+    const int   hillGridN = 240;     // smoother mound
+
+    // UVBigger numbers = fewer repeats (less tiling)
+    const float hillUVWorld = (params.preset == TreePreset::Conifer) ? 12.0f : 14.0f;
+
+    std::future<HillMesh> hillMeshFuture;
+    std::future<GroundGrid> groundGridFuture;
+    std::unique_ptr<TerrainSystem> terrain;
+    if (envMode && terrainMode) {
+        // Chunks are built on demand by terrain->update() from the render loop
+        TerrainSettings ts;
+        ts.baseY = hillBaseY;
+        ts.halfSize = terrainHalfSize;
+        ts.uvWorld = hillUVWorld;
+        ts.drawRadius = 0.95f * terrainHalfSize; // the ground mask has faded out by then
+        terrain = std::make_unique<TerrainSystem>(pool, ts);
     }
-    else { // Deciduous
-        params.barkRepeatWorldU = 1.60f;
-        params.barkRepeatWorldV = 2.60f;
+    else if (envMode && gpuGround) {
+        // 512 quads per side, LODs 512/256/128/64 (256 is about the CPU mesh's 240)
+        groundGridFuture = pool.submit([]() { return BuildGroundGrid(9, 4); });
     }
-
-    if (OWitFlag) {
-        params.iterations = iterationCount;
+    else if (envMode) {
+        hillMeshFuture = pool.submit([=]() {
+            return BuildHillMesh(hillBaseY, hillHalfSize, hillGridN, hillUVWorld, hillUVWorld);
+        });
     }
 
-    if (seedFlag) {
-        params.seed = seedValue;
-    }
+    // --forest: a few variant meshes built in the background, drawn once per placement
+    // through the instance buffer. Variants have two iterations fewer than the main tree:
+    // eight full-detail deciduous trees alone would be gigabytes.
+    std::future<InstancedForest> forestFuture;
+    if (forestCount > 0) {
+        std::vector<TreePlacement> stand = ScatterForest(forestCount, params.preset, 8.0f,
+            8.0f + 6.0f * std::sqrt((float)forestCount), 4.0f, params.seed + 1u);
+        for (TreePlacement& t : stand) {
+            // On the hill when there is one, a little sunk so no root floats
+            t.position.y = envMode ? HillHeightFn(t.position.x, t.position.z, hillBaseY) - 0.15f : params.baseTranslation.y;
+        }
 
-    std::vector<VertexPN> verts;
-    try {
-        verts = BuildTreeVertices(params);
-    }
-    catch (const std::bad_alloc& e) {
-        std::cerr << "Out of memory while building tree: " << e.what() << "\n";
-        return -1;
-    }
-    catch (const std::exception& e) {
-        std::cerr << "Exception while building tree: " << e.what() << "\n";
-        return -1;
+        ForestSettings forestSettings;
+        forestSettings.iterations = std::max(1, params.iterations - 2);
+        const int variants = forestVariants;
+        forestFuture = pool.submit([stand, variants, forestSettings]() {
+            return BuildInstancedForest(stand, variants, forestSettings);
+        });
     }
-    std::cout << "Tree vertices: " << verts.size() << "\n";
-
-    // ---- Upload to GPU ----
-    GLuint vao = 0, vbo = 0;
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-
-    // ---- Hill GPU handles (Part 2) ----
-    GLuint hillVAO = 0, hillVBO = 0;
-    GLsizei hillVertCount = 0;
-
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER,
-        (GLsizeiptr)(verts.size() * sizeof(VertexPN)),
-        verts.data(),
-        GL_STATIC_DRAW);
-
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexPN), (void*)offsetof(VertexPN, pos));
-
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(VertexPN), (void*)offsetof(VertexPN, normal));
 
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(VertexPN), (void*)offsetof(VertexPN, uv));
-
-    glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(VertexPN), (void*)offsetof(VertexPN, tangent));
-
-    glBindVertexArray(0);
-
-    // ---------------------------
-// Hill mesh (Part 2) GPU upload
-// ---------------------------
-    if (envMode) {
-
-        // Put ground near the tree base 
-        float baseY = params.baseTranslation.y - 0.20f;
-
-        // Size/resolution (tweak later)
-        float halfSize = 100.0f;   // 
-        int   gridN = 240;     // smoother mound
-
-        // UVBigger numbers = fewer repeats (less tiling)
-        float uvWorldU = (params.preset == TreePreset::Conifer) ? 12.0f : 14.0f;
-        float uvWorldV = (params.preset == TreePreset::Conifer) ? 12.0f : 14.0f;
-
-        std::vector<VertexPN> hillVerts = BuildHillVertices(baseY, halfSize, gridN, uvWorldU, uvWorldV);
-        hillVertCount = (GLsizei)hillVerts.size();
-
-        glGenVertexArrays(1, &hillVAO);
-        glGenBuffers(1, &hillVBO);
-
-        glBindVertexArray(hillVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, hillVBO);
-        glBufferData(GL_ARRAY_BUFFER,
-            (GLsizeiptr)(hillVerts.size() * sizeof(VertexPN)),
-            hillVerts.data(),
-            GL_STATIC_DRAW);
-
-        // Same attribute layout as tree:
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexPN), (void*)offsetof(VertexPN, pos));
-
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(VertexPN), (void*)offsetof(VertexPN, normal));
+    // ---- Tree GPU buffer (filled by the background build) ----
+    TreeStreamBuffer tree;
+
+    // ---- Build tree geometry on a worker; chunks are uploaded by the render loop ----
+    std::unique_ptr<TreeBuildJob> job;
+    double jobStart = 0.0;
+
+    // --tree-mesh: weld + write of the last finished build (one at a time, on the pool)
+    std::future<bool> treeMeshSave;
+
+    auto startBuild = [&]() {
+        if (job) job->cancel();     // abort the in-flight build (its destructor joins)
+        job.reset();
+
+        // A saved mesh of exactly these params replaces the whole build
+        if (!treeMeshPath.empty()) {
+            TreeMeshView saved;
+            if (OpenTreeMesh(treeMeshPath, HashTreeParams(params), saved)) {
+                const auto t0 = std::chrono::steady_clock::now();
+                UploadTreeMesh(tree, saved);
+                std::cout << "Tree mesh: " << treeMeshPath << " (" << saved.vertexCount << " vertices, "
+                    << saved.indexCount << " indices), mapped in " << saved.loadMs << " ms, uploaded in "
+                    << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count()
+                    << " ms\n";
+                glfwSetWindowTitle(window, "L-System Tree");
+                return;
+            }
+        }
 
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(VertexPN), (void*)offsetof(VertexPN, uv));
+        BeginTreeStream(tree, std::max<GLsizeiptr>(tree.capacityVerts, (GLsizeiptr)kTreeChunkVerts * 8));
+        jobStart = glfwGetTime();
+        job = std::make_unique<TreeBuildJob>(params);
+        glfwSetWindowTitle(window, "L-System Tree (building...)");
+    };
 
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(VertexPN), (void*)offsetof(VertexPN, tangent));
-
-        glBindVertexArray(0);
-    }
+    startBuild();
 
     // ---- Shaders ----
+    // Both stages get "#version" + kSceneBlocksGLSL (Uniforms.h) in front
     const char* vsSrc = R"GLSL(
-        #version 330 core
         layout(location=0) in vec3 aPos;
         layout(location=1) in vec3 aNormal;
         layout(location=2) in vec2 aUV;
         layout(location=3) in vec4 aTangent; // xyz tangent, w sign
+
+        // Instanced forest (SetupForestInstanceAttribs); everything else draws with these
+        // arrays off and gets the constants of SetDefaultInstanceAttribs: identity, white
+        layout(location=4) in mat4 aInstanceModel; // 4..7
+        layout(location=8) in vec4 aInstanceTint;
     
-        uniform mat4 uModel;
-        uniform mat4 uViewProj;
+        // GPU ground: aPos is on the unit grid (BuildGroundGrid), everything else is derived here.
+        // Fixed for the run; the per-frame part (uGpuGround, step, relief) is in Material.
+        uniform float     uGroundHalfSize;
+        uniform float     uGroundBaseY;
+        uniform float     uGroundUVWorld; // metres per texture repeat
+        uniform sampler2D uDispTex;
+        uniform float     uDispScale;     // metres for a full 0..1 displacement range
     
         out vec2 vUV;
         out vec3 vWorldPos;
         out vec3 vT;
         out vec3 vB;
         out vec3 vN;
+        out vec3 vTint;
+
+        // HillHeightFn (Hill.cpp) + displacement map
+        float GroundHeight(vec2 p, float dispLod) {
+            float mound = 0.55 * exp(-dot(p, p) / (2.0 * 10.0 * 10.0));
+            float n =
+                0.60 * sin(0.35 * p.x + 0.15 * p.y) +
+                0.40 * cos(0.25 * p.y - 0.10 * p.x) +
+                0.25 * sin(0.18 * (p.x + p.y));
+            float disp = textureLod(uDispTex, p / uGroundUVWorld, dispLod).r - 0.5;
+            return uGroundBaseY + uGroundRelief * (mound + 0.25 * n + uDispScale * disp);
+        }
     
         void main() {
-            vec4 world = uModel * vec4(aPos, 1.0);
+            vec3 pos = aPos;
+            vec3 nrm = aNormal;
+            vec4 tng = aTangent;
+            vec2 uv = aUV;
+
+            if (uGpuGround) {
+                vec2 p = (aPos.xz * 2.0 - 1.0) * uGroundHalfSize;
+
+                // Pick the displacement mip whose texel matches the grid spacing (no aliasing
+                // at coarse LODs)
+                float texel = uGroundUVWorld / float(textureSize(uDispTex, 0).x);
+                float dispLod = max(0.0, log2(uGroundStep / texel));
+
+                float e = uGroundStep;
+                float hC = GroundHeight(p, dispLod);
+                float dhdx = (GroundHeight(p + vec2(e, 0.0), dispLod) - GroundHeight(p - vec2(e, 0.0), dispLod)) / (2.0 * e);
+                float dhdz = (GroundHeight(p + vec2(0.0, e), dispLod) - GroundHeight(p - vec2(0.0, e), dispLod)) / (2.0 * e);
+
+                // Same frame as MakeHillVertex
+                pos = vec3(p.x, hC, p.y);
+                nrm = normalize(vec3(-dhdx, 1.0, -dhdz));
+                vec3 t = normalize(vec3(1.0, dhdx, 0.0));
+                t = normalize(t - nrm * dot(nrm, t));
+                vec3 b = vec3(0.0, dhdz, 1.0);
+                tng = vec4(t, dot(cross(nrm, t), b) < 0.0 ? -1.0 : 1.0);
+                uv = p / uGroundUVWorld;
+            }
+
+            mat4 model = uModel * aInstanceModel;
+            vec4 world = model * vec4(pos, 1.0);
             vWorldPos = world.xyz;
     
-            mat3 nmat = mat3(transpose(inverse(uModel)));
+            mat3 nmat = mat3(transpose(inverse(model)));
     
-            vec3 N = normalize(nmat * aNormal);
-            vec3 T = normalize(nmat * aTangent.xyz);
+            vec3 N = normalize(nmat * nrm);
+            vec3 T = normalize(nmat * tng.xyz);
     
             // Orthonormalize T against N (stabilizes normal mapping)
             T = normalize(T - N * dot(N, T));
     
-            vec3 B = cross(N, T) * aTangent.w;
+            vec3 B = cross(N, T) * tng.w;
     
             vN = N;
             vT = T;
             vB = B;
-            vUV = aUV;
+            vUV = uv;
+            vTint = aInstanceTint.rgb;
     
             gl_Position = uViewProj * world;
         }
     )GLSL";
 
     const char* fsSrc = R"GLSL(
-        #version 330 core
         in vec2 vUV;
         in vec3 vWorldPos;
         in vec3 vT;
         in vec3 vB;
         in vec3 vN;
+        in vec3 vTint;
     
         uniform sampler2D uAlbedoTex;
         uniform sampler2D uNormalTex;
         uniform sampler2D uRoughTex;
-    
-        uniform vec3 uBaseColor;
-        uniform vec3 uLightDir;
-        uniform vec3 uAmbient;
-        uniform vec3 uCamPos;
-    
-        uniform float uNormalStrength;  // 0..2
-        uniform float uSpecPower;       // e.g. 32
-        uniform float uSpecStrength;    // 0..1
-        uniform bool  uFlipNormalY;     // set true only if bumps look inverted
-
-        uniform float uMacroFreq;       // e.g. 0.12
-        uniform float uMacroStrength;   // e.g. 0.20
-        uniform float uUVWarp;          // e.g. 0.02
-        uniform float uBarkTwist;       // e.g. 0.08 
-
-        uniform bool  uUseAltTiling;     // ground: ON, tree: OFF
-        uniform float uAltTilingMix;     // 0..1
-        uniform bool  uUseGroundMask;    // ground: ON, tree: OFF
-        uniform float uGroundRadius;     // world units
-        uniform float uGroundFade;       // world units
-        uniform float uGroundCutoff;     // 0 = disabled, >0 = discard alpha below cutoff (for depth prepass)   
+
+        // Image-based ambient from the HDRI (EnvMap.h): E[i] already has the cosine lobe
+        // and basis constants folded in. Rotated by uEnvRot (Frame).
+        uniform bool  uUseSH;
+        uniform vec3  uSH[9];
+        uniform float uSHScale;
         
         out vec4 FragColor;
 
@@ -888,6 +956,13 @@ int main(int argc, char** argv) {
             return mix(nxy0, nxy1, f.z);
         }
     
+        vec3 SHIrradiance(vec3 n) {
+            return uSH[0]
+                 + uSH[1] * n.y + uSH[2] * n.z + uSH[3] * n.x
+                 + uSH[4] * (n.x * n.y) + uSH[5] * (n.y * n.z) + uSH[6] * (3.0 * n.z * n.z - 1.0)
+                 + uSH[7] * (n.x * n.z) + uSH[8] * (n.x * n.x - n.y * n.y);
+        }
+
         void main() {
         
             vec2 uv = vUV;
@@ -918,7 +993,7 @@ int main(int argc, char** argv) {
             // Sample textures (blend two UV sets to break regular repeats)
             vec3 alb1 = texture(uAlbedoTex, uv).rgb;
             vec3 alb2 = texture(uAlbedoTex, uv2).rgb;
-            vec3 albedo = mix(alb1, alb2, blend) * uBaseColor;
+            vec3 albedo = mix(alb1, alb2, blend) * uBaseColor * vTint;
         
             float rough1 = texture(uRoughTex, uv).r;
             float rough2 = texture(uRoughTex, uv2).r;
@@ -949,7 +1024,10 @@ int main(int argc, char** argv) {
             float spec = pow(max(dot(N, H), 0.0), uSpecPower);
             spec *= uSpecStrength * (1.0 - rough);
         
-            vec3 col = albedo * (uAmbient + diff) + vec3(spec);
+            vec3 ambient = uAmbient;
+            if (uUseSH) ambient = max(SHIrradiance(transpose(uEnvRot) * N), vec3(0.0)) * uSHScale;
+
+            vec3 col = albedo * (ambient + diff) + vec3(spec);
         
             // --- Circular ground mask (hide square plane edges) ---
             float alpha = 1.0;
@@ -969,34 +1047,41 @@ int main(int argc, char** argv) {
     )GLSL";
 
 
-    GLuint vs = CompileShader(GL_VERTEX_SHADER, vsSrc);
-    GLuint fs = CompileShader(GL_FRAGMENT_SHADER, fsSrc);
+    GLuint vs = CompileShader(GL_VERTEX_SHADER, { "#version 330 core\n", kSceneBlocksGLSL, vsSrc });
+    GLuint fs = CompileShader(GL_FRAGMENT_SHADER, { "#version 330 core\n", kSceneBlocksGLSL, fsSrc });
     GLuint prog = LinkProgram(vs, fs);
     glDeleteShader(vs);
     glDeleteShader(fs);
 
-    GLint uModelLoc = glGetUniformLocation(prog, "uModel");
-    GLint uViewProjLoc = glGetUniformLocation(prog, "uViewProj");
-    GLint uColorLoc = glGetUniformLocation(prog, "uColor");
-    GLint uLightDirLoc = glGetUniformLocation(prog, "uLightDir");
-    GLint uAmbientLoc = glGetUniformLocation(prog, "uAmbient");
+    // Everything below is resolved once here; the render loop only binds block ranges
+    BindSceneBlocks(prog);
+    SetDefaultInstanceAttribs();
+
+    GLint uUseSHLoc = glGetUniformLocation(prog, "uUseSH");
+    GLint uSHLoc = glGetUniformLocation(prog, "uSH");
+    GLint uSHScaleLoc = glGetUniformLocation(prog, "uSHScale");
+
+    GLint uGroundHalfSizeLoc = glGetUniformLocation(prog, "uGroundHalfSize");
+    GLint uGroundBaseYLoc = glGetUniformLocation(prog, "uGroundBaseY");
+    GLint uGroundUVWorldLoc = glGetUniformLocation(prog, "uGroundUVWorld");
+    GLint uDispTexLoc = glGetUniformLocation(prog, "uDispTex");
+    GLint uDispScaleLoc = glGetUniformLocation(prog, "uDispScale");
 
     GLint uAlbedoTexLoc = glGetUniformLocation(prog, "uAlbedoTex");
     GLint uNormalTexLoc = glGetUniformLocation(prog, "uNormalTex");
     GLint uRoughTexLoc = glGetUniformLocation(prog, "uRoughTex");
 
-    GLint uBaseColorLoc = glGetUniformLocation(prog, "uBaseColor");
-    GLint uCamPosLoc = glGetUniformLocation(prog, "uCamPos");
-
-    GLint uNormalStrLoc = glGetUniformLocation(prog, "uNormalStrength");
-    GLint uSpecPowerLoc = glGetUniformLocation(prog, "uSpecPower");
-    GLint uSpecStrLoc = glGetUniformLocation(prog, "uSpecStrength");
-    GLint uFlipNormalYLoc = glGetUniformLocation(prog, "uFlipNormalY");
-
     glUseProgram(prog);
     glUniform1i(uAlbedoTexLoc, 0);
     glUniform1i(uNormalTexLoc, 1);
     glUniform1i(uRoughTexLoc, 2);
+    glUniform1i(uDispTexLoc, 4); // unit 3 is the sky cube
+
+    // Fixed for the run; relief and LOD are in the ground materials
+    glUniform1f(uGroundHalfSizeLoc, hillHalfSize);
+    glUniform1f(uGroundBaseYLoc, hillBaseY);
+    glUniform1f(uGroundUVWorldLoc, hillUVWorld);
+    glUniform1f(uDispScaleLoc, 0.10f);
 
     // ---------------------------
     // Sky background (HDRI) (Part 1)
@@ -1008,71 +1093,54 @@ int main(int argc, char** argv) {
     GLint uSkyInvProjLoc = -1;
     GLint uSkyInvViewRotLoc = -1;
     GLint uSkyWorldRotLoc = -1;
-    GLint uSkyResLoc = -1;
     GLint uSkyExposureLoc = -1;
     GLint uSkyGammaLoc = -1;
     GLint uSkyFlipVLoc = -1;
 
-    if (envMode && texHDRI) {
+    if (envMode) {
+        // The view ray is built per vertex: for a full-screen triangle it interpolates exactly,
+        // so the fragment shader is one cube lookup + tone map
         const char* skyVsSrc = R"GLSL(
         #version 330 core
+        uniform mat4  uInvProj;
+        uniform mat3  uInvViewRot;
+        uniform mat3  uWorldRot;
+        uniform bool  uFlipV;
+
+        out vec3 vDirWS;
+
         void main() {
             vec2 pos;
             if (gl_VertexID == 0) pos = vec2(-1.0, -1.0);
             else if (gl_VertexID == 1) pos = vec2( 3.0, -1.0);
             else pos = vec2(-1.0,  3.0);
             gl_Position = vec4(pos, 0.0, 1.0);
+
+            // Reconstruct view-space ray (w is constant across the far plane)
+            vec4 view = uInvProj * vec4(pos, 1.0, 1.0);
+            vec3 dirVS = view.xyz / view.w;
+
+            // To world direction (camera rotation only), then undo the tree/world rotation
+            vec3 dirWS = transpose(uWorldRot) * (uInvViewRot * dirVS);
+
+            if (uFlipV) dirWS.y = -dirWS.y;
+            vDirWS = dirWS;
         }
     )GLSL";
 
         const char* skyFsSrc = R"GLSL(
         #version 330 core
+        in vec3 vDirWS;
         out vec4 FragColor;
 
-        uniform sampler2D uHDRI;
-        uniform mat4  uInvProj;
-        uniform mat3  uInvViewRot;
-        uniform mat3  uWorldRot;
-        uniform vec2  uResolution;
+        uniform samplerCube uSkyCube;
 
         uniform float uExposure;
         uniform float uGamma;
-        uniform bool  uFlipV;
-
-        const float PI = 3.14159265359;
-
-        vec2 DirToEquirectUV(vec3 d) {
-            d = normalize(d);
-            float phi   = atan(d.z, d.x);                 // -PI..PI
-            float theta = asin(clamp(d.y, -1.0, 1.0));    // -PI/2..PI/2
-            vec2 uv;
-            uv.x = phi / (2.0 * PI) + 0.5;
-            uv.y = theta / PI + 0.5;
-            return uv;
-        }
 
         void main() {
-            vec2 uv  = gl_FragCoord.xy / uResolution;
-            vec2 ndc = uv * 2.0 - 1.0;
-
-            // Reconstruct view-space ray
-            vec4 clip = vec4(ndc, 1.0, 1.0);
-            vec4 view = uInvProj * clip;
-            vec3 dirVS = normalize(view.xyz / max(view.w, 1e-6));
-
-            // To world direction (camera rotation only)
-            vec3 dirWS = normalize(uInvViewRot * dirVS);
-
-            // Rotate environment with the tree/world
-            dirWS = normalize(transpose(uWorldRot) * dirWS); // inverse for pure rotation matrices
-
-            vec2 envUV = DirToEquirectUV(dirWS);
-            envUV.x = fract(envUV.x + 1e-4);              // wrap cleanly
-            envUV.y = clamp(envUV.y, 1e-4, 1.0 - 1e-4);   // avoid pole edge
-            
-            if (uFlipV) envUV.y = 1.0 - envUV.y;
-
-            vec3 col = texture(uHDRI, envUV).rgb;
+            // Cube lookups don't need a normalized direction
+            vec3 col = texture(uSkyCube, vDirWS).rgb;
 
             // Make LDR PNG feel less dull
             col *= uExposure;
@@ -1083,228 +1151,765 @@ int main(int argc, char** argv) {
         }
     )GLSL";
 
-        GLuint svs = CompileShader(GL_VERTEX_SHADER, skyVsSrc);
-        GLuint sfs = CompileShader(GL_FRAGMENT_SHADER, skyFsSrc);
+        GLuint svs = CompileShader(GL_VERTEX_SHADER, { skyVsSrc });
+        GLuint sfs = CompileShader(GL_FRAGMENT_SHADER, { skyFsSrc });
         skyProg = LinkProgram(svs, sfs);
         glDeleteShader(svs);
         glDeleteShader(sfs);
 
-        uSkyTexLoc = glGetUniformLocation(skyProg, "uHDRI");
+        uSkyTexLoc = glGetUniformLocation(skyProg, "uSkyCube");
         uSkyInvProjLoc = glGetUniformLocation(skyProg, "uInvProj");
         uSkyInvViewRotLoc = glGetUniformLocation(skyProg, "uInvViewRot");
         uSkyWorldRotLoc = glGetUniformLocation(skyProg, "uWorldRot");
-        uSkyResLoc = glGetUniformLocation(skyProg, "uResolution");
         uSkyExposureLoc = glGetUniformLocation(skyProg, "uExposure");
         uSkyGammaLoc = glGetUniformLocation(skyProg, "uGamma");
         uSkyFlipVLoc = glGetUniformLocation(skyProg, "uFlipV");
 
+        // Filter across face edges
+        glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
         glGenVertexArrays(1, &skyVAO);
 
         glUseProgram(skyProg);
-        glUniform1i(uSkyTexLoc, 3); // HDRI bound on texture unit 3
+        glUniform1i(uSkyTexLoc, 3); // sky cube bound on texture unit 3
         glUseProgram(0);
     }
 
     glm::vec3 camPos(0.0f, 8.0f, 32.0f);
     glm::vec3 camTarget(0.0f, 8.0f, 0.0f);
 
+    // The circular ground fade; terrain mode pushes it (and the far plane) out with its extent
+    float groundMaskRadius = 50.0f;
+    float groundMaskFade = 18.0f;
+    float farPlane = 200.0f;
+    std::uint64_t terrainLoggedBuilt = 0;
+    if (terrain) {
+        groundMaskRadius = 0.75f * terrainHalfSize;
+        groundMaskFade = 0.15f * terrainHalfSize;
+        farPlane = std::max(farPlane, 2.0f * terrainHalfSize);
+    }
+
+    // ---------------------------
+    // Uniform buffers (Uniforms.h)
+    //   frame:    camera / model / light, rewritten once per frame
+    //   material: one prebuilt block per material; the ground has one per pass (they only
+    //             differ in the cutoff). Only the GPU ground's step / relief ever change.
+    // ---------------------------
+    enum { kMatBark, kMatGroundDepth, kMatGroundColor, kMatCount };
+    auto frameUBO = std::make_unique<UniformBuffer<FrameBlock>>(kFrameBlockBinding, 1);
+    auto materialUBO = std::make_unique<UniformBuffer<MaterialBlock>>(kMaterialBlockBinding, kMatCount);
+    {
+        MaterialBlock& bark = materialUBO->edit(kMatBark);
+        bark.baseColor = solidMode ? glm::vec3(0.75f) : glm::vec3(1.0f); // light gray for screenshots
+        bark.normalStrength = 1.0f;
+        bark.specPower = 32.0f;
+        bark.specStrength = solidMode ? 0.15f : 0.35f;
+        bark.flipNormalY = 0; // if bumps look "inside out", change to 1
+        bark.macroFreq = 0.12f;
+        bark.macroStrength = 0.20f;
+        bark.uvWarp = 0.02f;
+        bark.barkTwist = 0.08f;
+
+        MaterialBlock ground;
+        ground.baseColor = glm::vec3(1.0f);
+        ground.normalStrength = 1.0f;
+        ground.specPower = 48.0f;
+        ground.specStrength = 0.12f;
+        ground.flipNormalY = 0;
+
+        // Subtle ground noise
+        ground.macroFreq = 0.03f;
+        ground.macroStrength = 0.18f;
+        ground.uvWarp = 0.02f;
+        ground.barkTwist = 0.0f;
+
+        // Circular mask + anti-tiling (ground only)
+        ground.useGroundMask = 1;
+        ground.groundRadius = groundMaskRadius;
+        ground.groundFade = groundMaskFade;
+        ground.useAltTiling = 1;
+        ground.altTilingMix = 0.75f;
+        ground.gpuGround = gpuGround ? 1 : 0;
+
+        materialUBO->edit(kMatGroundDepth) = ground;
+        materialUBO->edit(kMatGroundDepth).groundCutoff = 0.99f; // keep only opaque center in depth
+        materialUBO->edit(kMatGroundColor) = ground;
+        materialUBO->edit(kMatGroundColor).groundCutoff = 0.0f;  // disable discard; draw full fade
+    }
+
     //if (DeciduousMode) {glm::vec3 camPos(0.0f, 10.0f, 20.0f); glm::vec3 camTarget(0.0f, 5.0f, 0.0f);}
     //else { glm::vec3 camPos(0.0f, 15.0f, 25.0f); glm::vec3 camTarget(0.0f, 7.5f, 0.0f); }
 
-    while (!glfwWindowShouldClose(window)) {
-        ProcessInput(window);
+    // ---- Placeholder trunk, drawn until the first tree chunk arrives ----
+    GLuint placeholderVAO = 0, placeholderVBO = 0;
+    GLsizei placeholderVertCount = 0;
+    {
+        std::vector<VertexPN> ph = BuildPlaceholderVertices(params);
+        placeholderVertCount = (GLsizei)ph.size();
+
+        glGenVertexArrays(1, &placeholderVAO);
+        glGenBuffers(1, &placeholderVBO);
+        glBindVertexArray(placeholderVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, placeholderVBO);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(ph.size() * sizeof(VertexPN)), ph.data(), GL_STATIC_DRAW);
+        SetupVertexPNAttribs();
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
 
-        glClearColor(0.06f, 0.06f, 0.08f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // ---------------------------
+    // Startup task graph: GL side (textures are handled by TextureBatchLoader::pump)
+    // ---------------------------
+    GLuint hillVAO = 0, hillVBO = 0, hillEBO = 0;
+    GLsizei hillIndexCount = 0;
 
-        //rotate model constantly
-        float t = (float)glfwGetTime();
-        glm::mat4 model = glm::rotate(glm::mat4(1.0f), t * 0.25f, glm::vec3(0, 1, 0));
+    // GPU ground: the grid lives in hillVAO too, one index range per LOD
+    std::vector<GroundGridLod> groundLods;
+    int   groundLod = 1;
+    float groundRelief = 1.0f;
 
-        glm::mat4 view = glm::lookAt(camPos, camTarget, glm::vec3(0, 1, 0));
-        float aspect = (float)gWidth / (float)gHeight;
-        glm::mat4 proj = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 200.0f);
-        glm::mat4 viewProj = proj * view;
+    std::vector<PendingGLStep> glSteps;
 
-        // --- Sky pass (HDRI) ---
-        if (envMode && texHDRI && skyProg && skyVAO) {
-            glm::mat4 invProj = glm::inverse(proj);
-            glm::mat3 invViewRot = glm::transpose(glm::mat3(view)); // inverse of view rotation
-            glm::mat3 worldRot = glm::mat3(model);                // same rotation as the tree
+    // One VAO per variant over its vertex block's buffer and the shared instance buffer
+    struct ForestDraw {
+        GLuint vao = 0;
+        GLint firstVertex = 0;
+        GLsizei vertexCount = 0, instanceCount = 0;
+    };
+    std::vector<ForestDraw> forestDraws;
+    std::vector<GLuint> forestVBOs; // one per vertex block
+    GLuint forestInstanceVBO = 0;
+    if (forestFuture.valid()) {
+        glSteps.push_back({
+            [&]() { return IsReady(forestFuture); },
+            [&]() {
+                InstancedForest forest;
+                try {
+                    forest = forestFuture.get();
+                }
+                catch (const std::exception& e) {
+                    std::cerr << "Warning: forest build failed (" << e.what() << "), drawing the tree alone.\n";
+                    return;
+                }
 
-            glDepthMask(GL_FALSE);
-            glDisable(GL_DEPTH_TEST);
+                std::size_t vertexCount = 0;
+                forestVBOs.resize(forest.blocks.size());
+                glGenBuffers((GLsizei)forestVBOs.size(), forestVBOs.data());
+                for (std::size_t b = 0; b < forest.blocks.size(); ++b) {
+                    glBindBuffer(GL_ARRAY_BUFFER, forestVBOs[b]);
+                    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(forest.blocks[b].size() * sizeof(VertexPN)),
+                        forest.blocks[b].data(), GL_STATIC_DRAW);
+                    vertexCount += forest.blocks[b].size();
+                }
+                glGenBuffers(1, &forestInstanceVBO);
+                glBindBuffer(GL_ARRAY_BUFFER, forestInstanceVBO);
+                glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(forest.instances.size() * sizeof(ForestInstance)),
+                    forest.instances.data(), GL_STATIC_DRAW);
+
+                for (const ForestVariant& v : forest.variants) {
+                    ForestDraw d;
+                    d.firstVertex = (GLint)v.firstVertex;
+                    d.vertexCount = (GLsizei)v.vertexCount;
+                    d.instanceCount = (GLsizei)v.instanceCount;
+                    glGenVertexArrays(1, &d.vao);
+                    glBindVertexArray(d.vao);
+                    glBindBuffer(GL_ARRAY_BUFFER, forestVBOs[v.block]);
+                    SetupVertexPNAttribs();
+                    glBindBuffer(GL_ARRAY_BUFFER, forestInstanceVBO);
+                    SetupForestInstanceAttribs(v.firstInstance);
+                    forestDraws.push_back(d);
+                }
+                glBindVertexArray(0);
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-            glUseProgram(skyProg);
-            glUniformMatrix4fv(uSkyInvProjLoc, 1, GL_FALSE, &invProj[0][0]);
-            glUniformMatrix3fv(uSkyInvViewRotLoc, 1, GL_FALSE, &invViewRot[0][0]);
-            glUniformMatrix3fv(uSkyWorldRotLoc, 1, GL_FALSE, &worldRot[0][0]);
-            glUniform2f(uSkyResLoc, (float)gWidth, (float)gHeight);
+                std::cout << "Forest: " << forest.instances.size() << " trees from " << forest.variants.size()
+                    << " variants (" << vertexCount << " vertices) on " << forest.threads
+                    << " threads in " << forest.buildMs << " ms\n";
+            } });
+    }
 
-            // Tune these later; just start here
-            float exposure = (params.preset == TreePreset::Conifer) ? 1.25f : 1.45f;
-            glUniform1f(uSkyExposureLoc, exposure);
-            glUniform1f(uSkyGammaLoc, 2.2f);
+    if (envMode) {
+        // Environment cube (Part 1) GPU upload
+        glSteps.push_back({
+            [&]() { return IsReady(envCubeFuture); },
+            [&]() {
+                EnvCube cube = envCubeFuture.get();
+                texSkyCube = UploadEnvironmentCube(cube);
+
+                if (texSkyCube) {
+                    std::cout << "Environment cube " << cube.faceSize << "^2 x6 "
+                        << (cube.hdr ? "(HDR)" : "(8-bit)") << " from "
+                        << (cube.fromCache ? "cache" : "equirect") << " in " << cube.loadMs << " ms\n";
+
+                    if (cube.sh.valid) {
+                        // SH ambient replaces the flat uAmbient. It is rescaled so its average matches
+                        // the old constant: the HDRI gives direction and tint, not overall exposure
+                        // (an .hdr sky can be orders of magnitude brighter than the PNG).
+                        float avg = (cube.sh.E[0][0] + cube.sh.E[0][1] + cube.sh.E[0][2]) / 3.0f;
+                        float target = solidMode ? 0.50f : 0.65f;
+
+                        glUseProgram(prog);
+                        glUniform3fv(uSHLoc, 9, &cube.sh.E[0][0]);
+                        glUniform1f(uSHScaleLoc, target / std::max(avg, 1e-4f));
+                        glUniform1i(uUseSHLoc, 1);
+                        glUseProgram(0);
+
+                        std::cout << "Irradiance SH9 from " << (cube.sh.fromCache ? "cache" : "cube")
+                            << " in " << cube.sh.ms << " ms\n";
+                    }
+                }
+                else {
+                    std::cerr << "Warning: HDRI failed to load, environment will be disabled.\n";
+                    envMode = false;
+                }
+            } });
+
+        // Hill mesh (Part 2) GPU upload
+        if (!terrain) glSteps.push_back({
+            [&]() { return gpuGround ? IsReady(groundGridFuture) : IsReady(hillMeshFuture); },
+            [&]() {
+                HillMesh hill;
+                if (gpuGround) {
+                    // Same upload path; only the LOD table differs
+                    GroundGrid grid = groundGridFuture.get();
+                    hill.vertices = std::move(grid.vertices);
+                    hill.indices = std::move(grid.indices);
+                    groundLods = grid.lods;
+                    groundLod = std::min(groundLod, (int)groundLods.size() - 1);
+                }
+                else {
+                    hill = hillMeshFuture.get();
+                }
+                hillIndexCount = (GLsizei)hill.indices.size();
+
+                glGenVertexArrays(1, &hillVAO);
+                glGenBuffers(1, &hillVBO);
+                glGenBuffers(1, &hillEBO);
+
+                glBindVertexArray(hillVAO);
+                glBindBuffer(GL_ARRAY_BUFFER, hillVBO);
+                glBufferData(GL_ARRAY_BUFFER,
+                    (GLsizeiptr)(hill.vertices.size() * sizeof(VertexPN)),
+                    hill.vertices.data(),
+                    GL_STATIC_DRAW);
+
+                // Element buffer binding is VAO state
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, hillEBO);
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                    (GLsizeiptr)(hill.indices.size() * sizeof(std::uint32_t)),
+                    hill.indices.data(),
+                    GL_STATIC_DRAW);
+
+                // Same attribute layout as tree
+                SetupVertexPNAttribs();
+
+                glBindVertexArray(0);
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+            } });
+    }
 
-            // Invert skybox.
-            glUniform1i(uSkyFlipVLoc, 0);
+    // GL state cache + per-frame draw / state-change counters (RenderState.h)
+    RenderState rs;
 
-            glActiveTexture(GL_TEXTURE3);
-            glBindTexture(GL_TEXTURE_2D, texHDRI);
+    // Binds a uniform block slot through the state cache (uploads it first if it was edited)
+    auto bindBlock = [&](UniformSlots& ubo, int slot) {
+        const UniformSlots::Range r = ubo.range(slot);
+        rs.bindUniformRange(ubo.binding(), r.buffer, r.offset, r.size);
+    };
 
-            glBindVertexArray(skyVAO);
-            glDrawArrays(GL_TRIANGLES, 0, 3);
-            glBindVertexArray(0);
+    // --frame-timing: one section per render pass (GPU-timed) plus the CPU-only parts of the loop
+    enum TimedSection { kTimeUpdate, kTimeTerrain, kTimeSky, kTimeGroundDepth, kTimeGroundColor,
+        kTimeTree, kTimeSwap };
+    std::unique_ptr<FrameTimer> frameTimer;
+    std::ofstream frameTimingFile;
+    if (frameTiming) {
+        frameTimer = std::make_unique<FrameTimer>(std::vector<FrameTimer::Section>{
+            { "update", false }, { "terrain", false }, { "sky", true }, { "ground_depth", true },
+            { "ground_color", true }, { "tree", true }, { "swap", false } });
+        if (!frameTimer->gpuTimers())
+            std::cout << "Frame timing: no GPU timer on this driver, CPU times only.\n";
+
+        if (!frameTimingCsv.empty()) {
+            frameTimingFile.open(frameTimingCsv);
+            if (frameTimingFile) frameTimer->writeCsvHeader(frameTimingFile);
+            else std::cerr << "Warning: cannot write " << frameTimingCsv << ", timing goes to stdout.\n";
+        }
+    }
+    auto timeBegin = [&](int section) { if (frameTimer) frameTimer->begin(section); };
+    auto timeEnd = [&](int section) { if (frameTimer) frameTimer->end(section); };
+
+    // --render-stats: counters summed over ~1 s
+    RenderStats rsSum;
+    std::uint32_t rsFrames = 0;
+    double rsLast = glfwGetTime();
+
+    // --bench-frames: startup costs, then one GPU-complete time per frame of the camera path
+    const glm::vec3 benchCamPos = camPos;
+    float benchTime = 0.0f;
+    int benchFrame = -1;             // < 0: still waiting for startup to finish
+    double benchTreeGenMs = 0.0;     // worker: tree build, start to last chunk
+    double benchUploadMs = 0.0;      // GL thread: tree chunks + textures + startup GL steps
+    double benchStartupMs = 0.0;
+    std::vector<double> benchFrameMs;
+    auto benchClockStart = std::chrono::steady_clock::now();
+
+    // One frame of the scene (partial tree / placeholder while the build is still running).
+    // Every pass states the GL state it needs through `rs`; nothing is restored afterwards,
+    // the cache drops whatever is already set.
+    auto drawFrame = [&]() {
+            //rotate model constantly (benchmark: fixed step per frame, see benchTime)
+            float t = (benchFrames > 0) ? benchTime : (float)glfwGetTime();
+            glm::mat4 model = glm::rotate(glm::mat4(1.0f), t * 0.25f, glm::vec3(0, 1, 0));
+
+            glm::mat4 view = glm::lookAt(camPos, camTarget, glm::vec3(0, 1, 0));
+            float aspect = (float)gWidth / (float)gHeight;
+            glm::mat4 proj = glm::perspective(glm::radians(45.0f), aspect, 0.1f, farPlane);
+            glm::mat4 viewProj = proj * view;
+
+            // Terrain picks its chunks around the camera target (in ground space, it turns with
+            // the tree) and keeps building them even before the ground textures are in.
+            // Its uploads bind GL objects directly, so this runs before the state cache resets.
+            if (envMode && terrain) {
+                timeBegin(kTimeTerrain);
+                terrain->update(glm::vec3(glm::inverse(model) * glm::vec4(camTarget, 1.0f)));
+
+                const TerrainStats& ts = terrain->stats();
+                if (ts.building == 0 && ts.built != terrainLoggedBuilt) {
+                    terrainLoggedBuilt = ts.built;
+                    std::cout << "Terrain: " << ts.drawnChunks << " chunks / " << ts.drawnVertices
+                        << " vertices drawn, " << ts.resident << " resident, " << ts.built << " built\n";
+                }
+                timeEnd(kTimeTerrain);
+            }
 
-            glBindTexture(GL_TEXTURE_2D, 0);
-            glUseProgram(0);
+            rs.beginFrame();
+
+            // glClear honours the write masks
+            rs.setDepthMask(true);
+            rs.setColorMask(true);
+            glClearColor(0.06f, 0.06f, 0.08f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            // Frame block: shared by the hill and tree draws (the hill rotates with the tree,
+            // and so does the environment the SH ambient is looked up in)
+            {
+                FrameBlock& fb = frameUBO->edit(0);
+                glm::mat3 envRot = glm::mat3(model);
+                fb.viewProj = viewProj;
+                fb.model = model;
+                for (int c = 0; c < 3; ++c) fb.envRot[c] = glm::vec4(envRot[c], 0.0f);
+                fb.camPos = camPos;
+                fb.lightDir = glm::normalize(glm::vec3(0.4f, 1.0f, 0.3f));
+                fb.ambient = solidMode ? glm::vec3(0.50f) : glm::vec3(0.65f); // flat fallback until the SH is in
+                bindBlock(*frameUBO, 0);
+            }
 
-            glEnable(GL_DEPTH_TEST);
-            glDepthMask(GL_TRUE);
-        }
+            // --- Sky pass (HDRI) ---
+            if (envMode && texSkyCube && skyProg && skyVAO) {
+                timeBegin(kTimeSky);
+                glm::mat4 invProj = glm::inverse(proj);
+                glm::mat3 invViewRot = glm::transpose(glm::mat3(view)); // inverse of view rotation
+                glm::mat3 worldRot = glm::mat3(model);                // same rotation as the tree
 
-        // ---------------------------
-        // Draw hill (Part 2): two-pass
-        //   Pass A: depth-only cutout (clips tree)
-        //   Pass B: blended color (soft edge), no depth writes
-        // ---------------------------
-        if (envMode && hillVAO && hillVertCount > 0) {
-
-            glUseProgram(prog);
-
-            // Rotate hill with tree so environment matches
-            glm::mat4 hillModel = model;
-            glUniformMatrix4fv(uModelLoc, 1, GL_FALSE, &hillModel[0][0]);
-            glUniformMatrix4fv(uViewProjLoc, 1, GL_FALSE, &viewProj[0][0]);
-
-            // Bind ground textures
-            glActiveTexture(GL_TEXTURE0); glBindTexture(GL_TEXTURE_2D, texGroundAlbedo);
-            glActiveTexture(GL_TEXTURE1); glBindTexture(GL_TEXTURE_2D, texGroundNormal);
-            glActiveTexture(GL_TEXTURE2); glBindTexture(GL_TEXTURE_2D, texGroundRough);
-
-            // Material tuning for ground
-            glUniform3f(uBaseColorLoc, 1.0f, 1.0f, 1.0f);
-            glUniform3f(uCamPosLoc, camPos.x, camPos.y, camPos.z);
-
-            glUniform1f(uNormalStrLoc, 1.0f);
-            glUniform1f(uSpecPowerLoc, 48.0f);
-            glUniform1f(uSpecStrLoc, 0.12f);
-            glUniform1i(uFlipNormalYLoc, 0);
-
-            // Subtle ground noise
-            glUniform1f(glGetUniformLocation(prog, "uMacroFreq"), 0.03f);
-            glUniform1f(glGetUniformLocation(prog, "uMacroStrength"), 0.18f);
-            glUniform1f(glGetUniformLocation(prog, "uUVWarp"), 0.02f);
-            glUniform1f(glGetUniformLocation(prog, "uBarkTwist"), 0.0f);
-
-            // Circular mask params (shared by both passes)
-            GLint locUseGroundMask = glGetUniformLocation(prog, "uUseGroundMask");
-            GLint locGroundRadius = glGetUniformLocation(prog, "uGroundRadius");
-            GLint locGroundFade = glGetUniformLocation(prog, "uGroundFade");
-            GLint locGroundCutoff = glGetUniformLocation(prog, "uGroundCutoff");
-
-            glUniform1i(locUseGroundMask, 1);
-            glUniform1f(locGroundRadius, 50.0f);
-            glUniform1f(locGroundFade, 18.0f);
-
-            // Anti-tiling (ground only)
-            glUniform1i(glGetUniformLocation(prog, "uUseAltTiling"), 1);
-            glUniform1f(glGetUniformLocation(prog, "uAltTilingMix"), 0.75f);
-
-            glBindVertexArray(hillVAO);
-
-            // ---- Pass A: depth-only prepass (alpha cutout) ----
-            glDisable(GL_BLEND);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
-            glDepthMask(GL_TRUE);
-            glEnable(GL_DEPTH_TEST);
-            glDepthFunc(GL_LESS);
-
-            glUniform1f(locGroundCutoff, 0.99f); // keep only opaque center in depth
-            glDrawArrays(GL_TRIANGLES, 0, hillVertCount);
-
-            // ---- Pass B: color pass (blended fade), no depth writes ----
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-            glDepthMask(GL_FALSE);
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-            glDepthFunc(GL_LEQUAL); // allow drawing exactly on prepass depth
-
-            glUniform1f(locGroundCutoff, 0.0f); // disable discard; draw full fade
-            glDrawArrays(GL_TRIANGLES, 0, hillVertCount);
-
-            // Restore defaults for the tree
-            glDepthFunc(GL_LESS);
-            glDepthMask(GL_TRUE);
-            glDisable(GL_BLEND);
-
-            glBindVertexArray(0);
-        }
+                rs.setDepthMask(false);
+                rs.setDepthTest(false);
+                rs.setBlend(false);
 
-        glUseProgram(prog);
-        glUniformMatrix4fv(uModelLoc, 1, GL_FALSE, &model[0][0]);
-        glUniformMatrix4fv(uViewProjLoc, 1, GL_FALSE, &viewProj[0][0]);
+                rs.useProgram(skyProg);
+                glUniformMatrix4fv(uSkyInvProjLoc, 1, GL_FALSE, &invProj[0][0]);
+                glUniformMatrix3fv(uSkyInvViewRotLoc, 1, GL_FALSE, &invViewRot[0][0]);
+                glUniformMatrix3fv(uSkyWorldRotLoc, 1, GL_FALSE, &worldRot[0][0]);
 
-        // Bind textures
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texAlbedo);
+                // Tune these later; just start here
+                float exposure = (params.preset == TreePreset::Conifer) ? 1.25f : 1.45f;
+                glUniform1f(uSkyExposureLoc, exposure);
+                glUniform1f(uSkyGammaLoc, 2.2f);
 
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, texNormal);
+                // Invert skybox.
+                glUniform1i(uSkyFlipVLoc, 0);
 
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, texRough);
+                rs.bindTexture(3, GL_TEXTURE_CUBE_MAP, texSkyCube);
 
-        // Material params
-        //glUniform3f(uBaseColorLoc, 0.55f, 0.27f, 0.07f);
-        if (solidMode) glUniform3f(uBaseColorLoc, 0.75f, 0.75f, 0.75f); // light gray
-        else           glUniform3f(uBaseColorLoc, 1.0f, 1.0f, 1.0f);
+                rs.bindVertexArray(skyVAO);
+                rs.drawArrays(GL_TRIANGLES, 0, 3);
+                timeEnd(kTimeSky);
+            }
 
-        glUniform3f(uCamPosLoc, camPos.x, camPos.y, camPos.z);
+            // ---------------------------
+            // Draw hill (Part 2): two-pass
+            //   Pass A: depth-only cutout (clips tree)
+            //   Pass B: blended color (soft edge), no depth writes
+            // ---------------------------
+            if (envMode && (terrain || (hillVAO && hillIndexCount > 0)) && texGroundAlbedo && texGroundNormal && texGroundRough) {
+
+                rs.useProgram(prog);
+
+                // Bind ground textures
+                rs.bindTexture(0, GL_TEXTURE_2D, texGroundAlbedo);
+                rs.bindTexture(1, GL_TEXTURE_2D, texGroundNormal);
+                rs.bindTexture(2, GL_TEXTURE_2D, texGroundRough);
+
+                // Whole mesh, or the current LOD's index range of the GPU ground grid
+                GLsizei drawCount = hillIndexCount;
+                const void* drawOffset = nullptr;
+                if (gpuGround && !groundLods.empty()) {
+                    const GroundGridLod& lod = groundLods[groundLod];
+                    drawCount = (GLsizei)lod.indexCount;
+                    drawOffset = (const void*)(std::uintptr_t)(lod.firstIndex * sizeof(std::uint32_t));
+
+                    rs.bindTexture(4, GL_TEXTURE_2D, texGroundDisp);
+
+                    // Only rewritten (and reuploaded on bind) after G / [ / ]
+                    const float step = 2.0f * hillHalfSize / float(lod.cells);
+                    for (int m : { kMatGroundDepth, kMatGroundColor }) {
+                        const MaterialBlock& cur = materialUBO->get(m);
+                        if (cur.groundStep != step || cur.groundRelief != groundRelief) {
+                            MaterialBlock& b = materialUBO->edit(m);
+                            b.groundStep = step;
+                            b.groundRelief = groundRelief;
+                        }
+                    }
+                }
 
-        glUniform1f(glGetUniformLocation(prog, "uMacroFreq"), 0.12f);
-        glUniform1f(glGetUniformLocation(prog, "uMacroStrength"), 0.20f);
-        glUniform1f(glGetUniformLocation(prog, "uUVWarp"), 0.02f);
-        glUniform1f(glGetUniformLocation(prog, "uBarkTwist"), 0.08f);
+                auto drawGround = [&]() {
+                    if (terrain) {
+                        terrain->draw(rs);
+                        return;
+                    }
+                    rs.bindVertexArray(hillVAO);
+                    rs.drawElements(GL_TRIANGLES, drawCount, GL_UNSIGNED_INT, drawOffset);
+                };
+
+                // ---- Pass A: depth-only prepass (alpha cutout) ----
+                timeBegin(kTimeGroundDepth);
+                rs.setBlend(false);
+                rs.setColorMask(false);
+                rs.setDepthMask(true);
+                rs.setDepthTest(true);
+                rs.setDepthFunc(GL_LESS);
+
+                bindBlock(*materialUBO, kMatGroundDepth);
+                drawGround();
+                timeEnd(kTimeGroundDepth);
+
+                // ---- Pass B: color pass (blended fade), no depth writes ----
+                timeBegin(kTimeGroundColor);
+                rs.setColorMask(true);
+                rs.setDepthMask(false);
+                rs.setBlend(true);
+                rs.setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                rs.setDepthFunc(GL_LEQUAL); // allow drawing exactly on prepass depth
+
+                bindBlock(*materialUBO, kMatGroundColor);
+                drawGround();
+                timeEnd(kTimeGroundColor);
+            }
 
-        glUniform1i(glGetUniformLocation(prog, "uUseGroundMask"), 0);
-        glUniform1i(glGetUniformLocation(prog, "uUseAltTiling"), 0);
-        glUniform1f(glGetUniformLocation(prog, "uAltTilingMix"), 0.0f);
+            // ---- Tree: opaque, default depth state ----
+            timeBegin(kTimeTree);
+            rs.useProgram(prog);
+            rs.setBlend(false);
+            rs.setColorMask(true);
+            rs.setDepthMask(true);
+            rs.setDepthTest(true);
+            rs.setDepthFunc(GL_LESS);
+
+            // Bind textures
+            rs.bindTexture(0, GL_TEXTURE_2D, texAlbedo);
+            rs.bindTexture(1, GL_TEXTURE_2D, texNormal);
+            rs.bindTexture(2, GL_TEXTURE_2D, texRough);
+
+            // Material params
+            bindBlock(*materialUBO, kMatBark);
+
+            // May be a partial tree while chunks are still streaming in;
+            // until the first chunk lands, show the trunk stand-in instead
+            if (tree.vertCount > 0) {
+                rs.bindVertexArray(tree.vao);
+                if (tree.indexCount > 0) rs.drawElements(GL_TRIANGLES, tree.indexCount, GL_UNSIGNED_INT, nullptr);
+                else rs.drawArrays(GL_TRIANGLES, 0, tree.vertCount);
+            }
+            else if (placeholderVertCount > 0) {
+                rs.bindVertexArray(placeholderVAO);
+                rs.drawArrays(GL_TRIANGLES, 0, placeholderVertCount);
+            }
 
-        glUniform1f(uNormalStrLoc, 1.0f);
-        glUniform1f(uSpecPowerLoc, 32.0f);
-        glUniform1f(uSpecStrLoc, solidMode ? 0.15f : 0.35f);
-        glUniform1i(uFlipNormalYLoc, 0); // if bumps look "inside out", change to 1
+            // Same bark and material as the main tree; one instanced draw per variant
+            for (const ForestDraw& d : forestDraws) {
+                rs.bindVertexArray(d.vao);
+                rs.drawArraysInstanced(GL_TRIANGLES, d.firstVertex, d.vertexCount, d.instanceCount);
+            }
+            // A draw that sourced 4..8 from arrays leaves their current values undefined (GL 3.3
+            // core); put the identity / white back before the next frame's ground and tree
+            if (!forestDraws.empty()) SetDefaultInstanceAttribs();
+            timeEnd(kTimeTree);
 
-        //glUniform3f(uColorLoc, 0.55f, 0.27f, 0.07f);
-        glUniform3f(uAmbientLoc, 0.75f, 0.75f, 0.75f);
+            // Uploads between frames bind buffers and must not land in a scene VAO
+            rs.bindVertexArray(0);
+    };
 
-        if (solidMode) glUniform3f(uAmbientLoc, 0.50f, 0.50f, 0.50f); // light gray
-        else           glUniform3f(uAmbientLoc, 0.65f, 0.65f, 0.65f);
+    // Upload budget per frame keeps the loop responsive while a big tree streams in
+    const std::size_t maxChunksPerFrame = 4;
+    std::vector<std::vector<VertexPN>> readyChunks;
 
-        glm::vec3 lightDir = glm::normalize(glm::vec3(0.4f, 1.0f, 0.3f));
-        glUniform3f(uLightDirLoc, lightDir.x, lightDir.y, lightDir.z);
+    bool firstFrameShown = false;
+    bool startupDone = false;
 
-        glBindVertexArray(vao);
-        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)verts.size());
-        glBindVertexArray(0);
+    while (!glfwWindowShouldClose(window)) {
+        if (frameTimer) frameTimer->beginFrame();
+        timeBegin(kTimeUpdate);
+        const auto loopStart = std::chrono::steady_clock::now();
+
+        // Benchmark camera path: one turn of the scene while the camera dollies in and out
+        if (benchFrames > 0 && benchFrame >= 0) {
+            const float u = float(benchFrame) / float(benchFrames);
+            benchTime = u * 6.2831853f / 0.25f; // the model turns at 0.25 rad/s
+            camPos = camTarget + (benchCamPos - camTarget) * (0.8f + 0.25f * std::cos(6.2831853f * u));
+        }
+
+        ProcessInput(window);
+
+        // Parameter change -> cancel + restart
+        if (gReseedRequested || gIterationDelta != 0) {
+            if (gReseedRequested) params.seed = std::random_device{}();
+            params.iterations = std::max(0, params.iterations + gIterationDelta);
+            gReseedRequested = false;
+            gIterationDelta = 0;
+
+            std::cout << "Rebuilding: seed=" << params.seed << " iter=" << params.iterations << "\n";
+            startBuild();
+        }
+
+        // GPU ground: uniforms / index range only, nothing is rebuilt or reuploaded
+        if (gGroundReliefSteps != 0 || gGroundLodSteps != 0) {
+            groundRelief = std::clamp(groundRelief * std::pow(1.25f, (float)gGroundReliefSteps), 0.0f, 8.0f);
+            if (!groundLods.empty())
+                groundLod = (groundLod + gGroundLodSteps) % (int)groundLods.size();
+            gGroundReliefSteps = 0;
+            gGroundLodSteps = 0;
+
+            if (gpuGround && !groundLods.empty()) {
+                std::cout << "GPU ground: relief x" << groundRelief
+                    << ", " << groundLods[groundLod].cells << "^2 quads\n";
+            }
+        }
+
+        // Non-blocking handoff from the worker
+        const auto uploadStart = std::chrono::steady_clock::now();
+        STATS_PHASE_VAR(uploadPhase, nullptr, "upload");
+        if (job) {
+            readyChunks.clear();
+            job->takeChunks(readyChunks, maxChunksPerFrame);
+            for (const auto& c : readyChunks)
+                AppendTreeStream(tree, c.data(), c.size());
+
+            if (job->done()) {
+                try {
+                    std::size_t total = job->get();
+                    benchTreeGenMs = (glfwGetTime() - jobStart) * 1000.0;
+                    std::cout << "Tree vertices: " << total
+                        << " (" << (glfwGetTime() - jobStart) << " s)\n  ";
+                    job->info().stats.print(std::cout);
+
+                    // Read the finished tree back once and let the pool weld + write it
+                    if (!treeMeshPath.empty() && tree.vertCount > 0) {
+                        if (treeMeshSave.valid()) {
+                            std::cerr << "Warning: previous tree mesh still being written, not saving this one\n";
+                        }
+                        else {
+                            std::vector<VertexPN> verts((std::size_t)tree.vertCount);
+                            glBindBuffer(GL_ARRAY_BUFFER, tree.vbo);
+                            glGetBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(verts.size() * sizeof(VertexPN)), verts.data());
+                            glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+                            const std::uint64_t hash = HashTreeParams(job->params());
+                            treeMeshSave = pool.submit([path = treeMeshPath, hash, verts = std::move(verts)]() {
+                                try {
+                                    std::vector<VertexPN> welded;
+                                    std::vector<std::uint32_t> indices;
+                                    WeldTreeVertices(verts.data(), verts.size(), welded, indices);
+                                    return WriteTreeMesh(path, hash, welded.data(), welded.size(), indices.data(), indices.size());
+                                }
+                                catch (const std::bad_alloc&) {
+                                    std::cerr << "Warning: out of memory writing tree mesh " << path << "\n";
+                                    return false;
+                                }
+                            });
+                        }
+                    }
+                }
+                catch (const TreeBuildCancelled&) {
+                    // superseded by a newer build
+                }
+                catch (const std::bad_alloc& e) {
+                    std::cerr << "Out of memory while building tree: " << e.what() << "\n";
+                    // phases that were unwound still got recorded: shows which stage blew up
+                    if (job->info().stats.failedPhase)
+                        std::cerr << "  in " << job->info().stats.failedPhase << "\n";
+                    if (!job->info().stats.phases.empty()) {
+                        std::cerr << "  ";
+                        job->info().stats.print(std::cerr);
+                    }
+                    return -1;
+                }
+                catch (const std::exception& e) {
+                    std::cerr << "Exception while building tree: " << e.what() << "\n";
+                    return -1;
+                }
+                job.reset();
+                glfwSetWindowTitle(window, "L-System Tree");
+            }
+        }
+
+        if (IsReady(treeMeshSave) && treeMeshSave.get())
+            std::cout << "Saved tree mesh " << treeMeshPath << "\n";
+
+        // GL half of the startup graph: upload whatever the pool has finished
+        textures.pump();
+        PumpPendingGLSteps(glSteps);
+        STATS_PHASE_END(uploadPhase);
+        if (!startupDone) {
+            benchUploadMs += std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - uploadStart).count();
+        }
+        timeEnd(kTimeUpdate);
 
-        glfwSwapBuffers(window);
+        {
+            STATS_PHASE(nullptr, "frame");
+            drawFrame();
+        }
+
+        if (benchFrames > 0 && benchFrame >= 0) {
+            glFinish(); // the frame counts once the GPU is done with it
+            benchFrameMs.push_back(std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - loopStart).count());
+            if (++benchFrame >= benchFrames) glfwSetWindowShouldClose(window, GLFW_TRUE);
+        }
+
+        if (renderStats) {
+            const RenderStats& st = rs.stats();
+            rsFrames += 1;
+            rsSum.requests += st.requests;
+            rsSum.stateChanges += st.stateChanges;
+            rsSum.drawCalls += st.drawCalls;
+            rsSum.vertices += st.vertices;
+
+            const double now = glfwGetTime();
+            if (now - rsLast >= 1.0) {
+                const double n = double(rsFrames);
+                std::cout << "Render: " << (rsSum.drawCalls / n) << " draws, "
+                    << (rsSum.stateChanges / n) << "/" << (rsSum.requests / n) << " state changes ("
+                    << (rsSum.skipped() / n) << " skipped), "
+                    << (rsSum.vertices / n) << " vertices per frame, " << (n / (now - rsLast)) << " fps\n";
+                rsSum = RenderStats{};
+                rsFrames = 0;
+                rsLast = now;
+            }
+        }
+
+        timeBegin(kTimeSwap);
+        if (benchFrames == 0) glfwSwapBuffers(window);
         glfwPollEvents();
+        timeEnd(kTimeSwap);
+
+        if (frameTimer && frameTimer->endFrame()) {
+            if (frameTimingFile.is_open() && frameTimingFile) frameTimer->writeCsvRow(frameTimingFile);
+            else frameTimer->print(std::cout);
+        }
+
+        if (!firstFrameShown) {
+            firstFrameShown = true;
+            std::cout << "Time to first frame: " << msSinceStartup() << " ms\n";
+        }
+        if (!startupDone && glSteps.empty() && textures.idle() && !job) {
+            startupDone = true;
+            std::cout << "Startup complete (all assets + tree resident): " << msSinceStartup() << " ms\n";
+            textures.printTimings(std::cout);
+        }
+
+        // Benchmark: the timed frames start once everything is resident (terrain included)
+        if (benchFrames > 0 && benchFrame < 0) {
+            const double waitedMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - benchClockStart).count();
+            if (startupDone && (!terrain || terrain->stats().building == 0)) {
+                benchStartupMs = msSinceStartup();
+                benchFrame = 0;
+                benchFrameMs.reserve((std::size_t)benchFrames);
+            }
+            else if (waitedMs > 300000.0) {
+                std::cerr << "Benchmark: startup did not finish within 300 s\n";
+                benchFrames = -1; // failed, skip the report
+                glfwSetWindowShouldClose(window, GLFW_TRUE);
+            }
+        }
+    }
+
+    int exitCode = 0;
+    if (!tracePath.empty()) {
+        if (TraceWriteJson(tracePath)) std::cout << "Trace written to " << tracePath << "\n";
+        else std::cerr << "Warning: cannot write trace " << tracePath << "\n";
+    }
+    if (benchFrames < 0) {
+        exitCode = -1;
     }
+    else if (benchFrames > 0 && !benchFrameMs.empty()) {
+        std::vector<double> sorted = benchFrameMs;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0.0;
+        for (double ms : sorted) sum += ms;
+        const double p95 = Percentile(sorted, 95.0);
+
+        std::cout << "\nBenchmark (" << sorted.size() << " frames, " << gWidth << "x" << gHeight << " offscreen)\n"
+            << "  startup:    " << benchStartupMs << " ms (tree generation " << benchTreeGenMs
+            << " ms, GL uploads " << benchUploadMs << " ms)\n"
+            << "  frame time: mean " << (sum / double(sorted.size())) << " ms, p50 " << Percentile(sorted, 50.0)
+            << ", p95 " << p95 << ", p99 " << Percentile(sorted, 99.0) << ", max " << sorted.back() << " ms\n";
+
+        if (benchBudgetMs > 0.0) {
+            const bool ok = p95 <= benchBudgetMs;
+            std::cout << "  budget:     p95 " << p95 << " ms vs " << benchBudgetMs << " ms -> "
+                << (ok ? "OK" : "EXCEEDED") << "\n";
+            if (!ok) exitCode = 1;
+        }
+    }
+
+    job.reset(); // cancel + join before the GL context goes away
+    frameTimer.reset(); // queries
+    terrain.reset();  // chunk buffers
+    frameUBO.reset();
+    materialUBO.reset();
 
     glDeleteProgram(prog);
-    glDeleteBuffers(1, &vbo);
-    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &tree.vbo);
+    if (tree.ebo) glDeleteBuffers(1, &tree.ebo);
+    glDeleteVertexArrays(1, &tree.vao);
+    glDeleteBuffers(1, &placeholderVBO);
+    glDeleteVertexArrays(1, &placeholderVAO);
+    for (const ForestDraw& d : forestDraws) glDeleteVertexArrays(1, &d.vao);
+    if (!forestVBOs.empty()) glDeleteBuffers((GLsizei)forestVBOs.size(), forestVBOs.data());
+    if (forestInstanceVBO) glDeleteBuffers(1, &forestInstanceVBO);
+    if (hillVAO) {
+        glDeleteBuffers(1, &hillVBO);
+        glDeleteBuffers(1, &hillEBO);
+        glDeleteVertexArrays(1, &hillVAO);
+    }
 
     if (skyProg) glDeleteProgram(skyProg);
     if (skyVAO)  glDeleteVertexArrays(1, &skyVAO);
-    if (texHDRI) glDeleteTextures(1, &texHDRI);
+    if (texSkyCube) glDeleteTextures(1, &texSkyCube);
+    if (texGroundDisp) glDeleteTextures(1, &texGroundDisp);
 
     glDeleteTextures(1, &texAlbedo);
     glDeleteTextures(1, &texNormal);
     glDeleteTextures(1, &texRough);
 
+    if (benchFBO) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &benchFBO);
+        glDeleteRenderbuffers(1, &benchColorRB);
+        glDeleteRenderbuffers(1, &benchDepthRB);
+    }
+
     glfwTerminate();
-    return 0;
+    return exitCode;
 }
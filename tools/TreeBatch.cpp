@@ -0,0 +1,199 @@
+//TreeBatch.cpp
+// Headless tree generator for asset pipelines: no window, no GL context, no assets.
+// Builds every requested (preset, seed) pair on a worker pool and writes each mesh to disk.
+// OBJ is streamed, so memory stays at a few chunks per worker however big the trees get;
+// .treemesh (TreeMesh.h) is welded first, so each worker holds its whole tree once.
+// .glb streams too (GlbStreamWriter): welded chunk by chunk, indices spooled to a temp file.
+//
+// Usage: tree-batch [-p deciduous,conifer] [-s seeds] [-i iterations] [-j threads] [-f obj|treemesh|glb] [-o out]
+//   -s takes a list and/or ranges, e.g. 1,5,10-20 (default 2025)
+//   -i overrides the preset's iteration count
+//   -j worker threads (default: one per hardware thread)
+//   -f output format (default obj). A .treemesh loads instantly with
+//      `opengl-template --tree-mesh <file>` given the same preset, -i and -seed.
+//      A .glb references the preset's bark textures (relative URIs, so keep the assets next to it).
+//   --assets <dir>  project root holding assets/ for the .glb texture URIs
+//      (default: the first one found walking up from the working directory; none -> untextured)
+//   --hill  also put the preset's hill (as the app draws it) into each .glb
+//   -o output directory, created if needed (default "trees"): one <preset>_<seed>.<format> per tree.
+//      With a single tree, -o may also name the file itself.
+//   Exit code: 0 all written, 1 some tree failed, 2 bad arguments.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <future>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ThreadPool.h"
+#include "TreeExport.h"
+#include "TreeGen.h"
+
+namespace fs = std::filesystem;
+
+enum class BatchFormat { Obj, TreeMesh, Glb };
+
+struct BatchJob {
+    TreePreset preset;
+    std::uint32_t seed;
+    fs::path out;
+};
+
+struct BatchResult {
+    TreeExportResult r;
+    double ms = 0.0;
+};
+
+// "1,5,10-20" -> 1 5 10 11 ... 20. False on anything that isn't a number or a range.
+static bool ParseSeeds(const std::string& s, std::vector<std::uint32_t>& out)
+{
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        char* end = nullptr;
+        const unsigned long a = std::strtoul(item.c_str(), &end, 10);
+        unsigned long b = a;
+        if (*end == '-') b = std::strtoul(end + 1, &end, 10);
+        if (*end != '\0' || b < a) return false;
+        for (unsigned long v = a; v <= b; ++v) out.push_back((std::uint32_t)v);
+    }
+    return !out.empty();
+}
+
+static bool ParsePresets(const std::string& s, std::vector<TreePreset>& out)
+{
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        TreePreset preset;
+        if (!ParsePresetName(item, preset)) return false;
+        out.push_back(preset);
+    }
+    return !out.empty();
+}
+
+static BatchResult RunJob(const BatchJob& job, int iterations, BatchFormat format, const GlbExportOptions& glbOpt)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+
+    TreeParams p;
+    p.preset = job.preset;
+    ApplyTreePreset(p);
+    if (iterations > 0) p.iterations = iterations;
+    p.seed = job.seed;
+
+    BatchResult b;
+    if (format == BatchFormat::Glb) b.r = ExportTreeGlb(job.out, p, glbOpt);
+    else if (format == BatchFormat::TreeMesh) b.r = ExportTreeMesh(job.out, p);
+    else b.r = ExportTreeObj(job.out, p);
+    b.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return b;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<TreePreset> presets;
+    std::vector<std::uint32_t> seeds;
+    int iterations = 0;
+    unsigned threads = 0;
+    BatchFormat format = BatchFormat::Obj;
+    fs::path outPath = "trees";
+    GlbExportOptions glbOpt;
+    bool assetsGiven = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        bool ok = true;
+        if (arg == "-p" && hasValue) ok = ParsePresets(argv[++i], presets);
+        else if (arg == "-s" && hasValue) ok = ParseSeeds(argv[++i], seeds);
+        else if (arg == "-i" && hasValue) iterations = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "-j" && hasValue) threads = (unsigned)std::max(1, std::atoi(argv[++i]));
+        else if (arg == "-o" && hasValue) outPath = argv[++i];
+        else if (arg == "--assets" && hasValue) {
+            glbOpt.assets = argv[++i];
+            assetsGiven = true;
+        }
+        else if (arg == "--hill") glbOpt.hill = true;
+        else if (arg == "-f" && hasValue) {
+            const std::string f = argv[++i];
+            if (f == "obj") format = BatchFormat::Obj;
+            else if (f == "treemesh") format = BatchFormat::TreeMesh;
+            else if (f == "glb") format = BatchFormat::Glb;
+            else ok = false;
+        }
+        else ok = false;
+
+        if (!ok) {
+            std::printf("Usage: tree-batch [-p deciduous,conifer] [-s 1,5,10-20] [-i iterations] [-j threads] [-f obj|treemesh|glb] [--assets dir] [--hill] [-o dir|file]\n");
+            return (arg == "-h" || arg == "--help") ? 0 : 2;
+        }
+    }
+    if (presets.empty()) presets.push_back(TreePreset::Deciduous);
+    if (seeds.empty()) seeds.push_back(2025);
+    if (format == BatchFormat::Glb) {
+        if (!assetsGiven) glbOpt.assets = FindAssetsRoot();
+        std::error_code ec;
+        if (!glbOpt.assets.empty()) glbOpt.assets = fs::absolute(glbOpt.assets, ec);
+        if (glbOpt.assets.empty()) std::fprintf(stderr, "No assets/textures found: .glb files will be untextured\n");
+    }
+
+    // ---------------------------
+    // Output names
+    // ---------------------------
+    std::vector<BatchJob> jobs;
+    const std::string ext = (format == BatchFormat::TreeMesh) ? ".treemesh"
+        : (format == BatchFormat::Glb) ? ".glb" : ".obj";
+    const bool singleFile = presets.size() * seeds.size() == 1 && outPath.extension() == ext;
+    for (TreePreset preset : presets) {
+        for (std::uint32_t seed : seeds) {
+            const std::string name = std::string(PresetName(preset)) + "_" + std::to_string(seed) + ext;
+            jobs.push_back({ preset, seed, singleFile ? outPath : outPath / name });
+        }
+    }
+
+    std::error_code ec;
+    const fs::path dir = singleFile ? outPath.parent_path() : outPath;
+    if (!dir.empty()) fs::create_directories(dir, ec);
+    if (ec) {
+        std::fprintf(stderr, "Cannot create %s: %s\n", dir.string().c_str(), ec.message().c_str());
+        return 2;
+    }
+
+    // ---------------------------
+    // Build + write, one tree per pool task
+    // ---------------------------
+    ThreadPool pool(threads);
+    std::printf("tree-batch: %zu trees on %u threads\n", jobs.size(), pool.size());
+
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::future<BatchResult>> results;
+    results.reserve(jobs.size());
+    for (const BatchJob& job : jobs)
+        results.push_back(pool.submit([&job, iterations, format, &glbOpt]() { return RunJob(job, iterations, format, glbOpt); }));
+
+    std::size_t failed = 0, totalVerts = 0;
+    for (std::size_t i = 0; i < jobs.size(); ++i) {
+        const BatchResult b = results[i].get();
+        const TreeExportResult& r = b.r;
+        if (r.ok) {
+            totalVerts += r.vertices;
+            std::printf("  %-9s seed %-10u %10zu vertices %9.1f ms  %s\n", PresetName(jobs[i].preset), jobs[i].seed,
+                r.vertices, b.ms, jobs[i].out.string().c_str());
+        }
+        else {
+            ++failed;
+            std::fprintf(stderr, "  %s seed %u failed: %s\n", PresetName(jobs[i].preset), jobs[i].seed, r.error.c_str());
+        }
+    }
+
+    const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::printf("Wrote %zu of %zu trees (%zu vertices) in %.2f s\n", jobs.size() - failed, jobs.size(), totalVerts, s);
+    return failed ? 1 : 0;
+}
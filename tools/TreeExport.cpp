@@ -0,0 +1,167 @@
+//TreeExport.cpp
+#include "TreeExport.h"
+
+#include <system_error>
+#include <vector>
+
+#include "Hill.h"
+#include "MeshExport.h"
+#include "TreeMesh.h"
+
+namespace fs = std::filesystem;
+
+const char* PresetName(TreePreset preset)
+{
+    return preset == TreePreset::Conifer ? "conifer" : "deciduous";
+}
+
+bool ParsePresetName(const std::string& name, TreePreset& out)
+{
+    if (name == "deciduous") out = TreePreset::Deciduous;
+    else if (name == "conifer") out = TreePreset::Conifer;
+    else return false;
+    return true;
+}
+
+fs::path FindAssetsRoot()
+{
+    std::error_code ec;
+    fs::path p = fs::current_path(ec);
+    for (int i = 0; i < 10 && !p.empty(); ++i) {
+        if (fs::exists(p / "assets" / "textures", ec)) return p;
+        if (!p.has_parent_path() || p.parent_path() == p) break;
+        p = p.parent_path();
+    }
+    return fs::path();
+}
+
+// No half-written meshes left behind for a pipeline to pick up
+static TreeExportResult Finish(TreeExportResult r, bool closed, const fs::path& out)
+{
+    if (!closed && r.error.empty()) r.error = "write failed: " + out.string();
+    if (!r.error.empty()) {
+        std::error_code ec;
+        fs::remove(out, ec);
+        return r;
+    }
+    r.ok = true;
+    return r;
+}
+
+// ---------------------------
+// OBJ
+// ---------------------------
+TreeExportResult ExportTreeObj(const fs::path& out, const TreeParams& p, TreeSentenceCache* sentences, TreeBuildInfo* info)
+{
+    TreeExportResult r;
+    ObjStreamWriter obj;
+    const std::string header = std::string("L-system tree: ") + PresetName(p.preset)
+        + ", seed " + std::to_string(p.seed) + ", " + std::to_string(p.iterations) + " iterations";
+    if (!obj.open(out.string(), header)) {
+        r.error = "cannot create " + out.string();
+        return r;
+    }
+
+    try {
+        r.vertices = BuildTreeVerticesStreamed(p, kTreeChunkVerts,
+            [&](const VertexPN* v, std::size_t n) { obj.append(v, n); }, nullptr, info, sentences);
+    }
+    catch (const std::exception& e) {
+        r.error = e.what();
+    }
+    return Finish(r, obj.close(), out);
+}
+
+// ---------------------------
+// GLB
+// ---------------------------
+static GlbMaterial BarkMaterial(TreePreset preset, const fs::path& glb, const fs::path& assets)
+{
+    GlbMaterial m;
+    m.name = std::string(PresetName(preset)) + "_bark";
+    m.roughness = 1.0f; // scales the roughness map
+    if (!assets.empty()) {
+        const BarkTextureFiles bark = PresetBarkTextures(preset);
+        const fs::path tex = assets / "assets" / "textures";
+        m.baseColorUri = GlbTextureUri(glb.string(), (tex / bark.albedo).string());
+        m.normalUri = GlbTextureUri(glb.string(), (tex / bark.normal).string());
+        m.roughnessUri = GlbTextureUri(glb.string(), (tex / bark.roughness).string());
+    }
+    else {
+        m.baseColor = glm::vec3(0.35f, 0.25f, 0.18f);
+        m.roughness = 0.9f;
+    }
+    return m;
+}
+
+// Ground sets as main.cpp loads them
+static GlbMaterial GroundMaterial(TreePreset preset, const fs::path& glb, const fs::path& assets)
+{
+    GlbMaterial m;
+    m.name = std::string(PresetName(preset)) + "_ground";
+    if (!assets.empty()) {
+        const bool conifer = preset == TreePreset::Conifer;
+        const fs::path set = assets / "assets" / "ground" / (conifer ? "conifer" : "deciduous");
+        const std::string stem = conifer ? "forrest_ground_01" : "red_laterite_soil_stones";
+        m.baseColorUri = GlbTextureUri(glb.string(), (set / (stem + "_diff_1k.png")).string());
+        m.normalUri = GlbTextureUri(glb.string(), (set / (stem + "_nor_gl_1k.png")).string());
+        m.roughnessUri = GlbTextureUri(glb.string(), (set / (stem + "_rough_1k.png")).string());
+    }
+    else {
+        m.baseColor = glm::vec3(0.30f, 0.28f, 0.20f);
+    }
+    return m;
+}
+
+// Streamed like OBJ; the optional hill is small enough to build in one piece
+TreeExportResult ExportTreeGlb(const fs::path& out, const TreeParams& p, const GlbExportOptions& opt,
+    TreeSentenceCache* sentences, TreeBuildInfo* info)
+{
+    TreeExportResult r;
+    GlbStreamWriter glb;
+    if (!glb.open(out.string())) {
+        r.error = "cannot create " + out.string();
+        return r;
+    }
+
+    try {
+        glb.beginMesh("tree", BarkMaterial(p.preset, out, opt.assets));
+        r.vertices = BuildTreeVerticesStreamed(p, kTreeChunkVerts,
+            [&](const VertexPN* v, std::size_t n) { glb.appendTriangles(v, n); }, nullptr, info, sentences);
+
+        if (opt.hill) {
+            // Hill constants of main.cpp; one thread, the callers run several exports at once
+            const float uvWorld = (p.preset == TreePreset::Conifer) ? 12.0f : 14.0f;
+            const HillMesh hill = BuildHillMesh(p.baseTranslation.y - 0.20f, 100.0f, 240, uvWorld, uvWorld,
+                HillKernel::Simd, 1);
+            glb.beginMesh("hill", GroundMaterial(p.preset, out, opt.assets));
+            glb.appendIndexed(hill.vertices.data(), hill.vertices.size(), hill.indices.data(), hill.indices.size());
+        }
+        glb.endMesh();
+    }
+    catch (const std::exception& e) {
+        r.error = e.what();
+    }
+    return Finish(r, glb.close(), out);
+}
+
+// ---------------------------
+// .treemesh
+// ---------------------------
+TreeExportResult ExportTreeMesh(const fs::path& out, const TreeParams& p, TreeSentenceCache* sentences, TreeBuildInfo* info)
+{
+    TreeExportResult r;
+    try {
+        const std::vector<VertexPN> verts = BuildTreeVertices(p, info, sentences);
+        std::vector<VertexPN> welded;
+        std::vector<std::uint32_t> indices;
+        WeldTreeVertices(verts.data(), verts.size(), welded, indices);
+        r.vertices = verts.size();
+        r.ok = WriteTreeMesh(out, HashTreeParams(p), welded.data(), welded.size(), indices.data(), indices.size());
+        if (!r.ok) r.error = "write failed: " + out.string();
+    }
+    catch (const std::exception& e) {
+        r.error = e.what();
+    }
+    return r;
+}
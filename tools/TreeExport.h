@@ -0,0 +1,41 @@
+//TreeExport.h
+#pragma once
+#include <filesystem>
+#include <string>
+
+#include "TreeGen.h"
+
+// ---------------------------
+// Tree -> file jobs shared by the headless tools (tree-batch, tree-server)
+// Each builds the tree of `p` and writes one file. On failure the partial file is removed
+// and `error` says why; build exceptions (bad_alloc, ...) are caught and reported the same way.
+// `sentences` and `info` are passed on to the builder (both optional).
+// ---------------------------
+struct TreeExportResult {
+    bool ok = false;
+    std::string error;
+    std::size_t vertices = 0; // as built (before any welding)
+};
+
+struct GlbExportOptions {
+    std::filesystem::path assets; // project root holding assets/, empty = untextured
+    bool hill = false;            // add the preset's hill as a second mesh
+};
+
+const char* PresetName(TreePreset preset); // "deciduous" / "conifer"
+bool ParsePresetName(const std::string& name, TreePreset& out);
+
+// Same search as the app: walk up from the working directory until there is an assets/textures.
+// Empty if there is none.
+std::filesystem::path FindAssetsRoot();
+
+// Streamed: memory stays at a few chunks whatever the tree size
+TreeExportResult ExportTreeObj(const std::filesystem::path& out, const TreeParams& p,
+    TreeSentenceCache* sentences = nullptr, TreeBuildInfo* info = nullptr);
+
+TreeExportResult ExportTreeGlb(const std::filesystem::path& out, const TreeParams& p, const GlbExportOptions& opt,
+    TreeSentenceCache* sentences = nullptr, TreeBuildInfo* info = nullptr);
+
+// Whole tree in memory, welded, one sequential write
+TreeExportResult ExportTreeMesh(const std::filesystem::path& out, const TreeParams& p,
+    TreeSentenceCache* sentences = nullptr, TreeBuildInfo* info = nullptr);
@@ -0,0 +1,804 @@
+//TreeServer.cpp
+// Long-running tree generator for tools that ask for trees many times a minute.
+// Reads one JSON request per line from stdin (default) or from clients of a Unix socket,
+// runs them in parallel on a worker pool and answers each with one JSON line, in the
+// order they finish (match them by "id"). What stays warm between requests:
+//   - worker threads and the heap they have grown
+//   - derived L-system sentences (TreeSentenceCache): a request that only changes
+//     shape parameters, or repeats a tree, skips rewriting
+//   - encoded .treemesh files of recent trees (by HashTreeParams): a repeat is a memcpy
+//   - the assets root for .glb texture URIs, looked up once at startup
+//
+// Usage: tree-server [--socket path] [-j threads] [--sentence-cache-mb N] [--mesh-cache-mb N] [--assets dir]
+//
+// Request (every key optional):
+//   {"id": 7, "preset": "conifer", "seed": 42, "iterations": 12,
+//    "output": "stats" | "treemesh" | "obj" | "glb", "path": "out/pine.glb", "hill": false,
+//    "overrides": {"branchAngleDeg": 30, "enableTropism": true, "radialSegments": 8}}
+//   The preset's tuning is applied first, then iterations / seed, then overrides
+//   (any scalar TreeParams field, by its name). seed is a uint32; iterations go up to
+//   kMaxIterations; int overrides must be whole numbers within the field's range (see
+//   kParamFields). Anything out of range is an error response, never clamped. obj / glb need a "path". A treemesh
+//   without a "path" comes back inline: the response line has "bytes": N and is followed
+//   by exactly N bytes of .treemesh file (header + welded vertices + indices).
+//   {"op": "status"} reports the caches; {"op": "quit"} stops a stdin server
+//   after the requests already read have been answered.
+//
+// Response: {"id": 7, "ok": true, "vertices": ..., "ms": ..., "derive_ms": ..., "cache": "sentence", ...}
+//           (derive_ms / interpret_ms / mesh_ms only when built with the stats timers)
+//           {"id": 7, "ok": false, "error": "..."}
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "ThreadPool.h"
+#include "TreeExport.h"
+#include "TreeGen.h"
+#include "TreeMesh.h"
+
+namespace fs = std::filesystem;
+
+// ---------------------------
+// Request parsing
+// Just enough JSON for one request object per line: strings, numbers, true/false/null
+// and the one nested "overrides" object. Arrays are rejected.
+// ---------------------------
+class JsonReader {
+public:
+    explicit JsonReader(const std::string& s) : m_s(s) {}
+
+    // Calls fn(key) with the reader on the value; fn must consume it
+    bool object(const std::function<bool(const std::string& key)>& fn)
+    {
+        ws();
+        if (!eat('{')) return false;
+        ws();
+        if (eat('}')) return true;
+        for (;;) {
+            std::string key;
+            ws();
+            if (!string(key)) return false;
+            ws();
+            if (!eat(':')) return false;
+            ws();
+            if (!fn(key)) return false;
+            ws();
+            if (eat('}')) return true;
+            if (!eat(',')) return false;
+        }
+    }
+
+    bool string(std::string& out)
+    {
+        out.clear();
+        if (!eat('"')) return false;
+        while (m_i < m_s.size()) {
+            const char c = m_s[m_i++];
+            if (c == '"') return true;
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (m_i >= m_s.size()) return false;
+            const char e = m_s[m_i++];
+            switch (e) {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'u': {
+                // BMP only, as UTF-8 (paths with surrogate pairs aren't worth the code)
+                if (m_i + 4 > m_s.size()) return false;
+                const unsigned cp = (unsigned)std::strtoul(m_s.substr(m_i, 4).c_str(), nullptr, 16);
+                m_i += 4;
+                if (cp < 0x80) out += (char)cp;
+                else if (cp < 0x800) {
+                    out += (char)(0xC0 | (cp >> 6));
+                    out += (char)(0x80 | (cp & 0x3F));
+                }
+                else {
+                    out += (char)(0xE0 | (cp >> 12));
+                    out += (char)(0x80 | ((cp >> 6) & 0x3F));
+                    out += (char)(0x80 | (cp & 0x3F));
+                }
+                break;
+            }
+            default: out += e; break; // \" \\ \/
+            }
+        }
+        return false;
+    }
+
+    // Numbers, with true / false accepted as 1 / 0 (for boolean overrides)
+    bool number(double& out)
+    {
+        if (literal("true")) {
+            out = 1.0;
+            return true;
+        }
+        if (literal("false")) {
+            out = 0.0;
+            return true;
+        }
+        const char* begin = m_s.c_str() + m_i;
+        char* end = nullptr;
+        out = std::strtod(begin, &end);
+        if (end == begin) return false;
+        m_i += (std::size_t)(end - begin);
+        return true;
+    }
+
+    bool boolean(bool& out)
+    {
+        double v = 0.0;
+        if (!number(v)) return false;
+        out = v != 0.0;
+        return true;
+    }
+
+    // A scalar exactly as written (quotes included), to echo back
+    bool raw(std::string& out)
+    {
+        const std::size_t start = m_i;
+        std::string ignored;
+        double n = 0.0;
+        if (!(m_i < m_s.size() && m_s[m_i] == '"' ? string(ignored) : (literal("null") || number(n)))) return false;
+        out = m_s.substr(start, m_i - start);
+        return true;
+    }
+
+    bool atEnd()
+    {
+        ws();
+        return m_i == m_s.size();
+    }
+
+private:
+    void ws()
+    {
+        while (m_i < m_s.size() && (m_s[m_i] == ' ' || m_s[m_i] == '\t' || m_s[m_i] == '\r' || m_s[m_i] == '\n')) ++m_i;
+    }
+
+    bool eat(char c)
+    {
+        if (m_i >= m_s.size() || m_s[m_i] != c) return false;
+        ++m_i;
+        return true;
+    }
+
+    bool literal(const char* word)
+    {
+        const std::size_t n = std::strlen(word);
+        if (m_s.compare(m_i, n, word) != 0) return false;
+        m_i += n;
+        return true;
+    }
+
+    const std::string& m_s;
+    std::size_t m_i = 0;
+};
+
+static std::string JsonString(const std::string& s)
+{
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        if ((unsigned char)c < 0x20) continue;
+        out += c;
+    }
+    return out + "\"";
+}
+
+enum class ServerOutput { Stats, TreeMesh, Obj, Glb };
+
+// Deciduous at 16 peaks around 1.2 GB and roughly doubles per iteration; anything
+// deeper is a request to take the server down, not a tree
+constexpr int kMaxIterations = 16;
+
+struct ServerRequest {
+    std::string id = "null"; // raw JSON, echoed back
+    std::string op;          // "" = build, "status", "quit"
+    TreeParams params;
+    ServerOutput output = ServerOutput::Stats;
+    fs::path path;
+    bool hill = false;
+};
+
+// Every scalar TreeParams field, by name (what "overrides" can set)
+struct ParamField {
+    const char* name;
+    float TreeParams::* f;
+    int TreeParams::* i;
+    bool TreeParams::* b;
+    int minI = 0;           // accepted range of an int field; anything else is an error
+    int maxI = 1 << 20;
+};
+
+static const ParamField kParamFields[] = {
+    { "baseRadius", &TreeParams::baseRadius, nullptr, nullptr },
+    { "baseLength", &TreeParams::baseLength, nullptr, nullptr },
+    { "radiusDecayF", &TreeParams::radiusDecayF, nullptr, nullptr },
+    { "lengthDecayF", &TreeParams::lengthDecayF, nullptr, nullptr },
+    { "branchRadiusDecay", &TreeParams::branchRadiusDecay, nullptr, nullptr },
+    { "branchAngleDeg", &TreeParams::branchAngleDeg, nullptr, nullptr },
+    { "radialSegments", nullptr, &TreeParams::radialSegments, nullptr, 3, 64 },
+    { "addSpheres", nullptr, nullptr, &TreeParams::addSpheres },
+    { "sphereLatSegments", nullptr, &TreeParams::sphereLatSegments, nullptr, 1, 32 },
+    { "sphereLonSegments", nullptr, &TreeParams::sphereLonSegments, nullptr, 1, 32 },
+    { "angleJitterDeg", &TreeParams::angleJitterDeg, nullptr, nullptr },
+    { "lengthJitterFrac", &TreeParams::lengthJitterFrac, nullptr, nullptr },
+    { "radiusJitterFrac", &TreeParams::radiusJitterFrac, nullptr, nullptr },
+    { "usePhyllotaxisRoll", nullptr, nullptr, &TreeParams::usePhyllotaxisRoll },
+    { "phyllotaxisDeg", &TreeParams::phyllotaxisDeg, nullptr, nullptr },
+    { "branchRollJitterDeg", &TreeParams::branchRollJitterDeg, nullptr, nullptr },
+    { "minRadius", &TreeParams::minRadius, nullptr, nullptr },
+    { "minLength", &TreeParams::minLength, nullptr, nullptr },
+    { "enableBranchSkipping", nullptr, nullptr, &TreeParams::enableBranchSkipping },
+    { "branchSkipStartDepth", nullptr, &TreeParams::branchSkipStartDepth, nullptr },
+    { "branchSkipMaxProb", &TreeParams::branchSkipMaxProb, nullptr, nullptr },
+    { "minRadiusForBranch", &TreeParams::minRadiusForBranch, nullptr, nullptr },
+    { "minBranchSpacing", nullptr, &TreeParams::minBranchSpacing, nullptr },
+    { "maxBranchesPerNode", nullptr, &TreeParams::maxBranchesPerNode, nullptr },
+    { "depthFullEffect", nullptr, &TreeParams::depthFullEffect, nullptr },
+    { "branchPitchMinDeg", &TreeParams::branchPitchMinDeg, nullptr, nullptr },
+    { "branchPitchMaxDeg", &TreeParams::branchPitchMaxDeg, nullptr, nullptr },
+    { "enableTropism", nullptr, nullptr, &TreeParams::enableTropism },
+    { "tropismStrength", &TreeParams::tropismStrength, nullptr, nullptr },
+    { "tropismThinBoost", &TreeParams::tropismThinBoost, nullptr, nullptr },
+    { "branchLengthDecay", &TreeParams::branchLengthDecay, nullptr, nullptr },
+    { "twigLengthBoost", &TreeParams::twigLengthBoost, nullptr, nullptr },
+    { "maxLenToRadius", &TreeParams::maxLenToRadius, nullptr, nullptr },
+    { "enableRadiusPruning", nullptr, nullptr, &TreeParams::enableRadiusPruning },
+    { "pruneRadius", &TreeParams::pruneRadius, nullptr, nullptr },
+    { "enableCrookedness", nullptr, nullptr, &TreeParams::enableCrookedness },
+    { "crookStrength", &TreeParams::crookStrength, nullptr, nullptr },
+    { "crookAccelDeg", &TreeParams::crookAccelDeg, nullptr, nullptr },
+    { "crookDamping", &TreeParams::crookDamping, nullptr, nullptr },
+    { "enableTrunkTaperCurve", nullptr, nullptr, &TreeParams::enableTrunkTaperCurve },
+    { "trunkTaperPower", &TreeParams::trunkTaperPower, nullptr, nullptr },
+    { "trunkTaperTopMult", &TreeParams::trunkTaperTopMult, nullptr, nullptr },
+    { "barkRepeatWorldU", &TreeParams::barkRepeatWorldU, nullptr, nullptr },
+    { "barkRepeatWorldV", &TreeParams::barkRepeatWorldV, nullptr, nullptr },
+    { "resetBarkVOnBranch", nullptr, nullptr, &TreeParams::resetBarkVOnBranch },
+    { "enableScaffoldTaperCurve", nullptr, nullptr, &TreeParams::enableScaffoldTaperCurve },
+};
+
+static bool IsIntegerIn(double v, double lo, double hi)
+{
+    return v >= lo && v <= hi && v == std::floor(v);
+}
+
+static bool ApplyOverride(TreeParams& p, const std::string& name, double v, std::string& error)
+{
+    for (const ParamField& field : kParamFields) {
+        if (name != field.name) continue;
+        if (field.f) p.*field.f = (float)v;
+        else if (field.i) {
+            if (!IsIntegerIn(v, field.minI, field.maxI)) {
+                error = name + " must be an integer in [" + std::to_string(field.minI) + ", "
+                    + std::to_string(field.maxI) + "]";
+                return false;
+            }
+            p.*field.i = (int)v;
+        }
+        else p.*field.b = v != 0.0;
+        return true;
+    }
+    error = "unknown override " + JsonString(name);
+    return false;
+}
+
+static bool ParseRequest(const std::string& line, ServerRequest& req, std::string& error)
+{
+    JsonReader r(line);
+    std::string preset = "deciduous", output = "stats", path;
+    double seed = 2025.0, iterations = 0.0;
+    std::vector<std::pair<std::string, double>> overrides;
+
+    const bool parsed = r.object([&](const std::string& key) {
+        if (key == "id") return r.raw(req.id);
+        if (key == "op") return r.string(req.op);
+        if (key == "preset") return r.string(preset);
+        if (key == "seed") return r.number(seed);
+        if (key == "iterations") return r.number(iterations);
+        if (key == "output") return r.string(output);
+        if (key == "path") return r.string(path);
+        if (key == "hill") return r.boolean(req.hill);
+        if (key == "overrides") {
+            return r.object([&](const std::string& name) {
+                double v = 0.0;
+                if (!r.number(v)) return false;
+                overrides.push_back({ name, v });
+                return true;
+            });
+        }
+        error = "unknown key " + JsonString(key);
+        return false;
+    }) && r.atEnd();
+    if (!parsed) {
+        if (error.empty()) error = "malformed request";
+        return false;
+    }
+
+    if (!req.op.empty()) {
+        if (req.op == "status" || req.op == "quit") return true;
+        error = "unknown op " + JsonString(req.op);
+        return false;
+    }
+
+    TreeParams& p = req.params;
+    if (!ParsePresetName(preset, p.preset)) {
+        error = "unknown preset " + JsonString(preset);
+        return false;
+    }
+    ApplyTreePreset(p);
+    if (!IsIntegerIn(iterations, 0.0, kMaxIterations)) {
+        error = "iterations must be an integer in [0, " + std::to_string(kMaxIterations) + "] (0: the preset's)";
+        return false;
+    }
+    if (iterations > 0.0) p.iterations = (int)iterations;
+    if (!IsIntegerIn(seed, 0.0, 4294967295.0)) {
+        error = "seed must be an integer in [0, 4294967295]";
+        return false;
+    }
+    p.seed = (std::uint32_t)seed;
+    for (const auto& o : overrides) {
+        if (!ApplyOverride(p, o.first, o.second, error)) return false;
+    }
+
+    if (output == "stats") req.output = ServerOutput::Stats;
+    else if (output == "treemesh") req.output = ServerOutput::TreeMesh;
+    else if (output == "obj") req.output = ServerOutput::Obj;
+    else if (output == "glb") req.output = ServerOutput::Glb;
+    else {
+        error = "unknown output " + JsonString(output);
+        return false;
+    }
+    req.path = path;
+    if (req.path.empty() && (req.output == ServerOutput::Obj || req.output == ServerOutput::Glb)) {
+        error = output + " needs a \"path\"";
+        return false;
+    }
+    return true;
+}
+
+// ---------------------------
+// Mesh cache
+// Encoded .treemesh files of recent trees by HashTreeParams. Least recently used ones
+// are dropped past maxBytes; callers keep theirs alive through the shared_ptr.
+// ---------------------------
+class MeshCache {
+public:
+    using Bytes = std::shared_ptr<const std::vector<unsigned char>>;
+
+    explicit MeshCache(std::size_t maxBytes) : m_maxBytes(maxBytes) {}
+
+    Bytes find(std::uint64_t key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_lru.begin(); it != m_lru.end(); ++it) {
+            if (it->first != key) continue;
+            m_lru.splice(m_lru.begin(), m_lru, it);
+            ++m_hits;
+            return m_lru.front().second;
+        }
+        ++m_misses;
+        return nullptr;
+    }
+
+    void insert(std::uint64_t key, Bytes bytes)
+    {
+        if (bytes->size() > m_maxBytes) return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& e : m_lru) {
+            if (e.first == key) return;
+        }
+        m_bytes += bytes->size();
+        m_lru.push_front({ key, std::move(bytes) });
+        while (m_bytes > m_maxBytes) {
+            m_bytes -= m_lru.back().second->size();
+            m_lru.pop_back();
+        }
+    }
+
+    std::string statusJson()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::ostringstream js;
+        js << "{\"entries\": " << m_lru.size() << ", \"bytes\": " << m_bytes
+            << ", \"hits\": " << m_hits << ", \"misses\": " << m_misses << "}";
+        return js.str();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::list<std::pair<std::uint64_t, Bytes>> m_lru; // front = most recently used
+    std::size_t m_bytes = 0;
+    std::size_t m_maxBytes;
+    std::size_t m_hits = 0;
+    std::size_t m_misses = 0;
+};
+
+// ---------------------------
+// Responses
+// One per client. A response line and its payload go out under the lock, so answers
+// of requests finishing at the same time never interleave.
+// ---------------------------
+struct ResponseSink {
+    std::mutex mutex;
+    std::FILE* file = nullptr; // stdin mode: stdout
+    int fd = -1;               // socket mode: the client
+    bool broken = false;       // client gone: stop writing
+
+    ~ResponseSink()
+    {
+#ifndef _WIN32
+        if (fd >= 0) ::close(fd);
+#endif
+    }
+};
+
+static bool WriteAll(ResponseSink& sink, const void* data, std::size_t n)
+{
+    if (sink.file) return std::fwrite(data, 1, n, sink.file) == n;
+#ifndef _WIN32
+    const char* p = static_cast<const char*>(data);
+    while (n > 0) {
+        const ssize_t w = ::send(sink.fd, p, n, MSG_NOSIGNAL);
+        if (w <= 0) return false;
+        p += w;
+        n -= (std::size_t)w;
+    }
+#endif
+    return true;
+}
+
+static void Send(ResponseSink& sink, const std::string& line, const unsigned char* payload = nullptr, std::size_t bytes = 0)
+{
+    std::lock_guard<std::mutex> lock(sink.mutex);
+    if (sink.broken) return;
+    const std::string text = line + "\n";
+    bool ok = WriteAll(sink, text.data(), text.size());
+    if (ok && bytes) ok = WriteAll(sink, payload, bytes);
+    if (ok && sink.file) ok = std::fflush(sink.file) == 0;
+    if (!ok) sink.broken = true;
+}
+
+// ---------------------------
+// Serving
+// ---------------------------
+struct Server {
+    explicit Server(unsigned threads, std::size_t sentenceBytes, std::size_t meshBytes)
+        : sentences(sentenceBytes), meshes(meshBytes), pool(threads)
+    {
+    }
+
+    TreeSentenceCache sentences;
+    MeshCache meshes;
+    GlbExportOptions glb;
+    std::atomic<std::size_t> served{ 0 };
+    ThreadPool pool; // last: its destructor finishes queued requests while the caches still exist
+};
+
+static bool WriteFileAtomic(const fs::path& path, const std::vector<unsigned char>& bytes)
+{
+    fs::path tmpPath = path;
+    tmpPath += ".tmp";
+    std::error_code ec;
+    {
+        std::ofstream f(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!f) return false;
+        f.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+        if (!f) {
+            f.close();
+            fs::remove(tmpPath, ec);
+            return false;
+        }
+    }
+    fs::remove(path, ec); // rename() won't replace an existing file on Windows
+    fs::rename(tmpPath, path, ec);
+    if (ec) fs::remove(tmpPath, ec);
+    return !ec;
+}
+
+static void AppendBuildInfo(std::ostringstream& js, const TreeBuildInfo& info)
+{
+    js << ", \"sentence_length\": " << info.sentenceLength << ", \"segments\": " << info.segments;
+    if (kStats) {
+        // Phase times are 0 with the timers compiled out: leave them out rather than lie
+        js << ", \"derive_ms\": " << info.rewriteMs << ", \"interpret_ms\": " << info.interpretMs
+            << ", \"mesh_ms\": " << info.meshMs;
+    }
+    js << ", \"cache\": \"" << (info.sentenceCached ? "sentence" : "none") << "\"";
+}
+
+static void Serve(Server& server, const ServerRequest& req, ResponseSink& sink)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    auto elapsedMs = [&]() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    };
+
+    std::ostringstream js;
+    js.precision(4);
+    js << std::fixed << "{\"id\": " << req.id;
+
+    const TreeParams& p = req.params;
+    TreeBuildInfo info;
+    std::string error;
+    MeshCache::Bytes payload;
+
+    try {
+        if (req.output == ServerOutput::Stats) {
+            const std::size_t n = BuildTreeVerticesStreamed(p, kTreeChunkVerts, [](const VertexPN*, std::size_t) {},
+                nullptr, &info, &server.sentences);
+            js << ", \"ok\": true, \"vertices\": " << n;
+            AppendBuildInfo(js, info);
+        }
+        else if (req.output == ServerOutput::TreeMesh) {
+            const std::uint64_t key = HashTreeParams(p);
+            MeshCache::Bytes bytes = server.meshes.find(key);
+            const bool hit = bytes != nullptr;
+            if (!hit) {
+                std::vector<VertexPN> welded;
+                std::vector<std::uint32_t> indices;
+                {
+                    const std::vector<VertexPN> verts = BuildTreeVertices(p, &info, &server.sentences);
+                    WeldTreeVertices(verts.data(), verts.size(), welded, indices);
+                }
+                auto encoded = std::make_shared<std::vector<unsigned char>>();
+                EncodeTreeMesh(key, welded.data(), welded.size(), indices.data(), indices.size(), *encoded);
+                server.meshes.insert(key, encoded);
+                bytes = std::move(encoded);
+            }
+
+            const TreeMeshHeader* hdr = reinterpret_cast<const TreeMeshHeader*>(bytes->data());
+            if (!req.path.empty() && !WriteFileAtomic(req.path, *bytes)) {
+                error = "write failed: " + req.path.string();
+            }
+            else {
+                js << ", \"ok\": true, \"vertices\": " << hdr->vertexCount << ", \"indices\": " << hdr->indexCount;
+                if (hit) js << ", \"cache\": \"mesh\"";
+                else AppendBuildInfo(js, info);
+                if (req.path.empty()) {
+                    js << ", \"bytes\": " << bytes->size();
+                    payload = bytes;
+                }
+                else js << ", \"path\": " << JsonString(req.path.generic_string());
+            }
+        }
+        else {
+            GlbExportOptions glb = server.glb;
+            glb.hill = req.hill;
+            const TreeExportResult r = (req.output == ServerOutput::Glb)
+                ? ExportTreeGlb(req.path, p, glb, &server.sentences, &info)
+                : ExportTreeObj(req.path, p, &server.sentences, &info);
+            if (!r.ok) error = r.error;
+            else {
+                js << ", \"ok\": true, \"vertices\": " << r.vertices << ", \"path\": " << JsonString(req.path.generic_string());
+                AppendBuildInfo(js, info);
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        error = e.what(); // bad_alloc on an oversized tree: that request fails, the server stays up
+    }
+
+    if (!error.empty()) {
+        Send(sink, "{\"id\": " + req.id + ", \"ok\": false, \"error\": " + JsonString(error) + "}");
+        return;
+    }
+    js << ", \"ms\": " << elapsedMs() << "}";
+    ++server.served;
+    if (payload) Send(sink, js.str(), payload->data(), payload->size());
+    else Send(sink, js.str());
+}
+
+static std::string StatusJson(Server& server, const std::string& id)
+{
+    std::ostringstream js;
+    js << "{\"id\": " << id << ", \"ok\": true, \"workers\": " << server.pool.size()
+        << ", \"served\": " << server.served.load()
+        << ", \"sentence_cache\": {\"bytes\": " << server.sentences.bytes() << ", \"hits\": " << server.sentences.hits()
+        << ", \"misses\": " << server.sentences.misses() << "}"
+        << ", \"mesh_cache\": " << server.meshes.statusJson() << "}";
+    return js.str();
+}
+
+// Parses one line and queues it; answers parse errors and ops right away.
+// False once a "quit" has been read.
+static bool Dispatch(Server& server, const std::string& line, const std::shared_ptr<ResponseSink>& sink)
+{
+    if (line.find_first_not_of(" \t\r") == std::string::npos) return true;
+
+    auto req = std::make_shared<ServerRequest>();
+    std::string error;
+    if (!ParseRequest(line, *req, error)) {
+        Send(*sink, "{\"id\": " + req->id + ", \"ok\": false, \"error\": " + JsonString(error) + "}");
+        return true;
+    }
+    if (req->op == "status") {
+        Send(*sink, StatusJson(server, req->id));
+        return true;
+    }
+    if (req->op == "quit") return false;
+
+    // The task owns the sink too: a client may hang up before its trees are done
+    server.pool.submit([&server, req, sink]() { Serve(server, *req, *sink); });
+    return true;
+}
+
+// ---------------------------
+// Unix socket
+// ---------------------------
+#ifndef _WIN32
+static std::atomic<bool> gStop{ false };
+
+static void OnSignal(int)
+{
+    gStop = true;
+}
+
+// One thread per client: reads its lines, the pool does the work
+static void ClientLoop(Server& server, std::shared_ptr<ResponseSink> sink, std::atomic<bool>& done)
+{
+    std::string pending;
+    char buf[4096];
+    for (;;) {
+        const ssize_t n = ::recv(sink->fd, buf, sizeof(buf), 0);
+        if (n <= 0) break;
+        pending.append(buf, (std::size_t)n);
+        std::size_t start = 0;
+        for (std::size_t nl; (nl = pending.find('\n', start)) != std::string::npos; start = nl + 1)
+            Dispatch(server, pending.substr(start, nl - start), sink); // "quit" only stops stdin servers
+        pending.erase(0, start);
+    }
+    done = true;
+}
+
+// RunSocket's handle on a client thread. Holding the sink keeps the fd open (and its
+// number from being reused) until the thread is joined, so shutdown() hits the right socket.
+struct SocketClient {
+    std::thread thread;
+    std::shared_ptr<ResponseSink> sink;
+    std::unique_ptr<std::atomic<bool>> done;
+};
+
+static int RunSocket(Server& server, const std::string& path)
+{
+    const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (listener < 0 || path.size() >= sizeof(addr.sun_path)) {
+        std::fprintf(stderr, "Cannot create socket %s\n", path.c_str());
+        return 2;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    ::unlink(path.c_str()); // left over from a server that was killed
+    if (::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(listener, 16) != 0) {
+        std::fprintf(stderr, "Cannot listen on %s: %s\n", path.c_str(), std::strerror(errno));
+        ::close(listener);
+        return 2;
+    }
+
+    // No SA_RESTART: SIGINT / SIGTERM have to break accept() out of its wait
+    struct sigaction sa {};
+    sa.sa_handler = OnSignal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::fprintf(stderr, "tree-server: listening on %s with %u workers\n", path.c_str(), server.pool.size());
+    std::vector<SocketClient> clients;
+    while (!gStop) {
+        const int fd = ::accept(listener, nullptr, nullptr);
+        if (fd < 0) continue; // EINTR from a signal, or a client that gave up
+
+        // Reap clients that hung up (the fd closes with the last queued request's sink)
+        for (std::size_t i = 0; i < clients.size();) {
+            if (*clients[i].done) {
+                clients[i].thread.join();
+                clients.erase(clients.begin() + (std::ptrdiff_t)i);
+            }
+            else {
+                ++i;
+            }
+        }
+
+        SocketClient c;
+        c.sink = std::make_shared<ResponseSink>();
+        c.sink->fd = fd;
+        c.done = std::make_unique<std::atomic<bool>>(false);
+        c.thread = std::thread(ClientLoop, std::ref(server), c.sink, std::ref(*c.done));
+        clients.push_back(std::move(c));
+    }
+
+    // Nothing may call into the server once main() starts tearing it down: end every
+    // client's reads (their recv() returns 0) and wait for the threads. Queued requests
+    // still finish in the pool's destructor and answer on the write side.
+    for (SocketClient& c : clients) ::shutdown(c.sink->fd, SHUT_RD);
+    for (SocketClient& c : clients) c.thread.join();
+    clients.clear();
+
+    ::close(listener);
+    ::unlink(path.c_str());
+    return 0;
+}
+#endif
+
+int main(int argc, char** argv)
+{
+    std::string socketPath;
+    unsigned threads = 0;
+    std::size_t sentenceMb = 256, meshMb = 512;
+    fs::path assets;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--socket" && hasValue) socketPath = argv[++i];
+        else if (arg == "-j" && hasValue) threads = (unsigned)std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--sentence-cache-mb" && hasValue) sentenceMb = (std::size_t)std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--mesh-cache-mb" && hasValue) meshMb = (std::size_t)std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--assets" && hasValue) assets = argv[++i];
+        else {
+            std::fprintf(stderr, "Usage: tree-server [--socket path] [-j threads] [--sentence-cache-mb N] "
+                "[--mesh-cache-mb N] [--assets dir]\n");
+            return (arg == "-h" || arg == "--help") ? 0 : 2;
+        }
+    }
+
+    Server server(threads, sentenceMb << 20, meshMb << 20);
+    std::error_code ec;
+    server.glb.assets = assets.empty() ? FindAssetsRoot() : fs::absolute(assets, ec);
+
+    if (!socketPath.empty()) {
+#ifdef _WIN32
+        std::fprintf(stderr, "--socket needs a Unix socket; use stdin on Windows\n");
+        return 2;
+#else
+        return RunSocket(server, socketPath);
+#endif
+    }
+
+#ifdef _WIN32
+    _setmode(_fileno(stdout), _O_BINARY); // inline .treemesh payloads
+#endif
+    // stdout carries only responses: everything else goes to stderr
+    auto sink = std::make_shared<ResponseSink>();
+    sink->file = stdout;
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (!Dispatch(server, line, sink)) break;
+    }
+    return 0; // ~Server answers everything still queued
+}